@@ -69,5 +69,5 @@ echo "  Header: engine_pcm.h"
 echo ""
 echo "Next steps:"
 echo "  1. Review engine_loop.wav in an audio editor"
-echo "  2. Copy engine_pcm.h to firmware/boat_telemetry/"
+echo "  2. Copy engine_pcm.h to firmware/libraries/EngineAudio/src/ (ENGINE_PCM_EMBEDDED builds)"
 echo "  3. Build and flash firmware"
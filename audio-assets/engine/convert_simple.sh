@@ -1,11 +1,15 @@
 #!/bin/bash
 # Engine Audio Conversion - FFT circular filtering version
+# Usage: ./convert_simple.sh [rate_hz]   (44100 default; 22050 or 16000 for low-rate builds,
+#        set I2S_SAMPLE_RATE in the sketch to match)
 
 set -e
 
 SCRIPT_DIR="$(cd "$(dirname "${BASH_SOURCE[0]}")" && pwd)"
 cd "$SCRIPT_DIR"
 
+RATE="${1:-44100}"
+
 echo "=== Engine Audio Conversion (FFT Circular) ==="
 echo ""
 
@@ -15,17 +19,20 @@ if ! command -v ffmpeg &> /dev/null; then
     exit 1
 fi
 
-echo "[1/3] Converting engine.mp3 to raw WAV..."
+echo "[1/4] Converting engine.mp3 to raw WAV..."
 ffmpeg -y -i engine.mp3 -ac 1 -ar 44100 -c:a pcm_s16le engine_raw_temp.wav -y -loglevel warning
 
-echo "[2/3] Applying FFT-domain circular High-Pass Filter (80Hz for bass preservation)..."
+echo "[2/4] Applying FFT-domain circular High-Pass Filter (80Hz for bass preservation)..."
 # Using the new Python script for zero-phase circular filtering
-python3 make_engine_filtered_fft.py engine_raw_temp.wav engine_loop.wav
+python3 make_engine_filtered_fft.py engine_raw_temp.wav engine_loop.wav "$RATE"
 
-echo "[3/3] Generating C headers..."
+echo "[3/4] Generating C headers..."
 python3 generate_pcm_header.py engine_loop.wav engine_pcm.h
 python3 generate_pcm_header_raw.py engine_raw_temp.wav engine_pcm_raw.h
 
+echo "[4/4] Building engine sample bank (flash partition image)..."
+python3 make_engine_bank.py --rate "$RATE" -o engine_bank.bin engine=engine_loop.wav
+
 # Cleanup
 rm -f engine_raw_temp.wav
 
@@ -33,3 +40,5 @@ echo ""
 echo "=== Conversion Complete ==="
 echo "Filtered PCM: engine_pcm.h"
 echo "Raw PCM: engine_pcm_raw.h"
+echo "Sample bank: engine_bank.bin (flash to the 'engine' partition at 0x290000)"
+echo "Sample rate: $RATE Hz (I2S_SAMPLE_RATE must match)"
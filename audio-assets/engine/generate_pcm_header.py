@@ -1,14 +1,18 @@
 #!/usr/bin/env python3
 """
 Generate C header file with PCM audio data array from WAV file.
-Usage: python3 generate_pcm_header.py input.wav output.h
+Usage: python3 generate_pcm_header.py [--ulaw] input.wav output.h
+
+The sample rate is taken from the WAV (make_engine_filtered_fft.py ... 22050 for a
+low-rate build). --ulaw stores 8-bit mu-law instead of 16-bit PCM, half the flash.
 """
 
 import sys
 import wave
 import struct
+from make_engine_bank import ulaw_encode, FORMATS
 
-def generate_pcm_header(wav_path, header_path):
+def generate_pcm_header(wav_path, header_path, ulaw=False):
     """Convert WAV file to C header with PCM data array."""
     
     # Read WAV file
@@ -32,6 +36,9 @@ def generate_pcm_header(wav_path, header_path):
     
     # Convert bytes to int16 samples
     samples = struct.unpack(f'<{n_frames}h', raw_data)
+    fmt = "ulaw" if ulaw else "pcm16"
+    if ulaw:
+        samples = [ulaw_encode(s) for s in samples]
     
     # Generate C header
     with open(header_path, 'w') as f:
@@ -47,9 +54,10 @@ def generate_pcm_header(wav_path, header_path):
 #define ENGINE_PCM_SAMPLE_RATE {framerate}
 #define ENGINE_PCM_LENGTH {n_frames}
 #define ENGINE_PCM_DURATION_MS {int(n_frames / framerate * 1000)}
+#define ENGINE_PCM_FORMAT {FORMATS[fmt]}  // ENGINE_FORMAT_{fmt.upper()} (engine_bank.h)
 
-// PCM data array (16-bit signed, mono)
-const int16_t ENGINE_PCM_DATA[{n_frames}] = {{
+// PCM data array ({"8-bit mu-law" if ulaw else "16-bit signed"}, mono)
+const {"uint8_t" if ulaw else "int16_t"} ENGINE_PCM_DATA[{n_frames}] = {{
 """)
         
         # Write samples in rows of 12 for readability
@@ -69,15 +77,19 @@ const int16_t ENGINE_PCM_DATA[{n_frames}] = {{
     
     # Print summary
     duration_s = n_frames / framerate
-    size_kb = len(samples) * 2 / 1024
+    size_kb = len(samples) * (1 if ulaw else 2) / 1024
     print(f"  ✓ Generated {header_path}")
     print(f"    Sample rate: {framerate} Hz")
     print(f"    Samples: {n_frames} ({duration_s:.2f}s)")
-    print(f"    Size: {size_kb:.1f} KB")
+    print(f"    Size: {size_kb:.1f} KB ({fmt})")
 
 if __name__ == "__main__":
-    if len(sys.argv) != 3:
-        print("Usage: python3 generate_pcm_header.py input.wav output.h")
+    args = sys.argv[1:]
+    ulaw = "--ulaw" in args
+    if ulaw:
+        args.remove("--ulaw")
+    if len(args) != 2:
+        print("Usage: python3 generate_pcm_header.py [--ulaw] input.wav output.h")
         sys.exit(1)
     
-    generate_pcm_header(sys.argv[1], sys.argv[2])
+    generate_pcm_header(args[0], args[1], ulaw)
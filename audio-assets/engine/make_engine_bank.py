@@ -0,0 +1,136 @@
+#!/usr/bin/env python3
+"""
+Build the engine sample bank image for the ESP32 "engine" flash partition.
+Usage: python3 make_engine_bank.py [--format pcm16|ulaw] [--rate 44100|22050|16000] -o engine_bank.bin name=input.wav[@throttle|@oneshot] ...
+
+A sample given as name=input.wav@throttle (throttle 0.0-1.0) is an RPM layer: with two or
+more layers the firmware crossfades the two nearest the smoothed throttle (see
+make_engine_layers.py). Plain name=input.wav samples are loops; the one named "engine"
+is used when there are no layers. name=input.wav@oneshot marks an effect (horn, bell) that
+the firmware plays once over the engine, at the recorded pitch (so it must be at --rate,
+the sketch's I2S_SAMPLE_RATE). Loops and layers at another rate still play at the right
+pitch, resampled on the fly, so they only draw a warning.
+
+Layout must match firmware/libraries/EngineAudio/src/engine_bank.h:
+  header  (16 bytes): magic "EBNK", version, entry_count, total_size, reserved
+  entries (32 bytes each): name[16], offset, length, sample_rate, format, kind, throttle_pm
+  sample data, each block 4-byte aligned
+"""
+
+import argparse
+import struct
+import sys
+import wave
+
+BANK_MAGIC = 0x4B4E4245
+BANK_VERSION = 1
+MAX_ENTRIES = 16
+NAME_LEN = 16
+FORMATS = {"pcm16": 0, "ulaw": 1}
+KIND_LOOP = 0
+KIND_LAYER = 1
+KIND_ONESHOT = 2
+RATES = (44100, 22050, 16000)  # AUDIO_RATE_* in audio_engine.h; one-shots are not resampled
+PARTITION_SIZE = 0x140000   # "engine" partition in partitions.csv
+
+
+def ulaw_encode(sample):
+    """G.711 mu-law encode of one int16 sample."""
+    BIAS = 0x84
+    CLIP = 32635
+    sign = 0x80 if sample < 0 else 0
+    if sample < 0:
+        sample = -sample
+    sample = min(sample, CLIP) + BIAS
+    exponent = 7
+    mask = 0x4000
+    while exponent > 0 and not (sample & mask):
+        exponent -= 1
+        mask >>= 1
+    mantissa = (sample >> (exponent + 3)) & 0x0F
+    return ~(sign | (exponent << 4) | mantissa) & 0xFF
+
+
+def read_wav(path):
+    """Read a mono 16-bit WAV, returning (sample_rate, samples)."""
+    with wave.open(path, 'rb') as wav:
+        if wav.getnchannels() != 1:
+            sys.exit(f"ERROR: {path}: expected mono, got {wav.getnchannels()} channels")
+        if wav.getsampwidth() != 2:
+            sys.exit(f"ERROR: {path}: expected 16-bit, got {wav.getsampwidth() * 8}-bit")
+        n_frames = wav.getnframes()
+        samples = struct.unpack(f'<{n_frames}h', wav.readframes(n_frames))
+        return wav.getframerate(), samples
+
+
+def encode(samples, fmt):
+    if fmt == "ulaw":
+        return bytes(ulaw_encode(s) for s in samples)
+    return struct.pack(f'<{len(samples)}h', *samples)
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Build engine_bank.bin for the ESP32 engine partition")
+    parser.add_argument("-o", "--output", required=True, help="output bank image")
+    parser.add_argument("--format", choices=FORMATS.keys(), default="pcm16",
+                        help="sample encoding (ulaw halves the size)")
+    parser.add_argument("--rate", type=int, choices=RATES, default=RATES[0],
+                        help="output rate the firmware runs at (I2S_SAMPLE_RATE)")
+    parser.add_argument("samples", nargs="+", metavar="name=input.wav[@throttle|@oneshot]")
+    args = parser.parse_args()
+
+    if len(args.samples) > MAX_ENTRIES:
+        sys.exit(f"ERROR: at most {MAX_ENTRIES} samples per bank")
+
+    entries = []
+    for spec in args.samples:
+        if "=" not in spec:
+            sys.exit(f"ERROR: expected name=input.wav, got '{spec}'")
+        name, path = spec.split("=", 1)
+        if not 0 < len(name) < NAME_LEN:
+            sys.exit(f"ERROR: sample name '{name}' must be 1-{NAME_LEN - 1} characters")
+        kind, throttle = KIND_LOOP, 0.0
+        if "@" in path:
+            path, point = path.rsplit("@", 1)
+            if point == "oneshot":
+                kind = KIND_ONESHOT
+            else:
+                kind, throttle = KIND_LAYER, float(point)
+                if not 0.0 <= throttle <= 1.0:
+                    sys.exit(f"ERROR: layer '{name}' throttle {throttle} must be 0.0-1.0")
+        rate, samples = read_wav(path)
+        if kind == KIND_ONESHOT and rate != args.rate:
+            sys.exit(f"ERROR: one-shot '{name}' is {rate} Hz, must be {args.rate} Hz")
+        if rate != args.rate:
+            print(f"  WARNING: '{name}' is {rate} Hz, output is {args.rate} Hz (resampled on the board)")
+        entries.append((name, rate, len(samples), encode(samples, args.format), kind, throttle))
+
+    # Lay out sample data after the header and entry table
+    offset = 16 + 32 * len(entries)
+    table = b""
+    data = b""
+    for name, rate, length, payload, kind, throttle in entries:
+        pad = (-offset) % 4
+        data += b"\0" * pad
+        offset += pad
+        table += struct.pack('<16sIIIBBH', name.encode(), offset, length, rate,
+                             FORMATS[args.format], kind, round(throttle * 1000))
+        data += payload
+        offset += len(payload)
+
+    header = struct.pack('<IHHII', BANK_MAGIC, BANK_VERSION, len(entries), offset, 0)
+    image = header + table + data
+    if len(image) > PARTITION_SIZE:
+        sys.exit(f"ERROR: bank is {len(image)} bytes, partition holds {PARTITION_SIZE}")
+
+    with open(args.output, 'wb') as f:
+        f.write(image)
+
+    print(f"  ✓ Generated {args.output} ({len(image) / 1024:.1f} KB, {args.format}, for {args.rate} Hz output)")
+    for name, rate, length, payload, kind, throttle in entries:
+        layer = f", layer @ {throttle:.2f}" if kind == KIND_LAYER else (", one-shot" if kind == KIND_ONESHOT else "")
+        print(f"    {name}: {length} samples @ {rate} Hz ({length / rate:.2f}s, {len(payload) / 1024:.1f} KB{layer})")
+
+
+if __name__ == "__main__":
+    main()
@@ -5,13 +5,22 @@ import numpy as np
 from scipy.io import wavfile
 from scipy.fft import rfft, irfft, rfftfreq
 
+# Output rates the firmware runs at (AUDIO_RATE_* in audio_engine.h)
+RATES = (44100, 22050, 16000)
+# Fastest playback: RATE_MAX x REV_BOOST_RATE (audio_engine.h)
+MAX_PLAYBACK = 1.5 * 1.25
+
 def main():
     if len(sys.argv) < 3:
-        print("Usage: make_engine_filtered_fft.py <input_wav> <output_wav>")
+        print("Usage: make_engine_filtered_fft.py <input_wav> <output_wav> [rate_hz]")
         sys.exit(1)
 
     input_wav = sys.argv[1]
     output_wav = sys.argv[2]
+    out_sr = int(sys.argv[3]) if len(sys.argv) > 3 else None
+    if out_sr is not None and out_sr not in RATES:
+        print(f"rate_hz must be one of {', '.join(str(r) for r in RATES)}")
+        sys.exit(1)
 
     # 1. Read input WAV
     sr, data = wavfile.read(input_wav)
@@ -34,8 +43,18 @@ def main():
     H[1:] = 1.0 / np.sqrt(1 + (fc / freqs[1:])**(2*n))
     Y = X * H
     
-    # 6. Inverse FFT
-    y = irfft(Y, n=len(x))
+    # 6. Inverse FFT, resampling circularly when a lower output rate is asked for:
+    # keep the bins both lengths share (the loop stays periodic), after a low-pass that
+    # leaves room for pitching up to MAX_PLAYBACK without aliasing at the new rate
+    n_out = len(x)
+    if out_sr is not None and out_sr < sr:
+        fc_lp = out_sr / 2 / MAX_PLAYBACK
+        Y = Y / np.sqrt(1 + (freqs / fc_lp)**(2*n))
+        n_out = int(round(len(x) * out_sr / sr))
+        Y = Y[:n_out // 2 + 1]
+        print(f"  Resampling {sr} -> {out_sr} Hz (low-pass {fc_lp:.0f} Hz)")
+        sr = out_sr
+    y = irfft(Y, n=n_out)
     
     # 7. Apply tiny fade-in/out (3ms) to kill startup step
     fade_len = int(sr * 0.003)
@@ -58,6 +77,7 @@ def main():
     print(f"✓ Generated {output_wav}")
     print(f"  Boundary mismatch: {mismatch} counts")
     print(f"  Peak level: {np.max(np.abs(y))*100:.1f}%")
+    print(f"  Sample rate: {sr} Hz ({len(output_data)} samples)")
 
 if __name__ == "__main__":
     main()
@@ -0,0 +1,62 @@
+#!/usr/bin/env python3
+"""
+Derive RPM layers from a single engine loop for the multi-layer engine.
+Usage: python3 make_engine_layers.py <input_wav> <output_prefix> [num_layers]
+
+Layer i sits at throttle i/(num_layers-1) and is the loop pitched to the engine rate
+at that throttle (RATE_MIN..RATE_MAX in firmware/libraries/EngineAudio/src/audio_engine.h).
+Resampling is done in the FFT domain over the whole loop, so each layer is still
+periodic (click-free loop point) and pitching up band-limits instead of aliasing.
+The firmware then plays every layer near rate 1.0.
+
+Prints the make_engine_bank.py arguments for the generated layers.
+"""
+import sys
+import numpy as np
+from scipy.io import wavfile
+from scipy.fft import rfft, irfft
+
+# Must match audio_engine.h
+RATE_MIN = 0.8
+RATE_MAX = 1.5
+
+def main():
+    if len(sys.argv) < 3:
+        print("Usage: make_engine_layers.py <input_wav> <output_prefix> [num_layers]")
+        sys.exit(1)
+
+    input_wav = sys.argv[1]
+    prefix = sys.argv[2]
+    num_layers = int(sys.argv[3]) if len(sys.argv) > 3 else 4
+    if not 2 <= num_layers <= 4:
+        print("num_layers must be 2-4 (ENGINE_MAX_LAYERS)")
+        sys.exit(1)
+
+    sr, data = wavfile.read(input_wav)
+    x = data.astype(np.float64)
+    n = len(x)
+    X = rfft(x)
+
+    bank_args = []
+    for i in range(num_layers):
+        throttle = i / (num_layers - 1)
+        rate = RATE_MIN + throttle * (RATE_MAX - RATE_MIN)
+
+        # Circular resample to n / rate samples: keep the bins both lengths share
+        m = int(round(n / rate))
+        Y = np.zeros(m // 2 + 1, dtype=complex)
+        k = min(len(X), len(Y))
+        Y[:k] = X[:k]
+        y = irfft(Y, n=m) * (m / n)
+
+        output_wav = f"{prefix}_{i}.wav"
+        wavfile.write(output_wav, sr, np.clip(np.round(y), -32768, 32767).astype(np.int16))
+        bank_args.append(f"layer{i}={output_wav}@{throttle:.2f}")
+        print(f"✓ Generated {output_wav}: throttle {throttle:.2f}, rate {rate:.3f}, {m} samples")
+
+    print()
+    print("Bank arguments:")
+    print("  " + " ".join(bank_args))
+
+if __name__ == "__main__":
+    main()
@@ -97,7 +97,8 @@ export const DeviceScannerModal: React.FC<DeviceScannerModalProps> = ({
           
           setDevices(filtered);
         },
-        recentlyUsedIPs
+        recentlyUsedIPs,
+        deviceType
       );
       
       // Store controller so we can cancel scan later
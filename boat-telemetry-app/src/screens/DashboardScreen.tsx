@@ -21,6 +21,7 @@ import AsyncStorage from '@react-native-async-storage/async-storage';
 import * as Haptics from 'expo-haptics';
 import { activateKeepAwakeAsync, deactivateKeepAwake } from 'expo-keep-awake';
 import { getTelemetry, setLED, triggerHorn, triggerSOS, triggerRadio, muteEngine } from '../services/esp32Service';
+import { openTelemetryStream } from '../services/telemetryStreamService';
 import { TelemetryResponse } from '../types';
 import { COLORS, FONTS } from '../constants/Theme';
 import { SystemsCheckModal } from '../components/SystemsCheckModal';
@@ -33,6 +34,8 @@ interface LogEntry extends TelemetryResponse {
 
 const LOG_STORAGE_KEY = '@boat_telemetry_log';
 const LOG_STATE_KEY = '@boat_telemetry_log_state';
+const TELEMETRY_STREAM_HZ = 10; // Live throttle/rudder feedback rate
+const CAMERA_STREAM_PORT = 81; // camera_stream.ino STREAM_HTTP_PORT
 
 function debugLog(message: string) {
   const timestamp = new Date().toISOString();
@@ -91,7 +94,8 @@ export default function DashboardScreen({ navigation, route }: Props) {
   
   const cameraIP = rawCameraIP && rawCameraIP.replace(/^https?:\/\//, '').trim();
   const hasCameraIP = cameraIP && cameraIP.length > 0;
-  const streamUrl = hasCameraIP ? `http://${cameraIP}/stream` : null;
+  // MJPEG is served by the camera's stream server on its own port (control stays on 80)
+  const streamUrl = hasCameraIP ? `http://${cameraIP}:${CAMERA_STREAM_PORT}/stream` : null;
   const [cameraLoadError, setCameraLoadError] = useState<string | null>(null);
   
   const [telemetry, setTelemetry] = useState<TelemetryResponse | null>(null);
@@ -141,6 +145,9 @@ export default function DashboardScreen({ navigation, route }: Props) {
   };
   
   const intervalRef = useRef<NodeJS.Timeout | null>(null);
+  // Latest pushed telemetry; while the stream is up the 1 s tick reads this instead of polling
+  const streamTelemetryRef = useRef<TelemetryResponse | null>(null);
+  const streamConnectedRef = useRef(false);
   const saveTimeoutRef = useRef<NodeJS.Timeout | null>(null);
   const clockIntervalRef = useRef<NodeJS.Timeout | null>(null);
 
@@ -211,7 +218,9 @@ export default function DashboardScreen({ navigation, route }: Props) {
 
   const fetchTelemetry = useCallback(async () => {
     try {
-      const data = await getTelemetry(ip);
+      const data = streamConnectedRef.current && streamTelemetryRef.current
+        ? streamTelemetryRef.current
+        : await getTelemetry(ip);
       setTelemetry(data);
       setLastError(null);
       setIsConnected(true);
@@ -294,6 +303,21 @@ export default function DashboardScreen({ navigation, route }: Props) {
     }
   }, [ip, isLogging, lowBatteryAlertShown, waterIntrusionAlertShown, lowBatteryDebounceCount, highBatteryDebounceCount]);
 
+  // Push stream for live values; alerts and logging still run on the 1 s tick below
+  useEffect(() => {
+    const stream = openTelemetryStream(ip, TELEMETRY_STREAM_HZ, {
+      onTelemetry: (data) => {
+        streamTelemetryRef.current = data;
+        setTelemetry(data);
+      },
+      onStatusChange: (connected) => {
+        streamConnectedRef.current = connected;
+        debugLog(`Telemetry stream ${connected ? 'connected' : 'disconnected (falling back to polling)'}`);
+      },
+    });
+    return () => stream.close();
+  }, [ip]);
+
   useEffect(() => {
     fetchTelemetry();
     intervalRef.current = setInterval(fetchTelemetry, 1000);
@@ -1,5 +1,5 @@
 // ESP32 HTTP service with timeout support
-import { StatusResponse, TelemetryResponse, LEDResponse, LEDMode, LEDState, HornResponse, SOSResponse, RadioResponse, MuteResponse } from '../types';
+import { StatusResponse, TelemetryResponse, TelemetryFrame, LEDResponse, LEDMode, LEDState, HornResponse, SOSResponse, RadioResponse, MuteResponse, HistoryResponse } from '../types';
 
 const TIMEOUT_MS = 5000;
 
@@ -58,6 +58,66 @@ export async function getTelemetry(ip: string): Promise<TelemetryResponse> {
   return response.json();
 }
 
+const TELEMETRY_FRAME_MAGIC = 0x4654;
+const TELEMETRY_FRAME_VERSION = 1;
+const TELEMETRY_FRAME_SIZE = 40;
+
+/**
+ * Decode the packed binary telemetry frame (firmware/boat_telemetry/telemetry_frame.h)
+ */
+export function decodeTelemetryFrame(buffer: ArrayBuffer): TelemetryFrame {
+  if (buffer.byteLength < TELEMETRY_FRAME_SIZE) {
+    throw new Error(`Telemetry frame too short: ${buffer.byteLength} bytes`);
+  }
+  const view = new DataView(buffer);
+  const magic = view.getUint16(0, true);
+  const version = view.getUint8(2);
+  if (magic !== TELEMETRY_FRAME_MAGIC || version !== TELEMETRY_FRAME_VERSION) {
+    throw new Error(`Unsupported telemetry frame (magic 0x${magic.toString(16)}, version ${version})`);
+  }
+  const flags = view.getUint8(3);
+
+  return {
+    version,
+    timestamp_ms: view.getUint32(4, true),
+    uptime_seconds: view.getUint32(8, true),
+    free_heap: view.getUint32(12, true),
+    sensor_seq: view.getUint32(16, true),
+    ip_address: `${view.getUint8(20)}.${view.getUint8(21)}.${view.getUint8(22)}.${view.getUint8(23)}`,
+    battery_mv: view.getUint16(24, true),
+    battery_pin_mv: view.getUint16(26, true),
+    battery_adc_raw: view.getUint16(28, true),
+    throttle_pwm: view.getUint16(30, true),
+    servo_pwm: view.getUint16(32, true),
+    throttle_age_ms: view.getUint16(34, true),
+    servo_age_ms: view.getUint16(36, true),
+    rssi_dbm: view.getInt8(38),
+    water_wet_duty_pct: view.getUint8(39),
+    water_intrusion: (flags & 0x01) !== 0,
+    water_sensor_raw: (flags & 0x02) !== 0 ? 1 : 0,
+    battery_low: (flags & 0x04) !== 0,
+    running_mode_state: (flags & 0x08) !== 0,
+    flood_mode_state: (flags & 0x10) !== 0,
+    dfplayer_available: (flags & 0x20) !== 0,
+    engine_muted: (flags & 0x40) !== 0,
+    wifi_connected: (flags & 0x80) !== 0,
+  };
+}
+
+/**
+ * Get telemetry as the compact binary frame (opt-in, ~40 bytes instead of ~600 of JSON)
+ */
+export async function getTelemetryFrame(ip: string): Promise<TelemetryFrame> {
+  const url = buildUrl(ip, '/telemetry?format=bin');
+  const response = await fetchWithTimeout(url);
+
+  if (!response.ok) {
+    throw new Error(`Telemetry request failed: ${response.status}`);
+  }
+
+  return decodeTelemetryFrame(await response.arrayBuffer());
+}
+
 /**
  * Set LED state on ESP32
  */
@@ -172,6 +232,43 @@ export async function getSystemDebug(ip: string): Promise<any> {
   return response.json();
 }
 
+/**
+ * Get runtime performance counters (loop/handler/audio timing, task stacks, heap)
+ */
+export async function getPerf(ip: string): Promise<any> {
+  const url = buildUrl(ip, '/perf');
+  const response = await fetchWithTimeout(url);
+  
+  if (!response.ok) {
+    throw new Error(`Perf request failed: ${response.status}`);
+  }
+  
+  return response.json();
+}
+
+/**
+ * Get a range from the boat's flight recorder (fills gaps in the app's own log).
+ * since = boat millis() of that boot, step = every n-th second. Follow next_since
+ * while truncated is true
+ */
+export async function getHistory(
+  ip: string,
+  options: { since?: number; step?: number; boot?: number; limit?: number } = {}
+): Promise<HistoryResponse> {
+  const params = Object.entries(options)
+    .filter(([, value]) => value !== undefined)
+    .map(([key, value]) => `${key}=${value}`)
+    .join('&');
+  const url = buildUrl(ip, params ? `/history?${params}` : '/history');
+  const response = await fetchWithTimeout(url);
+
+  if (!response.ok) {
+    throw new Error(`History request failed: ${response.status}`);
+  }
+
+  return response.json();
+}
+
 /**
  * Get engine debug info (throttle, rate, gain, etc.)
  */
@@ -1,9 +1,14 @@
 /**
  * Network scanning service for discovering ESP32 devices on the local network
  * Uses progressive scanning strategy:
- * 1. Probe recently-used IPs first (instant feedback)
- * 2. Scan subnet ranges in parallel
+ * 1. Probe the boards' mDNS hostnames and recently-used IPs together (sub-second when found)
+ * 2. Scan subnet ranges in parallel - only if phase 1 did not find what was asked for
  * 3. Allow device selection while scanning continues
+ *
+ * Both firmwares advertise <hostname>.local with an _edmund._tcp service and answer a
+ * UDP beacon (see firmware discovery.h). The app resolves the hostnames through the
+ * OS resolver (iOS/macOS resolve .local natively); the UDP beacon needs a native
+ * socket module and is there for tools, e.g. scripts/discover_boat.py.
  */
 
 export interface ScannedDevice {
@@ -19,7 +24,10 @@ export interface ScanController {
 }
 
 const TIMEOUT_MS = 2000; // 2 second timeout per device
-const QUICK_PROBE_TIMEOUT_MS = 1000; // Faster timeout for known IPs
+const QUICK_PROBE_TIMEOUT_MS = 1000; // Faster timeout for known IPs and mDNS hostnames
+
+// mDNS hostnames set by the firmwares (discovery.h DiscoveryInfo.hostname)
+const MDNS_HOSTNAMES = ['edmund-fitzgerald.local', 'edmund-camera.local'];
 
 // Subnet ranges to scan (in priority order)
 const COMMON_IP_RANGES = [
@@ -109,9 +117,13 @@ async function probeIP(
           type = 'camera';
         }
 
+        // Hostname probes report the board's address in the body
+        const reportedIp = typeof data.ip === 'string' ? data.ip : data.ip_address;
+        const deviceIp = ip.endsWith('.local') && reportedIp && reportedIp !== '0.0.0.0' ? reportedIp : ip;
+
         const result = {
-          ip,
-          name: data.name || `ESP32-${ip.split('.')[3]}`,
+          ip: deviceIp,
+          name: data.name || `ESP32-${deviceIp.split('.')[3]}`,
           type,
           lastSeen: Date.now(),
         };
@@ -190,11 +202,13 @@ async function getLocalIP(): Promise<string | null> {
  * 
  * @param onProgress - Callback called as devices are found (passes devices array for real-time display)
  * @param recentlyUsedIPs - IPs that were recently found (should be provided by component)
+ * @param wantedType - Skip the subnet sweep once a device of this type has been found
  * @returns ScanController with cancel() and promise
  */
 export function scanForDevices(
   onProgress?: (devices: ScannedDevice[], checked: number, total: number) => void,
-  recentlyUsedIPs: string[] = []
+  recentlyUsedIPs: string[] = [],
+  wantedType?: ScannedDevice['type']
 ): ScanController {
   let cancelled = false;
   
@@ -205,29 +219,39 @@ export function scanForDevices(
     console.log('[NetworkScan] Starting progressive device scan...');
     console.log('[NetworkScan] Recently used IPs:', recentlyUsedIPs);
 
-    // Phase 1: Quickly probe recently used IPs (should be instant if devices are online)
-    if (recentlyUsedIPs.length > 0) {
-      console.log(`[NetworkScan] Phase 1: Probing ${recentlyUsedIPs.length} recently used IPs...`);
-      
-      const recentResults = await Promise.all(
-        recentlyUsedIPs.map(ip => probeIP(ip, QUICK_PROBE_TIMEOUT_MS))
-      );
+    // Phase 1: Probe mDNS hostnames and recently used IPs together (instant if devices are online)
+    const quickTargets = [...MDNS_HOSTNAMES, ...recentlyUsedIPs];
+    console.log(`[NetworkScan] Phase 1: Probing ${MDNS_HOSTNAMES.length} mDNS hostnames and ${recentlyUsedIPs.length} recently used IPs...`);
 
-      recentResults.forEach((result, idx) => {
-        if (result) {
-          console.log(`[NetworkScan] Found recent device at ${result.ip}`);
-          devices.push(result);
-        }
-        checkedCount++;
-      });
+    const quickResults = await Promise.all(
+      quickTargets.map(target => probeIP(target, QUICK_PROBE_TIMEOUT_MS))
+    );
+
+    quickResults.forEach(result => {
+      // A board can answer both its hostname and a remembered IP
+      if (result && !devices.find(d => d.ip === result.ip)) {
+        console.log(`[NetworkScan] Found device at ${result.ip} (type: ${result.type})`);
+        devices.push(result);
+      }
+      checkedCount++;
+    });
 
-      // Report progress after recent IPs checked - pass devices array for real-time display
-      const totalEstimate = recentlyUsedIPs.length + COMMON_IP_RANGES.reduce((sum, r) => sum + (r.end - r.start + 1), 0);
-      onProgress?.([...devices], checkedCount, totalEstimate);
+    // Report progress after the quick probes - pass devices array for real-time display
+    const totalEstimate = quickTargets.length + COMMON_IP_RANGES.reduce((sum, r) => sum + (r.end - r.start + 1), 0);
+    onProgress?.([...devices], checkedCount, totalEstimate);
+
+    // Found what was asked for (or both boards) - no sweep needed
+    const skipSweep = wantedType
+      ? devices.some(d => d.type === wantedType)
+      : devices.some(d => d.type === 'telemetry') && devices.some(d => d.type === 'camera');
+    if (skipSweep) {
+      // Keeps hundreds of probes off the boards and the hotspot
+      console.log('[NetworkScan] Found via mDNS/recent IPs, skipping subnet sweep');
+      onProgress?.([...devices], checkedCount, checkedCount);
     }
 
     // Phase 2: Scan subnet ranges in parallel for faster coverage
-    console.log('[NetworkScan] Phase 2: Scanning full subnets in parallel...');
+    if (!skipSweep) console.log('[NetworkScan] Phase 2: Scanning full subnets in parallel...');
     
     const allIPs: string[] = [];
     for (const range of COMMON_IP_RANGES) {
@@ -236,9 +260,9 @@ export function scanForDevices(
       }
     }
 
-    // Filter out IPs we already checked
-    const recentIPSet = new Set(recentlyUsedIPs);
-    const uncheckedIPs = allIPs.filter(ip => !recentIPSet.has(ip));
+    // Filter out IPs we already checked (or found through their hostname)
+    const recentIPSet = new Set([...recentlyUsedIPs, ...devices.map(d => d.ip)]);
+    const uncheckedIPs = skipSweep ? [] : allIPs.filter(ip => !recentIPSet.has(ip));
     
     console.log(`[NetworkScan] Scanning ${uncheckedIPs.length} unchecked IP addresses`);
 
@@ -271,7 +295,7 @@ export function scanForDevices(
       checkedCount += batch.length;
       
       // Call progress callback with current devices array for real-time UI updates
-      onProgress?.([...devices], recentlyUsedIPs.length + checkedCount, recentlyUsedIPs.length + allIPs.length);
+      onProgress?.([...devices], checkedCount, quickTargets.length + uncheckedIPs.length);
     }
 
     console.log(`[NetworkScan] Scan ${cancelled ? 'cancelled' : 'complete'}. Found ${devices.length} devices.`);
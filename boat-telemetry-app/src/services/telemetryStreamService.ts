@@ -0,0 +1,148 @@
+// Telemetry push stream (/telemetry/stream, Server-Sent Events)
+// Uses XMLHttpRequest progress events so it works on web and React Native alike
+// (React Native has no EventSource). "telemetry" events carry every field,
+// "delta" events only the fields that changed - both are merged into one object.
+import { TelemetryResponse } from '../types';
+
+const RECONNECT_DELAY_MS = 2000;
+const STALE_TIMEOUT_MS = 5000; // No event for this long = connection considered dead
+const MAX_RESPONSE_CHARS = 512 * 1024; // XHR keeps the whole body - recycle the connection past this
+
+export interface TelemetryStreamHandle {
+  close: () => void;
+}
+
+export interface TelemetryStreamCallbacks {
+  onTelemetry: (data: TelemetryResponse) => void;
+  onStatusChange?: (connected: boolean) => void;
+}
+
+/**
+ * Open a telemetry stream at the requested rate (1-20 Hz). Reconnects on error
+ * until close() is called.
+ */
+export function openTelemetryStream(
+  ip: string,
+  hz: number,
+  callbacks: TelemetryStreamCallbacks
+): TelemetryStreamHandle {
+  const cleanIp = ip.replace(/^https?:\/\//, '').replace(/\/$/, '');
+  const url = `http://${cleanIp}/telemetry/stream?hz=${Math.max(1, Math.min(20, Math.round(hz)))}`;
+
+  let xhr: XMLHttpRequest | null = null;
+  let closed = false;
+  let connected = false;
+  let merged: Partial<TelemetryResponse> | null = null;
+  let parsedLength = 0;
+  let lastEventAt = 0;
+  let reconnectTimer: ReturnType<typeof setTimeout> | null = null;
+  let staleTimer: ReturnType<typeof setInterval> | null = null;
+
+  const setConnected = (value: boolean) => {
+    if (connected !== value) {
+      connected = value;
+      callbacks.onStatusChange?.(value);
+    }
+  };
+
+  const handleEvent = (block: string) => {
+    let event = 'message';
+    let data = '';
+    for (const line of block.split('\n')) {
+      if (line.startsWith('event:')) event = line.slice(6).trim();
+      else if (line.startsWith('data:')) data += line.slice(5).trim();
+    }
+    if (!data) return;
+
+    const fields = JSON.parse(data);
+    if (event === 'telemetry') {
+      merged = fields;
+    } else if (event === 'delta' && merged) {
+      merged = { ...merged, ...fields };
+    } else {
+      return; // Delta before the first keyframe - wait for a full frame
+    }
+    lastEventAt = Date.now();
+    setConnected(true);
+    callbacks.onTelemetry(merged as TelemetryResponse);
+  };
+
+  const scheduleReconnect = () => {
+    setConnected(false);
+    if (xhr) {
+      xhr.onprogress = null;
+      xhr.onerror = null;
+      xhr.onloadend = null;
+      xhr.abort();
+      xhr = null;
+    }
+    if (!closed && !reconnectTimer) {
+      reconnectTimer = setTimeout(() => {
+        reconnectTimer = null;
+        connect();
+      }, RECONNECT_DELAY_MS);
+    }
+  };
+
+  // Reopen immediately (the new connection starts with a keyframe)
+  const recycle = () => {
+    if (xhr) {
+      xhr.onprogress = null;
+      xhr.onerror = null;
+      xhr.onloadend = null;
+      xhr.abort();
+      xhr = null;
+    }
+    connect();
+  };
+
+  const connect = () => {
+    if (closed) return;
+    merged = null;
+    parsedLength = 0;
+    lastEventAt = Date.now();
+
+    xhr = new XMLHttpRequest();
+    xhr.open('GET', url);
+    xhr.setRequestHeader('Accept', 'text/event-stream');
+    xhr.onprogress = () => {
+      if (!xhr) return;
+      const text = xhr.responseText;
+      // Events end with a blank line; keep any partial event for the next chunk
+      let end = text.indexOf('\n\n', parsedLength);
+      while (end >= 0) {
+        const block = text.slice(parsedLength, end);
+        parsedLength = end + 2;
+        try {
+          handleEvent(block);
+        } catch (err) {
+          console.log('Telemetry stream: bad event', err);
+        }
+        end = text.indexOf('\n\n', parsedLength);
+      }
+      if (parsedLength > MAX_RESPONSE_CHARS) {
+        recycle();
+      }
+    };
+    xhr.onerror = scheduleReconnect;
+    xhr.onloadend = scheduleReconnect;
+    xhr.send();
+  };
+
+  staleTimer = setInterval(() => {
+    if (xhr && Date.now() - lastEventAt > STALE_TIMEOUT_MS) {
+      scheduleReconnect();
+    }
+  }, 1000);
+
+  connect();
+
+  return {
+    close: () => {
+      closed = true;
+      if (reconnectTimer) clearTimeout(reconnectTimer);
+      if (staleTimer) clearInterval(staleTimer);
+      scheduleReconnect();
+    },
+  };
+}
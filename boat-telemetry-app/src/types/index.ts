@@ -11,6 +11,7 @@ export interface StatusResponse {
 
 export interface TelemetryResponse {
   timestamp: string;
+  timestamp_epoch_ms?: number;   // Unix ms on the clock the camera stamps frames with (0 = not synced)
   battery_voltage: string;
   signal_strength: string;
   uptime_seconds: number;
@@ -21,6 +22,9 @@ export interface TelemetryResponse {
   dfplayer_available: boolean;
   water_intrusion: boolean;
   water_sensor_raw: number;
+  water_wet_duty_pct?: number;   // Raw wet time over the last minute (0-100)
+  water_first_wet_ms?: number;   // Boat millis() of the first wet edge (0 = never wet)
+  water_wet_onset_ms?: number;   // Boat millis() where the current / last wet spell started
   throttle_pwm: number;
   servo_pwm: number;
   engine_muted: boolean;
@@ -28,6 +32,65 @@ export interface TelemetryResponse {
   ip_address: string;
 }
 
+// Packed binary /telemetry frame (?format=bin), decoded to numbers
+// Layout: firmware/boat_telemetry/telemetry_frame.h
+export interface TelemetryFrame {
+  version: number;
+  timestamp_ms: number;
+  uptime_seconds: number;
+  free_heap: number;
+  sensor_seq: number;
+  ip_address: string;
+  battery_mv: number;
+  battery_pin_mv: number;
+  battery_adc_raw: number;
+  throttle_pwm: number;
+  servo_pwm: number;
+  throttle_age_ms: number;
+  servo_age_ms: number;
+  rssi_dbm: number;
+  water_wet_duty_pct: number;
+  water_intrusion: boolean;
+  water_sensor_raw: number;
+  battery_low: boolean;
+  running_mode_state: boolean;
+  flood_mode_state: boolean;
+  dfplayer_available: boolean;
+  engine_muted: boolean;
+  wifi_connected: boolean;
+}
+
+// Flight recorder range (GET /history) - one row per second on the boat
+// Layout: firmware/boat_telemetry/flight_recorder.h
+export type HistoryRow = [
+  number, // t_ms (millis() of that boot)
+  number, // battery_mv
+  number, // throttle_us
+  number, // servo_us
+  number, // free_heap_kb
+  number, // rssi_dbm (0 = not connected)
+  number, // flags (HISTORY_FLAG_*)
+];
+
+export interface HistoryResponse {
+  boot: number;
+  current_boot: number;
+  since: number;
+  step: number;
+  fields: string[];
+  samples: HistoryRow[];
+  count: number;
+  truncated: boolean; // More rows after next_since - ask again
+  next_since: number;
+}
+
+export const HISTORY_FLAG_WATER_RAW_WET = 0x01;
+export const HISTORY_FLAG_WATER_BREACHED = 0x02;
+export const HISTORY_FLAG_THROTTLE_VALID = 0x04;
+export const HISTORY_FLAG_SERVO_VALID = 0x08;
+export const HISTORY_FLAG_BATTERY_LOW = 0x10;
+export const HISTORY_FLAG_WIFI_CONNECTED = 0x20;
+
 export interface LEDResponse {
   running_led: boolean;
   flood_led: boolean;
@@ -36,17 +99,20 @@ export interface LEDResponse {
 export interface HornResponse {
   horn_active: boolean;
   duration_ms: number;
+  request_id?: number; // DFPlayer queue request (GET /dfplayer?id=N)
 }
 
 export interface SOSResponse {
   sos_active: boolean;
   rounds: number;
+  request_id?: number;
 }
 
 export interface RadioResponse {
   radio_active: boolean;
   radio_id: number;
   duration_ms: number;
+  request_id?: number;
 }
 
 export interface MuteResponse {
@@ -1,168 +1,61 @@
 /*
  * audio_diagnostic.ino
  * Standalone diagnostic for I2S/MAX98357A engine audio testing
- * 
+ *
  * Tests without RC receiver - simulates throttle via serial commands
- * 
- * NOTE: High-pass filtering is applied OFFLINE using circular FFT 
+ *
+ * Runs the production engine (firmware/libraries/EngineAudio: same audio_engine.cpp,
+ * tuning and engine bank as boat_telemetry), so what you hear and profile here is
+ * what the boat plays. The sample bank is read from the "engine" partition - flash
+ * engine_bank.bin once (see firmware/README.md); partitions.csv matches boat_telemetry.
+ *
+ * NOTE: High-pass filtering is applied OFFLINE using circular FFT
  * in build/audio/make_engine_filtered_fft.py to guarantee click-free looping.
- * 
+ *
  * Serial Commands:
  *   0-9: Set throttle 0-100% (0=idle, 9=full)
  *   a: Auto sweep mode (slow ramp up/down)
  *   r: Rev test (snap throttle up)
  *   s: Stop/idle
  *   i: Print info/status
- *   f: Toggle FILTERED (FFT offline) vs RAW (unfiltered)
+ *   k: Toggle render kernel (fixed <-> float) for A/B listening and profiling
+ *   l: Next loop in the bank (RPM layers first, then each plain loop)
+ *   b: Run the engine benchmark (output pauses ~1-2 s, results on serial)
  */
 
-#include "driver/i2s.h"
-#include "engine_pcm.h"      // FFT-filtered PCM data
-#include "engine_pcm_raw.h"  // Raw unfiltered PCM data
+#include "driver/i2s_std.h"     // ESP-IDF 5.x NEW I2S driver (same as boat_telemetry)
+#include <audio_engine.h>       // Shared engine (firmware/libraries/EngineAudio)
 
-// I2S Configuration
-#define I2S_NUM           I2S_NUM_0
-#define I2S_SAMPLE_RATE   44100
-#define I2S_BUFFER_SIZE   512
+// I2S Configuration (matches boat_telemetry: ~2.9 ms blocks, 2 DMA descriptors)
+// Set I2S_SAMPLE_RATE to AUDIO_RATE_HALF / AUDIO_RATE_LOW to listen to a low-rate bank
+#define I2S_NUM           I2S_NUM_1
+#define I2S_SAMPLE_RATE   AUDIO_RATE_FULL
+#define I2S_BUFFER_SIZE   (I2S_SAMPLE_RATE > AUDIO_RATE_HALF ? 128 : 64)
+#define I2S_DMA_DESC_NUM  2
 #define I2S_BCLK_PIN      25
 #define I2S_LRC_PIN       22
 #define I2S_DIN_PIN       23
 
-// Tuning parameters
-#define THROTTLE_SMOOTH_ALPHA   0.15f
-#define RATE_MIN                0.8f
-#define RATE_MAX                1.5f
-#define GAIN_MIN                0.55f   // Minimum gain at idle - adequate presence without over-stressing speaker
-#define GAIN_MAX                0.8f    // Maximum gain at full throttle - slightly reduced to prevent speaker rattle
-#define REV_BOOST_RATE          1.25f
-#define REV_BOOST_GAIN          1.4f
-#define REV_DECAY_MS            400
-#define REV_THRESHOLD           0.15f
-#define REV_RAMP_MS             150
+#define LOOP_LAYERS       -1    // requestedLoop: RPM layer crossfade
+#define LOOP_NONE         -2    // requestedLoop: no change pending
 
-#define START_FADE_MS           10      // 10ms startup fade-in to prevent initial pop
-
-// Audio engine state
-typedef struct {
-  float position;
-  float rate;
-  float gain;
-  float smoothed_throttle;
-  float prev_throttle;
-  uint32_t rev_timer_ms;
-  uint32_t last_update_ms;
-  uint32_t startup_fade_remaining;
-} EngineAudioState;
-
-EngineAudioState engineState;
+i2s_chan_handle_t i2s_tx_handle = NULL;
 float simulated_throttle = 0.0f;
 bool auto_sweep_mode = false;
 unsigned long last_sweep_update = 0;
-bool use_filtered = true;
-
-// Linear interpolation
-static inline float audioLerp(float a, float b, float t) {
-  return a + (b - a) * t;
-}
-
-// Soft clip using tanh - prevents harsh clipping artifacts
-static inline float softClip(float x) {
-  const float max_val = 32767.0f;
-  const float k = 2.0f;
-  float normalized = x / max_val;
-  return (tanh(k * normalized) / tanh(k)) * max_val;
-}
-
-// Initialize audio engine
-void audioEngine_init() {
-  engineState.position = 0.0f;
-  engineState.rate = 1.0f;
-  engineState.gain = GAIN_MIN;
-  engineState.smoothed_throttle = 0.0f;
-  engineState.prev_throttle = 0.0f;
-  engineState.rev_timer_ms = 0;
-  engineState.last_update_ms = millis();
-  engineState.startup_fade_remaining = (uint32_t)(I2S_SAMPLE_RATE * START_FADE_MS / 1000);
-}
-
-// Update throttle
-void audioEngine_updateThrottle(float throttle_normalized) {
-  if (throttle_normalized < 0.0f) throttle_normalized = 0.0f;
-  if (throttle_normalized > 1.0f) throttle_normalized = 1.0f;
-  
-  uint32_t current_ms = millis();
-  uint32_t delta_ms = current_ms - engineState.last_update_ms;
-  engineState.last_update_ms = current_ms;
-  
-  float throttle_delta = throttle_normalized - engineState.prev_throttle;
-  if (throttle_delta > REV_THRESHOLD) {
-    engineState.rev_timer_ms = REV_DECAY_MS + REV_RAMP_MS;
-  }
-  engineState.prev_throttle = throttle_normalized;
-  
-  if (engineState.rev_timer_ms > 0) {
-    if (delta_ms >= engineState.rev_timer_ms) engineState.rev_timer_ms = 0;
-    else engineState.rev_timer_ms -= delta_ms;
-  }
-  
-  float smooth_alpha = (engineState.rev_timer_ms > 0) ? 0.35f : THROTTLE_SMOOTH_ALPHA;
-  engineState.smoothed_throttle = engineState.smoothed_throttle * (1.0f - smooth_alpha) + throttle_normalized * smooth_alpha;
-  
-  float base_rate = RATE_MIN + engineState.smoothed_throttle * (RATE_MAX - RATE_MIN);
-  float base_gain = GAIN_MIN + engineState.smoothed_throttle * (GAIN_MAX - GAIN_MIN);
-  
-  if (engineState.rev_timer_ms > 0) {
-    float total_time = REV_DECAY_MS + REV_RAMP_MS;
-    float rev_elapsed = total_time - engineState.rev_timer_ms;
-    float rev_amount = (rev_elapsed < REV_RAMP_MS) ? (rev_elapsed / REV_RAMP_MS) : (1.0f - ((rev_elapsed - REV_RAMP_MS) / REV_DECAY_MS));
-    base_rate *= 1.0f + (REV_BOOST_RATE - 1.0f) * rev_amount;
-    base_gain *= 1.0f + (REV_BOOST_GAIN - 1.0f) * rev_amount;
-  }
-  
-  engineState.rate = base_rate;
-  engineState.gain = base_gain;
-}
-
-// Render samples
-void audioEngine_renderSamples(int16_t* buffer, size_t count) {
-  const int16_t* pcm_data = use_filtered ? ENGINE_PCM_DATA : ENGINE_PCM_RAW_DATA;
-  uint32_t pcm_length = use_filtered ? ENGINE_PCM_LENGTH : ENGINE_PCM_RAW_LENGTH;
-  
-  for (size_t i = 0; i < count; i++) {
-    uint32_t idx = (uint32_t)engineState.position;
-    float frac = engineState.position - (float)idx;
-    
-    // Simple wrap (FFT filtering ensures periodic continuity)
-    if (idx >= pcm_length) {
-      engineState.position = frac;
-      idx = 0;
-    }
-    
-    int16_t sample0 = pcm_data[idx];
-    int16_t sample1 = pcm_data[(idx + 1) % pcm_length];
-    
-    float interpolated = audioLerp((float)sample0, (float)sample1, frac);
-    interpolated *= engineState.gain;
-
-    // Startup/Mode fade-in
-    if (engineState.startup_fade_remaining > 0) {
-      float progress = 1.0f - ((float)engineState.startup_fade_remaining / (I2S_SAMPLE_RATE * START_FADE_MS / 1000));
-      interpolated *= progress;
-      engineState.startup_fade_remaining--;
-    }
-    
-    buffer[i] = (int16_t)softClip(interpolated);
-    engineState.position += engineState.rate;
-  }
-}
+int currentLoop = LOOP_LAYERS;              // What is playing (LOOP_LAYERS or a bank index)
+volatile int requestedLoop = LOOP_NONE;     // Applied by the audio task between blocks
 
 void setup() {
   Serial.begin(115200);
   delay(1000);
-  Serial.println("\n=== ENGINE AUDIO DIAGNOSTIC (FFT CIRCULAR FILTERING) ===");
+  Serial.println("\n=== ENGINE AUDIO DIAGNOSTIC (SHARED ENGINE) ===");
   Serial.println("Using FFT-domain filtering to guarantee seamless loop boundaries.");
   setupI2S();
-  audioEngine_init();
+  audioEngine_init(I2S_SAMPLE_RATE);
+  EngineTelemetry t;
+  audioEngine_getTelemetry(&t);
+  currentLoop = t.layer_count > 1 ? LOOP_LAYERS : t.sample_index;
   setupAudioTask();
   printHelp();
 }
@@ -173,9 +66,32 @@ void loop() {
     last_sweep_update = millis();
     simulated_throttle = (sin(millis() / 5000.0f) + 1.0f) / 2.0f;
   }
+  // Same control path as the sensor task on the boat
+  audioEngine_postThrottle(simulated_throttle);
   delay(10);
 }
 
+// Playable loops in order: RPM layers (if the bank has two or more), then each plain loop.
+// Returns the entry after current (wrapping), or current if it is the only one
+int nextLoop(int current) {
+  int entries[ENGINE_BANK_MAX_ENTRIES + 1];
+  int count = 0;
+  int layers = 0;
+  for (int i = 0; i < engineBank_count(); i++) {
+    EngineSample sample;
+    if (engineBank_get(i, &sample) && sample.kind == ENGINE_KIND_LAYER) layers++;
+  }
+  if (layers >= 2) entries[count++] = LOOP_LAYERS;
+  for (int i = 0; i < engineBank_count(); i++) {
+    EngineSample sample;
+    if (engineBank_get(i, &sample) && sample.kind == ENGINE_KIND_LOOP) entries[count++] = i;
+  }
+  for (int i = 0; i < count; i++) {
+    if (entries[i] == current) return entries[(i + 1) % count];
+  }
+  return count > 0 ? entries[0] : current;
+}
+
 void handleCommand(char cmd) {
   if (cmd >= '0' && cmd <= '9') {
     auto_sweep_mode = false;
@@ -193,10 +109,23 @@ void handleCommand(char cmd) {
     auto_sweep_mode = false;
     simulated_throttle = 0.0f;
     Serial.println("Stopped");
-  } else if (cmd == 'f' || cmd == 'F') {
-    use_filtered = !use_filtered;
-    engineState.startup_fade_remaining = (uint32_t)(I2S_SAMPLE_RATE * START_FADE_MS / 1000);
-    Serial.printf("Audio Mode: %s\n", use_filtered ? "FILTERED (FFT Circular)" : "RAW");
+  } else if (cmd == 'k' || cmd == 'K') {
+    uint8_t kernel = audioEngine_getKernel() == AUDIO_KERNEL_FIXED ? AUDIO_KERNEL_FLOAT : AUDIO_KERNEL_FIXED;
+    if (!audioEngine_setKernel(kernel)) Serial.println("Engine control queue full");
+  } else if (cmd == 'l' || cmd == 'L') {
+    int next = nextLoop(currentLoop);
+    if (next == currentLoop) {
+      Serial.println("Only one loop in the bank");
+      return;
+    }
+    currentLoop = next;
+    requestedLoop = next;
+    EngineSample sample;
+    if (next == LOOP_LAYERS) Serial.println("Loop: RPM layers");
+    else if (engineBank_get(next, &sample)) Serial.printf("Loop: [%d] %.16s\n", next, sample.name);
+  } else if (cmd == 'b' || cmd == 'B') {
+    Serial.printf("Benchmark (%s kernel) queued...\n", audioEngine_getKernelName());
+    audioEngine_requestBenchmark();
   } else if (cmd == 'i') {
     printStatus();
   } else if (cmd == 'h' || cmd == '?') {
@@ -205,38 +134,51 @@ void handleCommand(char cmd) {
 }
 
 void printHelp() {
-  Serial.println("0-9: Throttle | a: Sweep | r: Rev | s: Idle | f: Toggle Filter | i: Status");
+  Serial.println("0-9: Throttle | a: Sweep | r: Rev | s: Idle | k: Kernel A/B | l: Next loop | b: Bench | i: Status");
 }
 
 void printStatus() {
-  Serial.printf("Mode: %s | Throttle: %.3f | Rate: %.3f | Gain: %.3f | Rev: %s\n", 
-    use_filtered ? "FILTERED" : "RAW",
-    simulated_throttle, engineState.rate, engineState.gain, engineState.rev_timer_ms > 0 ? "YES" : "no");
+  EngineTelemetry t;
+  audioEngine_getTelemetry(&t);
+  uint32_t budget = (getCpuFrequencyMhz() * 1000000UL) / I2S_SAMPLE_RATE;
+  Serial.printf("Kernel: %s | Bank: %s | Layers: %u | Throttle: %.3f | Rate: %.3f | Gain: %.3f | Rev: %s\n",
+    audioEngine_getKernelName(), engineBank_source(), t.layer_count,
+    simulated_throttle, t.rate, t.gain, t.rev_active ? "YES" : "no");
+  Serial.printf("Cycles/sample: %lu (peak %lu, budget %lu @ %lu Hz)\n",
+    (unsigned long)t.cycles_per_sample, (unsigned long)t.cycles_per_sample_peak, (unsigned long)budget,
+    (unsigned long)t.sample_rate);
 }
 
 void setupI2S() {
-  i2s_config_t i2s_config = {
-    .mode = (i2s_mode_t)(I2S_MODE_MASTER | I2S_MODE_TX),
-    .sample_rate = I2S_SAMPLE_RATE,
-    .bits_per_sample = I2S_BITS_PER_SAMPLE_16BIT,
-    .channel_format = I2S_CHANNEL_FMT_ONLY_LEFT,
-    .communication_format = I2S_COMM_FORMAT_STAND_I2S,
-    .intr_alloc_flags = ESP_INTR_FLAG_LEVEL1,
-    .dma_buf_count = 4,
-    .dma_buf_len = I2S_BUFFER_SIZE,
-    .use_apll = false,
-    .tx_desc_auto_clear = true,
-    .fixed_mclk = 0
-  };
-  i2s_pin_config_t pin_config = {
-    .bck_io_num = I2S_BCLK_PIN,
-    .ws_io_num = I2S_LRC_PIN,
-    .data_out_num = I2S_DIN_PIN,
-    .data_in_num = I2S_PIN_NO_CHANGE
+  i2s_chan_config_t chan_cfg = I2S_CHANNEL_DEFAULT_CONFIG(I2S_NUM, I2S_ROLE_MASTER);
+  chan_cfg.dma_desc_num = I2S_DMA_DESC_NUM;
+  chan_cfg.dma_frame_num = I2S_BUFFER_SIZE;
+  chan_cfg.auto_clear = true;
+  if (i2s_new_channel(&chan_cfg, &i2s_tx_handle, NULL) != ESP_OK) {
+    Serial.println("✗ I2S channel creation failed");
+    return;
+  }
+  i2s_std_config_t std_cfg = {
+    .clk_cfg = I2S_STD_CLK_DEFAULT_CONFIG(I2S_SAMPLE_RATE),
+    .slot_cfg = I2S_STD_PHILIPS_SLOT_DEFAULT_CONFIG(I2S_DATA_BIT_WIDTH_16BIT, I2S_SLOT_MODE_MONO),
+    .gpio_cfg = {
+      .mclk = I2S_GPIO_UNUSED,
+      .bclk = (gpio_num_t)I2S_BCLK_PIN,
+      .ws = (gpio_num_t)I2S_LRC_PIN,
+      .dout = (gpio_num_t)I2S_DIN_PIN,
+      .din = I2S_GPIO_UNUSED,
+      .invert_flags = {
+        .mclk_inv = false,
+        .bclk_inv = false,
+        .ws_inv = false,
+      },
+    },
   };
-  i2s_driver_install(I2S_NUM, &i2s_config, 0, NULL);
-  i2s_set_pin(I2S_NUM, &pin_config);
-  i2s_zero_dma_buffer(I2S_NUM);
+  if (i2s_channel_init_std_mode(i2s_tx_handle, &std_cfg) != ESP_OK ||
+      i2s_channel_enable(i2s_tx_handle) != ESP_OK) {
+    Serial.println("✗ I2S setup failed");
+    return;
+  }
   Serial.println("✓ I2S Ready");
 }
 
@@ -244,9 +186,22 @@ void audioTaskFunction(void* param) {
   int16_t audio_buffer[I2S_BUFFER_SIZE];
   size_t written;
   while (true) {
-    audioEngine_updateThrottle(simulated_throttle);
+    // Loop changes must happen between blocks (the engine state belongs to this task)
+    int loopRequest = requestedLoop;
+    if (loopRequest != LOOP_NONE) {
+      requestedLoop = LOOP_NONE;
+      if (loopRequest == LOOP_LAYERS) audioEngine_loadLayers();
+      else audioEngine_setSample(loopRequest);
+    }
+
+    audioEngine_processControl();
+    if (audioEngine_benchmarkPending()) {
+      i2s_channel_disable(i2s_tx_handle);
+      audioEngine_runBenchmark();
+      i2s_channel_enable(i2s_tx_handle);
+    }
     audioEngine_renderSamples(audio_buffer, I2S_BUFFER_SIZE);
-    i2s_write(I2S_NUM, audio_buffer, I2S_BUFFER_SIZE * 2, &written, portMAX_DELAY);
+    i2s_channel_write(i2s_tx_handle, audio_buffer, I2S_BUFFER_SIZE * 2, &written, portMAX_DELAY);
   }
 }
 
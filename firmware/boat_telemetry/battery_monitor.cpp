@@ -0,0 +1,114 @@
+// battery_monitor.cpp
+// Continuous ADC battery channel: DMA frame averages -> median -> IIR
+
+#include "battery_monitor.h"
+#include <Arduino.h>
+
+static bool running = false;
+static volatile bool frameReady = false;  // Set by the conversion-done ISR
+
+static uint16_t medianRaw[BATTERY_MEDIAN_TAPS];
+static uint16_t medianMv[BATTERY_MEDIAN_TAPS];
+static uint8_t medianFill = 0;   // Frames in the window (until full)
+static uint8_t medianPos = 0;
+static float filteredRaw = 0.0f;
+static float filteredMv = 0.0f;  // Pin millivolts
+static bool lowBattery = false;
+static uint32_t frameCount = 0;
+
+static void ARDUINO_ISR_ATTR onFrameDone() {
+  frameReady = true;
+}
+
+// Median of the first n window entries (n <= BATTERY_MEDIAN_TAPS)
+static uint16_t median(const uint16_t* window, uint8_t n) {
+  uint16_t sorted[BATTERY_MEDIAN_TAPS];
+  for (uint8_t i = 0; i < n; i++) {
+    uint16_t v = window[i];
+    uint8_t j = i;
+    while (j > 0 && sorted[j - 1] > v) {
+      sorted[j] = sorted[j - 1];
+      j--;
+    }
+    sorted[j] = v;
+  }
+  return sorted[n / 2];
+}
+
+bool batteryMonitor_init(uint8_t pin) {
+  uint8_t pins[] = { pin };
+
+  analogContinuousSetWidth(12);
+  analogContinuousSetAtten(ADC_11db);  // 0-3.1 V at the pin (8.4 V pack -> ~2.7 V)
+  if (!analogContinuous(pins, 1, BATTERY_ADC_FRAME_SAMPLES, BATTERY_ADC_SAMPLE_HZ, &onFrameDone)) {
+    Serial.println("✗ Battery ADC: continuous mode setup failed");
+    return false;
+  }
+  if (!analogContinuousStart()) {
+    Serial.println("✗ Battery ADC: continuous mode start failed");
+    return false;
+  }
+
+  running = true;
+  Serial.printf("Battery ADC continuous on GPIO%d: %d Hz, %d samples/frame\n",
+                pin, BATTERY_ADC_SAMPLE_HZ, BATTERY_ADC_FRAME_SAMPLES);
+  return true;
+}
+
+void batteryMonitor_update() {
+  if (!running || !frameReady) return;
+  frameReady = false;
+
+  adc_continuous_data_t* result = NULL;
+  if (!analogContinuousRead(&result, 0) || result == NULL) return;
+
+  // Frame average (already calibrated to mV by the driver)
+  medianRaw[medianPos] = result[0].avg_read_raw;
+  medianMv[medianPos] = result[0].avg_read_mvolts;
+  medianPos = (medianPos + 1) % BATTERY_MEDIAN_TAPS;
+  if (medianFill < BATTERY_MEDIAN_TAPS) medianFill++;
+
+  float raw = median(medianRaw, medianFill);
+  float mv = median(medianMv, medianFill);
+
+  if (frameCount == 0) {
+    // Seed the filter so the first report isn't a ramp up from zero
+    filteredRaw = raw;
+    filteredMv = mv;
+  } else {
+    filteredRaw += BATTERY_IIR_ALPHA * (raw - filteredRaw);
+    filteredMv += BATTERY_IIR_ALPHA * (mv - filteredMv);
+  }
+  frameCount++;
+
+  uint16_t packMv = batteryMonitor_getMillivolts();
+  if (packMv < BATTERY_LOW_MV) {
+    lowBattery = true;
+  } else if (packMv > BATTERY_LOW_MV + BATTERY_LOW_HYST_MV) {
+    lowBattery = false;
+  }
+}
+
+bool batteryMonitor_isRunning() {
+  return running;
+}
+
+uint16_t batteryMonitor_getRaw() {
+  return (uint16_t)(filteredRaw + 0.5f);
+}
+
+uint16_t batteryMonitor_getPinMillivolts() {
+  return (uint16_t)(filteredMv + 0.5f);
+}
+
+uint16_t batteryMonitor_getMillivolts() {
+  return (uint16_t)(filteredMv * BATTERY_DIVIDER_RATIO + 0.5f);
+}
+
+bool batteryMonitor_isLow() {
+  return lowBattery;
+}
+
+uint32_t batteryMonitor_getFrameCount() {
+  return frameCount;
+}
@@ -0,0 +1,41 @@
+// battery_monitor.h
+// Battery voltage channel on the continuous (DMA) ADC driver
+// The ADC oversamples at kHz rates in hardware; every finished DMA frame is averaged,
+// passed through a short median window (rejects motor/servo spikes) and an IIR low-pass.
+// Readings are calibrated millivolts (ADC calibration scheme), not a fixed scale factor.
+// On the ESP32 the ADC DMA borrows I2S0, which is why engine audio runs on I2S_NUM_1.
+
+#ifndef BATTERY_MONITOR_H
+#define BATTERY_MONITOR_H
+
+#include <stdint.h>
+
+// Oversampling
+#define BATTERY_ADC_SAMPLE_HZ     20000   // Conversion rate (ESP32 DMA minimum is 20 kHz)
+#define BATTERY_ADC_FRAME_SAMPLES 512     // Conversions averaged per DMA frame (~39 frames/s, below the sensor task rate)
+
+// Filtering (per frame)
+#define BATTERY_MEDIAN_TAPS       5       // Median window over frame averages (odd)
+#define BATTERY_IIR_ALPHA         0.05f   // Low-pass coefficient (~0.5 s time constant at 39 frames/s)
+
+// Divider: 100k (top) / 47k (bottom) -> pack = pin * 147 / 47
+#define BATTERY_DIVIDER_RATIO     ((100.0f + 47.0f) / 47.0f)
+
+// Low-voltage alerts (7-cell NiMH, hard cutoff 7.0-7.35 V)
+#define BATTERY_LOW_MV            7500    // Warn with margin above the cutoff
+#define BATTERY_LOW_HYST_MV       150     // Clear only after recovering this far above BATTERY_LOW_MV
+
+// Start continuous conversion on the battery pin (call before I2S/WiFi)
+bool batteryMonitor_init(uint8_t pin);
+
+// Sensor task: consume the DMA frame finished since the last call (never blocks)
+void batteryMonitor_update();
+
+bool batteryMonitor_isRunning();
+uint16_t batteryMonitor_getRaw();             // Filtered ADC counts (0-4095)
+uint16_t batteryMonitor_getPinMillivolts();   // Filtered, calibrated voltage at the pin
+uint16_t batteryMonitor_getMillivolts();      // Filtered pack voltage
+bool batteryMonitor_isLow();                  // Pack below BATTERY_LOW_MV (with hysteresis)
+uint32_t batteryMonitor_getFrameCount();      // DMA frames consumed since boot
+
+#endif // BATTERY_MONITOR_H
@@ -1,25 +1,40 @@
 /*
  * boat_telemetry.ino
  * ESP32 boat telemetry and control system with engine audio + OTA updates
- * Endpoints: /status, /telemetry, /led, /radio, /horn, /sos, /easter-egg, /engine-debug
+ * Endpoints: /status, /telemetry, /telemetry/stream, /led, /radio, /horn, /sos, /easter-egg, /dfplayer, /engine-debug
  * OTA: Hostname "edmund-fitzgerald" | Password: "boat2026"
+ *      ArduinoOTA (IDE, full image) or POST /ota with a gzip / delta image (scripts/ota_push.py)
  */
 
 #include <WiFi.h>
-#include <WebServer.h>
 #include <ArduinoOTA.h>         // Over-The-Air firmware updates
 #include "secrets.h"
 #include "DFRobot_DF1201S.h"   // DFPlayer Pro (DF1201S) library
-#include "driver/i2s_std.h"     // ESP-IDF 5.x NEW I2S driver (no ADC conflict)
-#include "driver/rmt.h"         // ESP32 RMT for PWM capture
-#include "audio_engine.h"       // Engine audio sampler
+#include "i2s_output.h"         // ESP-IDF 5.x NEW I2S driver (no ADC conflict) + underrun counters
+#include "rc_capture.h"         // RC PWM capture on the RMT RX driver (per-frame ISR)
+#include <audio_engine.h>       // Engine audio sampler (firmware/libraries/EngineAudio)
+#include "sensor_ring.h"        // Fixed-rate sensor sample ring buffer
+#include "battery_monitor.h"    // Continuous-ADC battery voltage channel
+#include "json_writer.h"        // Allocation-free JSON response bodies
+#include "telemetry_frame.h"    // Packed binary /telemetry frame
+#include "dfplayer_queue.h"     // DFPlayer command queue + UART task
+#include "http_server.h"        // esp_http_server route table + helpers
+#include "esp_timer.h"          // Telemetry stream service tick
+#include "lwip/sockets.h"       // MSG_DONTWAIT for stream writes
+#include <wifi_link.h>          // Event-driven WiFi with cached-BSSID reconnect
+#include <discovery.h>          // mDNS _edmund._tcp + UDP discovery beacon
+#include "flight_recorder.h"    // 1 Hz telemetry log on LittleFS (/history)
+#include "perf_stats.h"         // Timing histograms + task snapshot (/perf)
+#include "water_sensor.h"       // Edge-interrupt water probe + wet statistics
+#include <ota_stream.h>         // HTTP OTA with gzip / delta images (POST /ota)
+#include <time_sync.h>          // SNTP wall clock shared with the camera
 
 // ==================== PIN DEFINITIONS ====================
 #define LED_RUNNING_PIN    2   // Built-in LED on most dev boards (keep for testing)
 #define LED_FLOOD_PIN      4   // Flood mode indicator LED (optional)
 #define RUNNING_OUT_PIN   16   // External Running lights control (MOSFET gate)
 #define FLOOD_OUT_PIN     21   // External Flood lights control (MOSFET gate)
-#define BATTERY_ADC_PIN   34   // Battery voltage sense (ADC)
+#define BATTERY_ADC_PIN   34   // Battery voltage sense (ADC1, continuous DMA)
 #define WATER_SENSOR_PIN  32   // Water intrusion sensor (digital input with pullup) - GPIO32 has internal pullup, GPIO34/35/36/39 do NOT
 #define THROTTLE_PWM_PIN  18   // RC receiver throttle channel (PWM input)
 #define SERVO_PWM_PIN     19   // RC receiver servo/rudder channel (PWM input)
@@ -33,9 +48,10 @@
 #define I2S_LRC_PIN       22   // Left/Right clock (word select)
 #define I2S_DIN_PIN       23   // Data out to MAX98357A
 
-// RMT configuration for throttle PWM capture
-#define RMT_RX_CHANNEL    RMT_CHANNEL_0
-#define RMT_CLK_DIV       80   // 1 MHz tick rate (80 MHz / 80)
+// ==================== OTA ====================
+#define OTA_HOSTNAME       "edmund-fitzgerald"
+#define OTA_PASSWORD       "boat2026"   // ArduinoOTA, and X-OTA-Password on POST /ota and /engine-bench
+#define OTA_RESTART_DELAY_MS 1000       // Reboot into the new image after the /ota response is out
 
 // ==================== BUILD IDENTIFICATION ====================
 #define FIRMWARE_VERSION   "3.3.0"
@@ -43,277 +59,295 @@
 
 // ==================== I2S CONFIGURATION ====================
 #define I2S_NUM           I2S_NUM_1   // Switch to I2S_NUM_1 to avoid ADC conflict on I2S_NUM_0
-#define I2S_SAMPLE_RATE   44100
-#define I2S_BUFFER_SIZE   512
+#define I2S_SAMPLE_RATE   AUDIO_RATE_FULL  // AUDIO_RATE_HALF / AUDIO_RATE_LOW halve the render CPU (build the bank to match)
+#define I2S_BUFFER_SIZE   (I2S_SAMPLE_RATE > AUDIO_RATE_HALF ? 128 : 64)  // 2.9 ms per block (4 ms at 16 kHz; engine ramps rate/gain across each block)
+#define I2S_DMA_DESC_NUM  2           // DMA queue depth: 2 x 2.9 ms keeps stick-to-sound latency ~3-6 ms
+#define I2S_ADAPTIVE_DMA  true        // Grow the queue on underruns, shrink back after a clean spell (minimum I2S_DMA_DESC_NUM)
+
+// ==================== SENSOR SAMPLING ====================
+#define SENSOR_SAMPLE_HZ  50          // Fixed sampling rate for battery, water, throttle and servo
+#define SENSOR_RC_TIMEOUT_MS 500      // RC channel considered lost after this long without a frame
 
 // ==================== GLOBALS ====================
-WebServer server(80);
 DFRobot_DF1201S DF1201S;  // DFPlayer Pro object
 unsigned long startTime;
 bool ledRunningState = false;
 bool ledFloodState = false;
-bool dfPlayerAvailable = false;  // Track if DFPlayer is initialized
-bool adcInitialized = false;     // Track if ADC was initialized before I2S
+volatile bool dfPlayerAvailable = false;  // Set by the DFPlayer boot task once the queue is running
+bool adcInitialized = false;     // Track if continuous ADC was started before I2S
+
+// RC pulse widths as sampled (sensor task only) - handlers read SensorSample entries
+// from the ring buffer. The audio task gets throttle straight from the RMT ISR
+// (onThrottlePulse), not from these
+uint32_t throttle_pulse_us = 1500; // Cached throttle value (safe default)
+unsigned long last_throttle_update = 0;
+uint32_t servo_pulse_us = 0;       // Cached servo value (0 = no signal)
+unsigned long last_servo_update = 0;
+
+// Everything /telemetry reports, gathered once per response or stream frame
+// (sketch types used in function signatures are declared above the first function,
+// where the Arduino builder inserts its generated prototypes)
+typedef struct {
+  SensorSample sample;      // Latest fixed-rate sample (all-zero before the first pass)
+  uint32_t uptime_s;
+  int rssi;
+  uint32_t free_heap;
+  bool wifi_connected;
+  uint32_t ip;
+  bool engine_muted;
+  WaterSensorStats water;   // Wet duty cycle and onset times (alarm state is in sample.flags)
+} TelemetryValues;
+
+// GET /history chunked response in progress (handleHistory)
+typedef struct {
+  httpd_req_t* req;
+  char buf[1024];
+  size_t len;
+  uint32_t last_ts;         // Newest row sent (next_since)
+  bool first;
+  bool failed;              // Client went away - stop the query
+} HistoryStream;
+
+// ==================== BOOT TIMING ====================
+// Bring-up phases run concurrently (DFPlayer, WiFi and the startup flash in their own
+// tasks), so each phase records its own start and end (ms since app start, 0 = not yet).
+// Reported on /system-debug.
+typedef enum {
+  BOOT_SETUP = 0,       // Whole setup() (does not wait for the tasks below)
+  BOOT_ADC,
+  BOOT_WIFI,            // wifiLink_start -> first IP
+  BOOT_DFPLAYER,        // Power-up wait + MUSIC mode + prompt tone + queue start
+  BOOT_FLASH,           // Startup light flash
+  BOOT_RMT,
+  BOOT_I2S,
+  BOOT_AUDIO,
+  BOOT_SENSORS,
+  BOOT_OTA,
+  BOOT_HTTP,
+  BOOT_PHASE_COUNT
+} BootPhase;
+
+static const char* BOOT_PHASE_NAMES[BOOT_PHASE_COUNT] = {
+  "setup", "adc", "wifi", "dfplayer", "flash", "rmt", "i2s", "audio", "sensors", "ota", "http"
+};
+
+volatile uint32_t bootPhaseStartMs[BOOT_PHASE_COUNT];
+volatile uint32_t bootPhaseEndMs[BOOT_PHASE_COUNT];
+
+void bootPhaseBegin(BootPhase phase) {
+  bootPhaseStartMs[phase] = millis();
+}
 
-// RMT throttle capture variables (non-blocking PWM read)
-volatile uint32_t throttle_pulse_us = 1500; // Cached throttle value (safe default)
-volatile unsigned long last_throttle_update = 0;
+// First completion only (WiFi reconnects call this again)
+void bootPhaseEnd(BootPhase phase) {
+  if (bootPhaseEndMs[phase] == 0) bootPhaseEndMs[phase] = millis();
+}
 
-// Water sensor debouncing variables
-bool waterDebouncedState = false;  // Current debounced state (false = secure, true = breached)
-bool waterLastRawState = true;     // Last raw sensor reading (true = DRY, false = WET)
-unsigned long waterStateChangeTime = 0;  // Time when current raw state started
-const unsigned long WATER_DEBOUNCE_TIME = 10000;  // 10 seconds in milliseconds
+// ==================== PERF COUNTERS ====================
+// Fixed-size histograms (perf_stats.h), each written only by the task it measures.
+// Reported on /perf together with per-route latency and the task table.
+#define AUDIO_BLOCK_DEADLINE_US  ((uint32_t)(I2S_BUFFER_SIZE * 1000000ULL / I2S_SAMPLE_RATE))
 
-// WiFi connection state (persists for retry logic)
-String lastConnectedSSID = "";
-String lastConnectedPassword = "";
+PerfHistogram loopPerf = {};            // loop() start-to-start period (loopTask)
+PerfHistogram audioRenderPerf = {};     // audioEngine_renderSamples per block (AudioEngine task)
+PerfHistogram audioBlockPerf = {};      // Full block period incl. the I2S write wait
+PerfHistogram audioWritePerf = {};      // Render start to i2s_channel_write completion
+volatile uint32_t audioDeadlineMisses = 0;  // Blocks whose render took longer than the block plays
 
-// ==================== WIFI CONNECT (SCAN + MATCH) ====================
-// Scans available networks and connects in priority order:
+// ==================== WIFI NETWORKS ====================
+// Known networks in priority order (wifi_link tries the cached AP first, scans only if that fails):
 //   1. Home WiFi (HOME_WIFI_SSID exact match)
 //   2. iPhone hotspot (any SSID containing "iPhone", or exact WIFI_SSID match)
-//   3. Fallback to hardcoded WIFI_SSID
-void connectWiFi() {
-  Serial.println();
-  Serial.println("Scanning for WiFi networks...");
-
-  WiFi.disconnect(true);  // Clean disconnect before scanning
-  delay(100);
-  WiFi.mode(WIFI_STA);
-  int numNetworks = WiFi.scanNetworks();
-  
-  Serial.print("Scan complete. Networks found: ");
-  Serial.println(numNetworks);
-  
-  String ssidToConnect = "";
-  String passwordToUse = "";
-  bool foundHomeWiFi = false;
-  
-  // First pass: look for home WiFi (exact match)
-  for (int i = 0; i < numNetworks; i++) {
-    String scannedSSID = WiFi.SSID(i);
-    Serial.print("[");
-    Serial.print(i);
-    Serial.print("] SSID: '");
-    Serial.print(scannedSSID);
-    Serial.print("' | RSSI: ");
-    Serial.println(WiFi.RSSI(i));
-    
-    if (scannedSSID == HOME_WIFI_SSID) {
-      ssidToConnect = scannedSSID;
-      passwordToUse = HOME_WIFI_PASSWORD;
-      foundHomeWiFi = true;
-      Serial.print("Matched home WiFi: ");
-      Serial.println(ssidToConnect);
-      break;
-    }
-  }
-  
-  // Second pass: if home WiFi not found, look for iPhone hotspot
-  if (!foundHomeWiFi) {
-    for (int i = 0; i < numNetworks; i++) {
-      String scannedSSID = WiFi.SSID(i);
-      // Match any SSID containing "iPhone" OR exact match of configured hotspot SSID
-      if (scannedSSID.indexOf("iPhone") >= 0 || scannedSSID == WIFI_SSID) {
-        ssidToConnect = scannedSSID;
-        passwordToUse = WIFI_PASSWORD;
-        Serial.print("Home WiFi not found. Using hotspot: ");
-        Serial.println(ssidToConnect);
-        break;
-      }
-    }
-  }
-  
-  if (ssidToConnect.length() == 0) {
-    // Final fallback: use the configured SSID directly (blind connect)
-    ssidToConnect = WIFI_SSID;
-    passwordToUse = WIFI_PASSWORD;
-    Serial.print("No known networks found in scan. Blind-connecting to: ");
-    Serial.println(ssidToConnect);
-  }
+//   3. Fallback to hardcoded WIFI_SSID (blind connect when the scan does not see it)
+const WifiCandidate WIFI_NETWORKS[] = {
+  { HOME_WIFI_SSID, HOME_WIFI_PASSWORD, false, false },
+  { "iPhone",       WIFI_PASSWORD,      true,  false },
+  { WIFI_SSID,      WIFI_PASSWORD,      false, true  },
+};
+
+// mDNS records and UDP beacon reply (the app finds the boat without a subnet sweep)
+const DiscoveryInfo DISCOVERY_INFO = {
+  OTA_HOSTNAME,                   // Same hostname as OTA
+  "telemetry",
+  "Edmund Fitzgerald Telemetry",
+  FIRMWARE_VERSION,
+  BUILD_ID,
+  HTTP_SERVER_PORT,
+  0
+};
+
+// Runs in the WiFi link task after every (re)connection
+void onWiFiConnected() {
+  bootPhaseEnd(BOOT_WIFI);
+  Serial.printf("  OTA: edmund-fitzgerald @ %s\n", WiFi.localIP().toString().c_str());
+  timeSync_start();   // Same clock as the camera's frame stamps
+
+  // WiFi connected: visual feedback
+  flashRunningLights(2, 200, 200);
+}
 
-  // Store for retry logic
-  lastConnectedSSID = ssidToConnect;
-  lastConnectedPassword = passwordToUse;
+// ==================== STARTUP VISUAL FEEDBACK ====================
+// Flash patterns run in their own low-priority task, so the boot flash overlaps the rest
+// of setup() and the WiFi link task never sleeps through a flash
+typedef struct {
+  uint8_t times;
+  uint16_t on_ms;
+  uint16_t off_ms;
+} LightFlash;
 
-  Serial.print("Connecting to: ");
-  Serial.println(ssidToConnect);
-  
-  WiFi.begin(ssidToConnect.c_str(), passwordToUse.c_str());
-  Serial.print("Attempting connection");
+#define LIGHT_FLASH_GAP_MS 500   // Pause between queued patterns so they read as separate signals
 
-  int attempts = 0;
-  while (WiFi.status() != WL_CONNECTED && attempts < 40) {
-    delay(500);
-    Serial.print(".");
-    attempts++;
-  }
+QueueHandle_t lightFlashQueue = NULL;
 
-  if (WiFi.status() == WL_CONNECTED) {
-    Serial.println();
-    Serial.println("WiFi connected!");
-    Serial.print("IP address: ");
-    Serial.println(WiFi.localIP());
-    
-    // WiFi connected: visual feedback
-    delay(500);  // Brief pause after connection
-    flashRunningLights(2, 200, 200);
-  } else {
-    Serial.println();
-    Serial.print("WiFi connection failed. Status: ");
-    Serial.println(WiFi.status());
-    Serial.println("Server will start anyway. Will retry WiFi with full re-scan in loop.");
+void lightFlashTask(void* parameter) {
+  LightFlash flash;
+  while (true) {
+    if (xQueueReceive(lightFlashQueue, &flash, portMAX_DELAY) != pdTRUE) continue;
+    for (int i = 0; i < flash.times; i++) {
+      digitalWrite(LED_RUNNING_PIN, HIGH);
+      digitalWrite(RUNNING_OUT_PIN, HIGH);
+      vTaskDelay(pdMS_TO_TICKS(flash.on_ms));
+      digitalWrite(LED_RUNNING_PIN, LOW);
+      digitalWrite(RUNNING_OUT_PIN, LOW);
+      if (i < flash.times - 1) {  // Don't delay after the last flash
+        vTaskDelay(pdMS_TO_TICKS(flash.off_ms));
+      }
+    }
+    // Back to whatever /led last asked for
+    digitalWrite(LED_RUNNING_PIN, ledRunningState ? HIGH : LOW);
+    digitalWrite(RUNNING_OUT_PIN, ledRunningState ? HIGH : LOW);
+    bootPhaseEnd(BOOT_FLASH);
+    vTaskDelay(pdMS_TO_TICKS(LIGHT_FLASH_GAP_MS));
   }
 }
 
-// ==================== STARTUP VISUAL FEEDBACK ====================
-// Flash the running lights to provide visual feedback during startup
+void setupLightFlash() {
+  lightFlashQueue = xQueueCreate(4, sizeof(LightFlash));
+  xTaskCreatePinnedToCore(lightFlashTask, "Lights", 2048, NULL, 1, NULL, 0);
+}
+
+// Flash the running lights (returns immediately; patterns play in order)
 void flashRunningLights(int times, int onMs, int offMs) {
-  for (int i = 0; i < times; i++) {
-    digitalWrite(LED_RUNNING_PIN, HIGH);
-    digitalWrite(RUNNING_OUT_PIN, HIGH);
-    delay(onMs);
-    digitalWrite(LED_RUNNING_PIN, LOW);
-    digitalWrite(RUNNING_OUT_PIN, LOW);
-    if (i < times - 1) {  // Don't delay after the last flash
-      delay(offMs);
-    }
-  }
+  if (lightFlashQueue == NULL) return;
+  LightFlash flash = { (uint8_t)times, (uint16_t)onMs, (uint16_t)offMs };
+  xQueueSend(lightFlashQueue, &flash, 0);
 }
 
-// ==================== WATER SENSOR DEBOUNCING ====================
-// Updates the debounced water state based on raw sensor readings
-// Water must stay in same state for WATER_DEBOUNCE_TIME to register state change
-void updateWaterSensorDebounce() {
-  bool rawState = (digitalRead(WATER_SENSOR_PIN) == HIGH);  // true = dry, false = wet
-  unsigned long currentTime = millis();
-  
-  // Check if raw state has changed
-  if (rawState != waterLastRawState) {
-    // Raw state changed, reset the timer
-    waterLastRawState = rawState;
-    waterStateChangeTime = currentTime;
+// ==================== DFPLAYER BRING-UP ====================
+// The DF1201S needs time after power-up before it answers, and MUSIC mode plays a
+// prompt tone that must finish before further commands. That is ~5 s of waiting, so it
+// runs in a one-shot task while setup() carries on; horn/SOS/radio report the player
+// unavailable until dfPlayerAvailable is set.
+#define DFPLAYER_POWERUP_MS     3000    // Since app start, before DF1201S.begin()
+#define DFPLAYER_PROMPT_MS      2000    // MUSIC mode prompt tone
+#define DFPLAYER_SETUP_GAP_MS   200     // Between the initial mode/volume commands
+
+void dfPlayerBootTask(void* parameter) {
+  bootPhaseBegin(BOOT_DFPLAYER);
+  uint32_t elapsed = millis();
+  if (elapsed < DFPLAYER_POWERUP_MS) vTaskDelay(pdMS_TO_TICKS(DFPLAYER_POWERUP_MS - elapsed));
+
+  Serial.println("DFPlayer: attempting DF1201S.begin()...");
+  if (!DF1201S.begin(Serial2)) {
+    Serial.println("✗ DFPlayer Pro init failed!");
+    Serial.println("  Check: Power, wiring, or try power-cycling ESP32");
+    dfPlayerAvailable = false;
   } else {
-    // Raw state is the same, check if debounce time has elapsed
-    unsigned long timeSinceChange = currentTime - waterStateChangeTime;
-    
-    if (timeSinceChange >= WATER_DEBOUNCE_TIME) {
-      // Debounce time elapsed, update the debounced state
-      // rawState = true means DRY, so waterDebouncedState = false (secure)
-      // rawState = false means WET, so waterDebouncedState = true (breached)
-      waterDebouncedState = !rawState;
-    }
+    Serial.println("✓ DFPlayer Pro connected! Switching to MUSIC mode...");
+    DF1201S.switchFunction(DF1201S.MUSIC);
+    vTaskDelay(pdMS_TO_TICKS(DFPLAYER_PROMPT_MS));  // Wait for prompt tone
+
+    // Play once, initial volume 20/30
+    DF1201S.setPlayMode(DF1201S.SINGLE);
+    vTaskDelay(pdMS_TO_TICKS(DFPLAYER_SETUP_GAP_MS));
+    DF1201S.setVol(20);
+    vTaskDelay(pdMS_TO_TICKS(DFPLAYER_SETUP_GAP_MS));
+
+    // Playback requests go through the DFPlayer task from here on
+    dfPlayerAvailable = dfPlayer_start(&DF1201S, &Serial2);
+    if (dfPlayerAvailable) Serial.println("✓ DFPlayer Pro ready for playback!");
   }
+  bootPhaseEnd(BOOT_DFPLAYER);
+  vTaskDelete(NULL);
+}
+
+// ==================== RC CAPTURE (RMT RX, PER-FRAME ISR) ====================
+// Map RC pulse width to engine throttle (1000 us = idle, 2000 us = full)
+float throttleNormalized(uint32_t pulse_us) {
+  float throttle_norm = (pulse_us - 1000.0f) / 1000.0f;
+  return constrain(throttle_norm, 0.0f, 1.0f);
+}
+
+// RMT ISR, once per valid throttle frame: post straight to the audio engine, so
+// stick-to-pitch latency is one PWM frame however busy the other tasks are.
+// Same mapping as throttleNormalized(), in integers (no FPU in an ISR)
+void IRAM_ATTR onThrottlePulse(uint32_t pulse_us) {
+  uint32_t clamped = pulse_us < 1000 ? 1000 : (pulse_us > 2000 ? 2000 : pulse_us);
+  audioEngine_postThrottleQ16((clamped - 1000) * 65536 / 1000);
 }
 
-// ==================== RMT THROTTLE CAPTURE (NON-BLOCKING PWM) ====================
-// Initialize RMT for throttle PWM capture
+// Initialize RMT RX for throttle and servo PWM capture
 void setupRMT() {
-  rmt_config_t rmt_rx_config = RMT_DEFAULT_CONFIG_RX((gpio_num_t)THROTTLE_PWM_PIN, RMT_RX_CHANNEL);
-  rmt_rx_config.clk_div = RMT_CLK_DIV;
-  rmt_config(&rmt_rx_config);
-  rmt_driver_install(RMT_RX_CHANNEL, 1000, 0);
-  rmt_rx_start(RMT_RX_CHANNEL, true);
+  bool throttleOk = rcCapture_init(RC_THROTTLE, THROTTLE_PWM_PIN, onThrottlePulse);
+  bool servoOk = rcCapture_init(RC_SERVO, SERVO_PWM_PIN, NULL);
   
-  Serial.println("RMT PWM capture initialized on GPIO18");
+  Serial.println("RMT PWM capture initialized (RX driver, per-frame callback)");
+  Serial.printf("  Throttle: GPIO%d %s\n", THROTTLE_PWM_PIN, throttleOk ? "✓" : "✗");
+  Serial.printf("  Servo:    GPIO%d %s\n", SERVO_PWM_PIN, servoOk ? "✓" : "✗");
   Serial.println("  Clock: 1 MHz (1 tick = 1 us)");
-  Serial.println("  Expected range: 1000-2000 us");
+  Serial.printf("  Expected range: 1000-2000 us (accepted %d-%d)\n", RC_PULSE_MIN_US, RC_PULSE_MAX_US);
 }
 
-// Update throttle value from RMT (call periodically from loop)
+// Sample the throttle captured by the ISR (sensor task)
 void updateThrottleRMT() {
-  size_t rx_size = 0;
-  rmt_item32_t* items = NULL;
-  RingbufHandle_t rb = NULL;
-  
-  // Get ringbuffer handle
-  rmt_get_ringbuf_handle(RMT_RX_CHANNEL, &rb);
-  
-  // Non-blocking receive with immediate timeout
-  items = (rmt_item32_t*) xRingbufferReceive(rb, &rx_size, 0);
-  
-  if (items) {
-    // Parse RMT items to extract pulse width
-    uint32_t high_ticks = 0;
-    for (size_t i = 0; i < rx_size / sizeof(rmt_item32_t); i++) {
-      if (items[i].level0 == 1) {  // HIGH portion of PWM
-        high_ticks += items[i].duration0;
-      }
-      if (items[i].level1 == 1) {
-        high_ticks += items[i].duration1;
-      }
-    }
-    
-    // Convert ticks to microseconds (1 tick = 1us at 1MHz clock)
-    uint32_t pulse_us = high_ticks;
-    
-    // Validate range (typical RC PWM: 1000-2000us)
-    if (pulse_us >= 800 && pulse_us <= 2200) {
-      throttle_pulse_us = pulse_us;
-      last_throttle_update = millis();
-    }
-    
-    // Return buffer to ringbuffer
-    vRingbufferReturnItem(rb, (void*) items);
-  }
-  
-  // Timeout handling: revert to safe idle if no signal
-  if (millis() - last_throttle_update > 500) {
+  uint32_t pulse_us, age_ms;
+  if (rcCapture_latest(RC_THROTTLE, &pulse_us, &age_ms) && age_ms <= SENSOR_RC_TIMEOUT_MS) {
+    throttle_pulse_us = pulse_us;
+    last_throttle_update = millis() - age_ms;
+  } else {
+    // Timeout handling: revert to neutral if no signal. The ISR stops posting without
+    // frames, so the fallback is posted from here (and replaced by the next frame)
     throttle_pulse_us = 1500;  // neutral position
+    audioEngine_postThrottle(throttleNormalized(throttle_pulse_us));
   }
 }
 
-// ==================== I2S AUDIO OUTPUT ====================
-// Initialize I2S driver for MAX98357A amplifier using NEW ESP-IDF 5.x API
-i2s_chan_handle_t i2s_tx_handle = NULL;
+// Sample the servo captured by the ISR (sensor task)
+void updateServoRMT() {
+  uint32_t pulse_us, age_ms;
+  if (rcCapture_latest(RC_SERVO, &pulse_us, &age_ms) && age_ms <= SENSOR_RC_TIMEOUT_MS) {
+    servo_pulse_us = pulse_us;
+    last_servo_update = millis() - age_ms;
+  } else {
+    // Timeout handling: report no signal (same as the old pulseIn timeout)
+    servo_pulse_us = 0;
+  }
+}
 
+// ==================== I2S AUDIO OUTPUT ====================
+// MAX98357A amplifier on the new ESP-IDF 5.x I2S driver (i2s_output.h: underrun
+// counters, adaptive DMA depth)
 void setupI2S() {
   Serial.println("Initializing I2S for MAX98357A (new driver)...");
   
-  // Channel configuration
-  i2s_chan_config_t chan_cfg = I2S_CHANNEL_DEFAULT_CONFIG(I2S_NUM, I2S_ROLE_MASTER);
-  chan_cfg.dma_desc_num = 4;
-  chan_cfg.dma_frame_num = I2S_BUFFER_SIZE;
-  
-  esp_err_t err = i2s_new_channel(&chan_cfg, &i2s_tx_handle, NULL);
-  if (err != ESP_OK) {
-    Serial.printf("ERROR: I2S channel creation failed: %d\n", err);
-    return;
-  }
-  
-  // Standard mode configuration (Philips I2S)
-  i2s_std_config_t std_cfg = {
-    .clk_cfg = I2S_STD_CLK_DEFAULT_CONFIG(I2S_SAMPLE_RATE),
-    .slot_cfg = I2S_STD_PHILIPS_SLOT_DEFAULT_CONFIG(I2S_DATA_BIT_WIDTH_16BIT, I2S_SLOT_MODE_MONO),
-    .gpio_cfg = {
-      .mclk = I2S_GPIO_UNUSED,
-      .bclk = (gpio_num_t)I2S_BCLK_PIN,
-      .ws = (gpio_num_t)I2S_LRC_PIN,
-      .dout = (gpio_num_t)I2S_DIN_PIN,
-      .din = I2S_GPIO_UNUSED,
-      .invert_flags = {
-        .mclk_inv = false,
-        .bclk_inv = false,
-        .ws_inv = false,
-      },
-    },
+  I2sOutputConfig cfg = {
+    I2S_NUM,
+    I2S_SAMPLE_RATE,
+    I2S_BCLK_PIN,
+    I2S_LRC_PIN,
+    I2S_DIN_PIN,
+    I2S_BUFFER_SIZE,
+    I2S_DMA_DESC_NUM,
+    I2S_ADAPTIVE_DMA
   };
-  
-  err = i2s_channel_init_std_mode(i2s_tx_handle, &std_cfg);
-  if (err != ESP_OK) {
-    Serial.printf("ERROR: I2S std mode init failed: %d\n", err);
-    return;
-  }
-  
-  err = i2s_channel_enable(i2s_tx_handle);
-  if (err != ESP_OK) {
-    Serial.printf("ERROR: I2S channel enable failed: %d\n", err);
+  if (!i2sOutput_init(&cfg)) {
     return;
   }
   
   Serial.println("  ✓ I2S driver installed (NEW API)");
   Serial.printf("  Sample rate: %d Hz\n", I2S_SAMPLE_RATE);
+  Serial.printf("  DMA: %d x %d frames%s\n", I2S_DMA_DESC_NUM, I2S_BUFFER_SIZE,
+                I2S_ADAPTIVE_DMA ? " (adaptive)" : "");
   Serial.printf("  Pins: BCLK=%d, LRC=%d, DIN=%d\n", I2S_BCLK_PIN, I2S_LRC_PIN, I2S_DIN_PIN);
 }
 
@@ -321,23 +355,36 @@ void setupI2S() {
 // FreeRTOS task for continuous audio rendering
 void audioTaskFunction(void* param) {
   int16_t audio_buffer[I2S_BUFFER_SIZE];
-  size_t bytes_written;
+  int64_t lastBlockEnd = 0;
   
   Serial.println("Audio engine task started on Core 1");
   
   while (true) {
-    // Read cached throttle from RMT
-    float throttle_norm = (throttle_pulse_us - 1000.0f) / 1000.0f;
-    throttle_norm = constrain(throttle_norm, 0.0f, 1.0f);
+    // Apply queued control commands and the posted throttle
+    // (applies smoothing, rev detection, etc.)
+    audioEngine_processControl();
     
-    // Update engine state (applies smoothing, rev detection, etc.)
-    audioEngine_updateThrottle(throttle_norm);
+    // Requested by POST /engine-bench: output pauses while the scripts run
+    if (audioEngine_benchmarkPending()) {
+      i2sOutput_suspend();
+      audioEngine_runBenchmark();
+      i2sOutput_resume();
+      lastBlockEnd = 0;
+    }
     
-    // Render PCM samples into buffer
+    // Render PCM samples into buffer (also publishes the engine telemetry snapshot)
+    int64_t renderStart = esp_timer_get_time();
     audioEngine_renderSamples(audio_buffer, I2S_BUFFER_SIZE);
+    uint32_t renderUs = (uint32_t)(esp_timer_get_time() - renderStart);
+    perfHist_record(&audioRenderPerf, renderUs);
+    if (renderUs > AUDIO_BLOCK_DEADLINE_US) audioDeadlineMisses++;
     
-    // Write to I2S using NEW API (blocks until DMA buffer has space)
-    i2s_channel_write(i2s_tx_handle, audio_buffer, I2S_BUFFER_SIZE * 2, &bytes_written, portMAX_DELAY);
+    // Write to I2S (blocks until a DMA descriptor is free)
+    i2sOutput_write(audio_buffer, I2S_BUFFER_SIZE);
+    int64_t blockEnd = esp_timer_get_time();
+    perfHist_record(&audioWritePerf, (uint32_t)(blockEnd - renderStart));
+    if (lastBlockEnd != 0) perfHist_record(&audioBlockPerf, (uint32_t)(blockEnd - lastBlockEnd));
+    lastBlockEnd = blockEnd;
   }
 }
 
@@ -356,210 +403,716 @@ void setupAudioTask() {
   Serial.println("Audio engine task created on Core 1 (priority 5)");
 }
 
-// ==================== DFPLAYER AUDIO FUNCTIONS ====================
-// Play DFPlayer Pro track using DF1201S library
-void playDFPlayerTrack(int trackNumber, int volumePercent) {
-  if (!dfPlayerAvailable) return;
-  
-  // Set volume (0-30 for DF1201S)
-  int volume = map(volumePercent, 0, 100, 0, 30);
-  DF1201S.setVol(volume);
-  delay(50);
+// ==================== SENSOR SAMPLING TASK ====================
+// Samples every input at SENSOR_SAMPLE_HZ on core 0, so sampling jitter no longer
+// depends on how busy loop()/HTTP is. Each pass appends one SensorSample to the ring.
+void sensorTaskFunction(void* parameter) {
+  Serial.printf("Sensor task started on core %d (%d Hz)\n", xPortGetCoreID(), SENSOR_SAMPLE_HZ);
   
-  // Play file by number (based on write order to module)
-  DF1201S.playFileNum(trackNumber);
+  const TickType_t period = pdMS_TO_TICKS(1000 / SENSOR_SAMPLE_HZ);
+  TickType_t lastWake = xTaskGetTickCount();
   
-  Serial.print("DFPlayer Pro: Track ");
-  Serial.print(trackNumber);
-  Serial.print(" @ ");
-  Serial.print(volumePercent);
-  Serial.println("%");
+  while (true) {
+    // RC inputs (pulses arrive from the RMT ISR; re-arm a channel it could not)
+    rcCapture_poll();
+    updateThrottleRMT();
+    updateServoRMT();
+    
+    // Water sensor: debounce the edges the interrupt queued since the last pass
+    waterSensor_update();
+    
+    // Battery: fold in the DMA frame(s) finished since the last pass
+    batteryMonitor_update();
+    
+    unsigned long now = millis();
+    SensorSample sample = {};
+    sample.timestamp_ms = now;
+    sample.battery_raw = batteryMonitor_getRaw();
+    sample.battery_mv = batteryMonitor_getMillivolts();
+    if (batteryMonitor_isLow()) sample.flags |= SENSOR_FLAG_BATTERY_LOW;
+    sample.throttle_us = throttle_pulse_us;
+    sample.servo_us = servo_pulse_us;
+    if (waterSensor_isRawDry()) sample.flags |= SENSOR_FLAG_WATER_RAW_DRY;
+    if (waterSensor_isBreached()) sample.flags |= SENSOR_FLAG_WATER_BREACHED;
+    unsigned long throttleAge = now - last_throttle_update;
+    unsigned long servoAge = now - last_servo_update;
+    sample.throttle_age_ms = min(throttleAge, 65535UL);
+    sample.servo_age_ms = min(servoAge, 65535UL);
+    if (throttleAge <= SENSOR_RC_TIMEOUT_MS) sample.flags |= SENSOR_FLAG_THROTTLE_VALID;
+    if (servoAge <= SENSOR_RC_TIMEOUT_MS) sample.flags |= SENSOR_FLAG_SERVO_VALID;
+    sensorRing_push(sample);
+    
+    vTaskDelayUntil(&lastWake, period);
+  }
 }
 
-// Play Edmund Fitzgerald easter egg by file path (avoids index dependency)
-void playEdmundEasterEgg() {
-  if (!dfPlayerAvailable) return;
-  
-  // Set volume for easter egg (85%)
-  int volume = map(85, 0, 100, 0, 30);  // 85% = 25.5/30
-  DF1201S.setVol(volume);
-  delay(100);
-  
-  // Force SINGLE play mode
-  DF1201S.setPlayMode(DF1201S.SINGLE);
-  delay(50);
+// Create sensor task on core 0 (audio owns core 1)
+void setupSensorTask() {
+  sensorRing_init();
+  xTaskCreatePinnedToCore(
+    sensorTaskFunction,
+    "Sensors",
+    4096,          // stack size (4KB)
+    NULL,          // no parameters
+    3,             // priority (above loop, below audio)
+    NULL,          // no task handle needed
+    0              // core 0 (alongside WiFi, off the audio core)
+  );
   
-  // Play by file path using raw AT command (bypasses FileNumber index)
-  // AT+PLAYFILE requires CRLF termination
-  Serial.println("Playing Edmund Fitzgerald easter egg...");
-  Serial2.print("AT+PLAYFILE=/SFX/EDMUND.MP3\r\n");
-  Serial2.flush();
-  delay(100);
+  Serial.println("Sensor task created on Core 0 (priority 3)");
 }
 
-// ==================== CORS HELPER ====================
-void addCORSHeaders() {
-  server.sendHeader("Access-Control-Allow-Origin", "*");
-  server.sendHeader("Access-Control-Allow-Methods", "GET, POST, OPTIONS");
-  server.sendHeader("Access-Control-Allow-Headers", "Content-Type");
+// ==================== REQUEST HELPERS ====================
+// Every response body is built in a per-request stack buffer (json_writer.h) and
+// sent with httpServer_sendJson() - CORS headers come from the route dispatcher
+
+// Request body for the POST controls ("" when missing or larger than HTTP_BODY_MAX)
+void readRequestBody(httpd_req_t* req, char* body, size_t cap) {
+  if (httpServer_readBody(req, body, cap) < 0) body[0] = '\0';
 }
 
-// ==================== RC PWM READER ====================
-// Reads PWM pulse width in microseconds (typical RC: 1000-2000µs, 1500µs = center)
-unsigned int readPWM(int pin) {
-  unsigned long pulseWidth = pulseIn(pin, HIGH, 25000); // 25ms timeout (50Hz = 20ms period)
-  if (pulseWidth == 0) {
-    return 0; // No signal or timeout
+// Binary telemetry is opt-in: ?format=bin or an Accept header naming the frame type
+bool wantsBinaryTelemetry(httpd_req_t* req) {
+  char format[8];
+  if (httpServer_queryValue(req, "format", format, sizeof(format))) {
+    return strcmp(format, "bin") == 0;
   }
-  return (unsigned int)pulseWidth;
+  return httpServer_headerContains(req, "Accept", TELEMETRY_FRAME_MIME);
 }
 
 // ==================== HTTP HANDLERS ====================
-void handleStatus() {
-  addCORSHeaders();
+esp_err_t handleStatus(httpd_req_t* req) {
   unsigned long uptimeSec = (millis() - startTime) / 1000;
-  String json = "{";
-  json += "\"type\":\"telemetry\",";
-  json += "\"name\":\"Edmund Fitzgerald Telemetry\",";
-  json += "\"firmware_version\":\"" + String(FIRMWARE_VERSION) + "\",";
-  json += "\"build_id\":\"" + String(BUILD_ID) + "\",";
-  json += "\"connected\":" + String(WiFi.status() == WL_CONNECTED ? "true" : "false") + ",";
-  json += "\"ip_address\":\"" + WiFi.localIP().toString() + "\",";
-  json += "\"uptime_seconds\":" + String(uptimeSec) + ",";
-  json += "\"running_led\":" + String(ledRunningState ? "true" : "false") + ",";
-  json += "\"flood_led\":" + String(ledFloodState ? "true" : "false") + ",";
-  json += "\"dfplayer_available\":" + String(dfPlayerAvailable ? "true" : "false");
-  json += "}";
-  server.send(200, "application/json", json);
-}
-
-void handleTelemetry() {
-  addCORSHeaders();
-  unsigned long uptimeSec = (millis() - startTime) / 1000;
-  int rssi = WiFi.RSSI();
+  char buf[JSON_RESPONSE_MAX];
+  JsonWriter json(buf, sizeof(buf));
+  json.addString("type", "telemetry");
+  json.addString("name", "Edmund Fitzgerald Telemetry");
+  json.addString("firmware_version", FIRMWARE_VERSION);
+  json.addString("build_id", BUILD_ID);
+  json.addBool("connected", WiFi.status() == WL_CONNECTED);
+  json.addIp("ip_address", WiFi.localIP());
+  json.addUInt("uptime_seconds", uptimeSec);
+  json.addBool("running_led", ledRunningState);
+  json.addBool("flood_led", ledFloodState);
+  json.addBool("dfplayer_available", dfPlayerAvailable);
+  json.addBool("clock_synced", timeSync_isSynced());
+  return httpServer_sendJson(req, 200, json);
+}
+
+void readTelemetryValues(TelemetryValues* v) {
+  memset(v, 0, sizeof(*v));
+  sensorRing_latest(&v->sample);
+  v->uptime_s = (millis() - startTime) / 1000;
+  v->rssi = WiFi.RSSI();
+  v->free_heap = ESP.getFreeHeap();
+  // float internalTemp = temperatureRead();  // Disabled: conflicts with analogRead() in ESP-IDF 5.x
+  v->wifi_connected = WiFi.status() == WL_CONNECTED;
+  v->ip = WiFi.localIP();
+  v->engine_muted = audioEngine_getMuted();
+  waterSensor_getStats(&v->water);
+}
+
+// /telemetry JSON fields (also the /telemetry/stream keyframe - keep the order stable,
+// stream deltas are tracked per field position)
+void writeTelemetryJson(JsonWriter& json, const TelemetryValues& v) {
+  const SensorSample& sample = v.sample;
   
-  // Battery voltage reading (GPIO 34 ADC)
-  // Using Arduino's analogRead() - must be initialized BEFORE I2S to avoid driver conflict
-  int adcValue = adcInitialized ? analogRead(BATTERY_ADC_PIN) : 0;
-  // ADC: 0-4095 maps to 0-3.3V (12-bit)
-  float batteryPinVoltage = (adcValue / 4095.0) * 3.3;
-  // Calibration: Voltage divider 100kΩ + 47kΩ, 3.3V input was reading 1.16V
-  float batteryVoltage = batteryPinVoltage * 2.84;
+  // Battery voltage (GPIO 34, oversampled + median/IIR filtered, calibrated mV)
+  // Voltage divider 100kΩ + 47kΩ: pack = pin * 147 / 47
+  float batteryVoltage = sample.battery_mv / 1000.0f;
+  float batteryPinVoltage = batteryVoltage / BATTERY_DIVIDER_RATIO;
   
-  // Water intrusion sensor (debounced digital read with pullup)
+  // Water intrusion sensor (edge interrupt with pullup, water_sensor.h)
   // Debounced state: true = water breached hull, false = hull secure
-  // Takes 10 seconds of consistent state to register a change
-  bool waterDetected = waterDebouncedState;
-  int waterRaw = digitalRead(WATER_SENSOR_PIN); // 0 = WET, 1 = DRY (pullup) - raw instantaneous value
-
-  // RC receiver PWM readings (pulse width in microseconds)
-  // Typical range: 1000-2000µs, 1500µs = center/neutral
-  // Throttle is captured via RMT (non-blocking), servo still uses blocking pulseIn
-  unsigned int throttlePWM = throttle_pulse_us;  // From RMT cache
-  unsigned int servoPWM = readPWM(SERVO_PWM_PIN);  // Servo still uses old method
-
-  // ESP32 diagnostics
-  uint32_t freeHeap = ESP.getFreeHeap();
-  // float internalTemp = temperatureRead();  // Disabled: conflicts with analogRead() in ESP-IDF 5.x
+  // Takes WATER_DEBOUNCE_MS (10 s) of consistent state to register a change
+  bool waterDetected = (sample.flags & SENSOR_FLAG_WATER_BREACHED) != 0;
+  int waterRaw = (sample.flags & SENSOR_FLAG_WATER_RAW_DRY) ? 1 : 0; // 0 = WET, 1 = DRY (pullup) - raw value at sampling time
+
+  // Some fields are strings with units for compatibility with existing app/logger parsers
+  char timestamp[12], voltage[12], pinVoltage[12], signal[12];
+  snprintf(timestamp, sizeof(timestamp), "%lu", (unsigned long)sample.timestamp_ms);
+  snprintf(voltage, sizeof(voltage), "%.2fV", batteryVoltage);
+  snprintf(pinVoltage, sizeof(pinVoltage), "%.2fV", batteryPinVoltage);
+  snprintf(signal, sizeof(signal), "%ddBm", v.rssi);
+
+  json.addString("timestamp", timestamp);
+  // Sample time on the clock the camera stamps frames with (X-Timestamp), 0 until SNTP syncs
+  json.addUInt64("timestamp_epoch_ms", timeSync_epochUs((int64_t)sample.timestamp_ms * 1000) / 1000);
+  json.addString("battery_voltage", voltage);
+  json.addString("battery_pin_voltage", pinVoltage);
+  json.addUInt("battery_adc_raw", sample.battery_raw);
+  json.addBool("battery_low", (sample.flags & SENSOR_FLAG_BATTERY_LOW) != 0);
+  json.addString("signal_strength", signal);
+  json.addUInt("uptime_seconds", v.uptime_s);
+  json.addUInt("free_heap", v.free_heap);
+  json.addBool("running_mode_state", ledRunningState);
+  json.addBool("flood_mode_state", ledFloodState);
+  json.addBool("dfplayer_available", dfPlayerAvailable);
+  json.addBool("water_intrusion", waterDetected);
+  json.addInt("water_sensor_raw", waterRaw);
+  json.addUInt("water_wet_duty_pct", v.water.wet_duty_pct);   // Raw wet time over the last minute
+  json.addUInt("water_first_wet_ms", v.water.first_wet_ms);   // millis() of the first wet edge (0 = never)
+  json.addUInt("water_wet_onset_ms", v.water.wet_onset_ms);   // Start of the current / last wet spell
+  // RC receiver PWM (pulse width in µs, 1500 = neutral) - cached RMT values, never blocking
+  json.addUInt("throttle_pwm", sample.throttle_us);
+  json.addUInt("servo_pwm", sample.servo_us);      // 0 = no signal
+  json.addUInt("throttle_age_ms", sample.throttle_age_ms);
+  json.addUInt("servo_age_ms", sample.servo_age_ms);
+  json.addBool("engine_muted", v.engine_muted);
+  json.addString("connection_status", v.wifi_connected ? "online" : "offline");
+  json.addIp("ip_address", v.ip);
+}
 
-  String json = "{";
-  json += "\"timestamp\":\"" + String(millis()) + "\",";
-  json += "\"battery_voltage\":\"" + String(batteryVoltage, 2) + "V\",";
-  json += "\"battery_pin_voltage\":\"" + String(batteryPinVoltage, 2) + "V\",";
-  json += "\"battery_adc_raw\":" + String(adcValue) + ",";
-  json += "\"signal_strength\":\"" + String(rssi) + "dBm\",";
-  json += "\"uptime_seconds\":" + String(uptimeSec) + ",";
-  json += "\"free_heap\":" + String(freeHeap) + ",";
-  json += "\"running_mode_state\":" + String(ledRunningState ? "true" : "false") + ",";
-  json += "\"flood_mode_state\":" + String(ledFloodState ? "true" : "false") + ",";
-  json += "\"dfplayer_available\":" + String(dfPlayerAvailable ? "true" : "false") + ",";
-  json += "\"water_intrusion\":" + String(waterDetected ? "true" : "false") + ",";
-  json += "\"water_sensor_raw\":" + String(waterRaw) + ",";
-  json += "\"throttle_pwm\":" + String(throttlePWM) + ",";
-  json += "\"servo_pwm\":" + String(servoPWM) + ",";
-  json += "\"engine_muted\":" + String(audioEngine_getMuted() ? "true" : "false") + ",";
-  json += "\"connection_status\":\"" + String(WiFi.status() == WL_CONNECTED ? "online" : "offline") + "\",";
-  json += "\"ip_address\":\"" + WiFi.localIP().toString() + "\"";
-  json += "}";
-  server.send(200, "application/json", json);
-}
-
-void handleEngineDebug() {
-  addCORSHeaders();
-  
-  // Get raw and normalized throttle values
-  float throttle_norm = (throttle_pulse_us - 1000.0f) / 1000.0f;
-  throttle_norm = constrain(throttle_norm, 0.0f, 1.0f);
-  
-  // Get current engine state
-  float engine_rate = audioEngine_getRate();
-  float engine_gain = audioEngine_getGain();
-  float smoothed = audioEngine_getSmoothedThrottle();
-  bool rev_active = audioEngine_isRevActive();
-  
-  String json = "{";
-  json += "\"throttle_raw_us\":" + String(throttle_pulse_us) + ",";
-  json += "\"throttle_normalized\":" + String(throttle_norm, 3) + ",";
-  json += "\"throttle_smoothed\":" + String(smoothed, 3) + ",";
-  json += "\"engine_rate\":" + String(engine_rate, 3) + ",";
-  json += "\"engine_gain\":" + String(engine_gain, 3) + ",";
-  json += "\"rev_active\":" + String(rev_active ? "true" : "false") + ",";
-  json += "\"last_update_ms\":" + String(last_throttle_update);
-  json += "}";
-  
-  server.send(200, "application/json", json);
-}
-
-void handleEngineMute() {
-  addCORSHeaders();
-  if (server.method() != HTTP_POST) {
-    server.send(405, "application/json", "{\"error\":\"POST required\"}");
-    return;
+void fillTelemetryFrame(TelemetryFrame* frame, const TelemetryValues& v) {
+  const SensorSample& sample = v.sample;
+  memset(frame, 0, sizeof(*frame));
+  frame->magic = TELEMETRY_FRAME_MAGIC;
+  frame->version = TELEMETRY_FRAME_VERSION;
+  if (sample.flags & SENSOR_FLAG_WATER_BREACHED) frame->flags |= TELEMETRY_FLAG_WATER_INTRUSION;
+  if (sample.flags & SENSOR_FLAG_WATER_RAW_DRY) frame->flags |= TELEMETRY_FLAG_WATER_RAW_DRY;
+  if (sample.flags & SENSOR_FLAG_BATTERY_LOW) frame->flags |= TELEMETRY_FLAG_BATTERY_LOW;
+  if (ledRunningState) frame->flags |= TELEMETRY_FLAG_RUNNING_LIGHTS;
+  if (ledFloodState) frame->flags |= TELEMETRY_FLAG_FLOOD_LIGHTS;
+  if (dfPlayerAvailable) frame->flags |= TELEMETRY_FLAG_DFPLAYER;
+  if (v.engine_muted) frame->flags |= TELEMETRY_FLAG_ENGINE_MUTED;
+  if (v.wifi_connected) frame->flags |= TELEMETRY_FLAG_WIFI_CONNECTED;
+  frame->timestamp_ms = sample.timestamp_ms;
+  frame->uptime_s = v.uptime_s;
+  frame->free_heap = v.free_heap;
+  frame->sensor_seq = sample.seq;
+  memcpy(frame->ip, &v.ip, sizeof(frame->ip));  // IPAddress dword is already in octet order
+  frame->battery_mv = sample.battery_mv;
+  frame->battery_pin_mv = (uint16_t)(sample.battery_mv / BATTERY_DIVIDER_RATIO + 0.5f);
+  frame->battery_adc_raw = sample.battery_raw;
+  frame->throttle_us = sample.throttle_us;
+  frame->servo_us = sample.servo_us;
+  frame->throttle_age_ms = sample.throttle_age_ms;
+  frame->servo_age_ms = sample.servo_age_ms;
+  frame->rssi_dbm = (int8_t)constrain(v.rssi, -128, 0);
+  frame->water_wet_duty_pct = v.water.wet_duty_pct;
+}
+
+esp_err_t handleTelemetry(httpd_req_t* req) {
+  TelemetryValues values;
+  readTelemetryValues(&values);
+
+  if (wantsBinaryTelemetry(req)) {
+    TelemetryFrame frame;
+    fillTelemetryFrame(&frame, values);
+    return httpServer_send(req, 200, TELEMETRY_FRAME_MIME, &frame, sizeof(frame));
   }
 
-  String body = server.arg("plain");
-  
+  char buf[JSON_RESPONSE_MAX];
+  JsonWriter json(buf, sizeof(buf));
+  writeTelemetryJson(json, values);
+  return httpServer_sendJson(req, 200, json);
+}
+
+// ==================== TELEMETRY STREAM (SERVER-SENT EVENTS) ====================
+// GET /telemetry/stream?hz=N (1-20, default 5) keeps the connection open and pushes
+// "telemetry" events built from the latest sensor sample. The first event and one
+// every TELEMETRY_STREAM_KEYFRAME_MS carry every field; the rest carry only the
+// fields whose value changed since the previous event on that connection.
+//
+// The handler only writes the response head and keeps the socket. Events are sent
+// from the HTTP server task itself (httpd_queue_work, kicked by a periodic timer),
+// so stream state is only ever touched by that one task.
+#define TELEMETRY_STREAM_MAX_CLIENTS  4
+#define TELEMETRY_STREAM_MAX_HZ       20
+#define TELEMETRY_STREAM_DEFAULT_HZ   5
+#define TELEMETRY_STREAM_KEYFRAME_MS  10000
+#define TELEMETRY_STREAM_FIELDS       28    // >= number of fields in writeTelemetryJson
+#define TELEMETRY_STREAM_TICK_US      10000 // Service pass period (finest interval is 50 ms)
+
+typedef struct {
+  int sockfd;
+  bool active;
+  uint32_t interval_ms;
+  uint32_t last_sent_ms;
+  uint32_t last_keyframe_ms;
+  uint32_t field_hashes[TELEMETRY_STREAM_FIELDS];
+} TelemetryStreamClient;
+
+TelemetryStreamClient streamClients[TELEMETRY_STREAM_MAX_CLIENTS];
+esp_timer_handle_t streamTimer = NULL;
+volatile bool streamWorkQueued = false;
+
+// Session context destructor: httpd calls this when the stream socket closes
+void releaseTelemetryStream(void* ctx) {
+  TelemetryStreamClient* c = (TelemetryStreamClient*)ctx;
+  if (c->active) {
+    c->active = false;
+    Serial.printf("Telemetry stream %d closed\n", (int)(c - streamClients));
+  }
+}
+
+esp_err_t handleTelemetryStream(httpd_req_t* req) {
+  int slot = -1;
+  for (int i = 0; i < TELEMETRY_STREAM_MAX_CLIENTS; i++) {
+    if (!streamClients[i].active) {
+      slot = i;
+      break;
+    }
+  }
+  if (slot < 0) {
+    return httpServer_sendJson(req, 503, "{\"error\":\"Too many telemetry streams\"}");
+  }
+
+  char hzText[8];
+  int hz = TELEMETRY_STREAM_DEFAULT_HZ;
+  if (httpServer_queryValue(req, "hz", hzText, sizeof(hzText))) {
+    hz = atoi(hzText);
+  }
+  hz = constrain(hz, 1, TELEMETRY_STREAM_MAX_HZ);
+
+  // Write the response head ourselves; without httpd_resp_send() the server
+  // leaves the socket open and later events go out on it directly
+  static const char head[] =
+    "HTTP/1.1 200 OK\r\n"
+    "Content-Type: text/event-stream\r\n"
+    "Cache-Control: no-cache\r\n"
+    "Connection: keep-alive\r\n"
+    "Access-Control-Allow-Origin: *\r\n"
+    "\r\n"
+    "retry: 2000\n\n";
+  if (httpd_send(req, head, sizeof(head) - 1) != (int)(sizeof(head) - 1)) {
+    return ESP_FAIL;
+  }
+
+  TelemetryStreamClient* c = &streamClients[slot];
+  c->sockfd = httpd_req_to_sockfd(req);
+  c->interval_ms = 1000 / hz;
+  c->last_sent_ms = millis() - c->interval_ms;  // First event on the next service pass
+  c->last_keyframe_ms = 0;
+  memset(c->field_hashes, 0, sizeof(c->field_hashes));
+  c->active = true;
+
+  // Free the slot when the socket closes (peer gone, LRU purge, or a stalled write)
+  req->sess_ctx = c;
+  req->free_ctx = releaseTelemetryStream;
+
+  Serial.printf("Telemetry stream %d opened at %d Hz (socket %d)\n", slot, hz, c->sockfd);
+  return ESP_OK;
+}
+
+// Push due events to every open stream (runs in the HTTP server task)
+void serviceTelemetryStreams(void* arg) {
+  streamWorkQueued = false;
+  httpd_handle_t hd = httpServer_handle();
+  uint32_t now = millis();
+  bool haveValues = false;
+  TelemetryValues values;
+
+  for (int i = 0; i < TELEMETRY_STREAM_MAX_CLIENTS; i++) {
+    TelemetryStreamClient* c = &streamClients[i];
+    if (!c->active) continue;
+    if (now - c->last_sent_ms < c->interval_ms) continue;
+    c->last_sent_ms = now;
+
+    if (!haveValues) {
+      readTelemetryValues(&values);
+      haveValues = true;
+    }
+
+    bool keyframe = c->last_keyframe_ms == 0 || now - c->last_keyframe_ms >= TELEMETRY_STREAM_KEYFRAME_MS;
+
+    // One buffer per event: id = sensor sequence number, event type tells full frames from deltas
+    char event[JSON_RESPONSE_MAX + 64];
+    int headLen = snprintf(event, sizeof(event), "id: %lu\nevent: %s\ndata: ",
+                           (unsigned long)values.sample.seq, keyframe ? "telemetry" : "delta");
+    // The writer records each appended field as sent; an overflowed event is dropped,
+    // so put the table back and those fields go out in the next event
+    uint32_t sentHashes[TELEMETRY_STREAM_FIELDS];
+    memcpy(sentHashes, c->field_hashes, sizeof(sentHashes));
+    JsonWriter json(event + headLen, sizeof(event) - headLen - 2);
+    json.setDelta(c->field_hashes, TELEMETRY_STREAM_FIELDS, keyframe);
+    writeTelemetryJson(json, values);
+    json.finish();
+    if (json.overflowed()) {
+      memcpy(c->field_hashes, sentHashes, sizeof(sentHashes));
+      continue;
+    }
+    if (json.fieldsWritten() == 0) continue;
+    if (keyframe) c->last_keyframe_ms = now;
+    size_t len = headLen + json.length();
+    event[len++] = '\n';
+    event[len++] = '\n';
+
+    // Never block the server task on a slow reader
+    int sent = httpd_socket_send(hd, c->sockfd, event, len, MSG_DONTWAIT);
+    if (sent != (int)len) {
+      // Send buffer full or peer gone - drop the stream, the client reconnects
+      Serial.printf("Telemetry stream %d dropped (write stalled)\n", i);
+      httpd_sess_trigger_close(hd, c->sockfd);
+      c->active = false;
+    }
+  }
+}
+
+// Timer callback (esp_timer task): hand a service pass to the HTTP server task
+void telemetryStreamTick(void* arg) {
+  if (streamWorkQueued) return;
+  bool anyActive = false;
+  for (int i = 0; i < TELEMETRY_STREAM_MAX_CLIENTS; i++) {
+    if (streamClients[i].active) anyActive = true;
+  }
+  if (!anyActive) return;
+  streamWorkQueued = true;
+  if (httpd_queue_work(httpServer_handle(), serviceTelemetryStreams, NULL) != ESP_OK) {
+    streamWorkQueued = false;
+  }
+}
+
+// Start the stream service timer (after the HTTP server is running)
+void setupTelemetryStream() {
+  esp_timer_create_args_t args = {};
+  args.callback = telemetryStreamTick;
+  args.name = "telemetry_stream";
+  if (esp_timer_create(&args, &streamTimer) != ESP_OK ||
+      esp_timer_start_periodic(streamTimer, TELEMETRY_STREAM_TICK_US) != ESP_OK) {
+    Serial.println("✗ Telemetry stream timer failed to start");
+  }
+}
+
+esp_err_t handleEngineDebug(httpd_req_t* req) {
+  // Get raw and normalized throttle values
+  SensorSample sample = {};
+  sensorRing_latest(&sample);
+  float throttle_norm = throttleNormalized(sample.throttle_us);
+  
+  // One consistent engine snapshot (published by the audio task once per block)
+  EngineTelemetry engine;
+  audioEngine_getTelemetry(&engine);
+  
+  // Render cost vs. budget (cycles available per output sample at the current CPU clock)
+  uint32_t cycle_budget = (getCpuFrequencyMhz() * 1000000UL) / I2S_SAMPLE_RATE;
+  
+  char buf[JSON_RESPONSE_MAX];
+  JsonWriter json(buf, sizeof(buf));
+  json.addUInt("throttle_raw_us", sample.throttle_us);
+  json.addFloat("throttle_normalized", throttle_norm, 3);
+  json.addFloat("throttle_engine_input", engine.throttle_input, 3);
+  json.addFloat("throttle_smoothed", engine.smoothed_throttle, 3);
+  json.addFloat("engine_rate", engine.rate, 3);
+  json.addFloat("engine_gain", engine.gain, 3);
+  json.addBool("rev_active", engine.rev_active);
+  json.addBool("engine_muted", engine.muted);
+  json.addString("render_kernel", audioEngine_getKernelName());
+  json.addString("engine_bank", engineBank_source());
+  json.addInt("engine_bank_samples", engineBank_count());
+  json.addInt("engine_sample_index", engine.sample_index);
+  json.addUInt("engine_layers", engine.layer_count);
+  json.addUInt("engine_voices_active", engine.voices_active);
+  json.addUInt("cycles_per_sample", engine.cycles_per_sample);
+  json.addUInt("cycles_per_sample_peak", engine.cycles_per_sample_peak);
+  json.addUInt("cycle_budget_per_sample", cycle_budget);
+  json.addUInt("sample_rate", engine.sample_rate);
+  json.addUInt("blocks_rendered", engine.blocks_rendered);
+  json.addUInt("commands_dropped", engine.commands_dropped);
+  json.addUInt("sensor_seq", sample.seq);
+  json.addUInt("last_update_ms", sample.timestamp_ms - sample.throttle_age_ms);
+  return httpServer_sendJson(req, 200, json);
+}
+
+esp_err_t handleEngineMute(httpd_req_t* req) {
   // Parse JSON body: {"muted": true/false}
-  bool muted = body.indexOf("\"muted\":true") >= 0 || body.indexOf("\"muted\": true") >= 0;
+  char body[HTTP_BODY_MAX];
+  readRequestBody(req, body, sizeof(body));
+  bool muted = strstr(body, "\"muted\":true") != NULL || strstr(body, "\"muted\": true") != NULL;
   
-  audioEngine_setMuted(muted);
-  
-  String json = "{";
-  json += "\"muted\":" + String(muted ? "true" : "false") + ",";
-  json += "\"message\":\"Engine audio " + String(muted ? "muted" : "unmuted") + "\"";
-  json += "}";
+  if (!audioEngine_setMuted(muted)) {
+    return httpServer_sendJson(req, 503, "{\"error\":\"Engine control queue full\"}");
+  }
   
-  server.send(200, "application/json", json);
+  return httpServer_sendJson(req, 200, muted ? "{\"muted\":true,\"message\":\"Engine audio muted\"}"
+                                             : "{\"muted\":false,\"message\":\"Engine audio unmuted\"}");
 }
 
-void handleSystemDebug() {
-  addCORSHeaders();
-  
-  String json = "{";
-  json += "\"dfplayer_available\":" + String(dfPlayerAvailable ? "true" : "false") + ",";
-  json += "\"adc_initialized\":" + String(adcInitialized ? "true" : "false") + ",";
-  json += "\"firmware_version\":\"" + String(FIRMWARE_VERSION) + "\",";
-  json += "\"build_id\":\"" + String(BUILD_ID) + "\",";
-  json += "\"uptime_ms\":" + String(millis()) + ",";
-  json += "\"free_heap\":" + String(ESP.getFreeHeap());
-  json += "}";
-  
-  server.send(200, "application/json", json);
+// /engine-bench response: the last completed run, plus whether one is queued
+esp_err_t sendEngineBench(httpd_req_t* req, bool pending) {
+  EngineBenchResult bench;
+  bool have = audioEngine_getBenchmark(&bench);
+  char buf[JSON_RESPONSE_MAX];
+  JsonWriter json(buf, sizeof(buf));
+  json.addBool("pending", pending);
+  json.addString("render_kernel", audioEngine_getKernelName());
+  json.addString("engine_bank", engineBank_source());
+  json.addUInt("run", have ? bench.run : 0);
+  if (have) {
+    char key[32];
+    json.addUInt("duration_ms", bench.duration_ms);
+    json.addUInt("cpu_mhz", bench.cpu_mhz);
+    json.addUInt("layer_count", bench.layer_count);
+    json.addUInt("sample_rate", bench.sample_rate);
+    for (int i = 0; i < ENGINE_BENCH_POINTS; i++) {
+      int pct = (int)(bench.throttle[i] * 100.0f + 0.5f);
+      snprintf(key, sizeof(key), "rate_at_%d", pct);
+      json.addFloat(key, bench.rate[i], 3);
+      snprintf(key, sizeof(key), "ns_per_sample_at_%d", pct);
+      json.addUInt(key, bench.ns_per_sample[i]);
+    }
+    json.addUInt("ns_per_update", bench.ns_per_update);
+    snprintf(key, sizeof(key), "%08lx", (unsigned long)bench.sweep_hash);
+    json.addString("sweep_hash", key);
+    snprintf(key, sizeof(key), "%08lx", (unsigned long)bench.rev_hash);
+    json.addString("rev_hash", key);
+    json.addUInt("sweep_peak", bench.sweep_peak);
+  }
+  return httpServer_sendJson(req, 200, json);
 }
 
-void handleLed() {
-  addCORSHeaders();
-  if (server.method() != HTTP_POST) {
-    server.send(405, "application/json", "{\"error\":\"POST required\"}");
-    return;
+// GET /engine-bench - last on-target render benchmark (audio_engine.h), read-only.
+// The render kernels are checked against golden output on the host
+// (firmware/libraries/EngineAudio/host); this is the on-target timing of the same scripts.
+esp_err_t handleEngineBench(httpd_req_t* req) {
+  return sendEngineBench(req, audioEngine_benchmarkPending());
+}
+
+// POST /engine-bench - start a run (engine audio pauses ~1-2 s), poll GET until "run"
+// increments. ?kernel=fixed|float switches the render kernel first (A/B, phase is kept).
+// Both change what the boat plays, so they take the OTA password like POST /ota.
+esp_err_t handleEngineBenchRun(httpd_req_t* req) {
+  if (!otaPasswordValid(req)) {
+    return httpServer_sendJson(req, 401, "{\"error\":\"Missing or wrong X-OTA-Password\"}");
+  }
+  char value[8];
+  if (httpServer_queryValue(req, "kernel", value, sizeof(value))) {
+    uint8_t kernel;
+    if (strcmp(value, "fixed") == 0) kernel = AUDIO_KERNEL_FIXED;
+    else if (strcmp(value, "float") == 0) kernel = AUDIO_KERNEL_FLOAT;
+    else return httpServer_sendJson(req, 400, "{\"error\":\"kernel must be fixed or float\"}");
+    if (!audioEngine_setKernel(kernel)) {
+      return httpServer_sendJson(req, 503, "{\"error\":\"Engine control queue full\"}");
+    }
+  }
+  audioEngine_requestBenchmark();
+  return sendEngineBench(req, true);
+}
+
+// GET /system-debug - module state plus the boot breakdown (two fields per boot phase,
+// which alone can pass half of JSON_RESPONSE_MAX)
+#define SYSTEM_DEBUG_JSON_MAX  2048   // Static, the server task is single-threaded
+
+esp_err_t handleSystemDebug(httpd_req_t* req) {
+  static char buf[SYSTEM_DEBUG_JSON_MAX];
+  JsonWriter json(buf, sizeof(buf));
+  json.addBool("dfplayer_available", dfPlayerAvailable);
+  json.addBool("adc_initialized", adcInitialized);
+  json.addString("battery_adc_mode", "continuous");
+  json.addUInt("battery_adc_frames", batteryMonitor_getFrameCount());
+  json.addString("firmware_version", FIRMWARE_VERSION);
+  json.addString("build_id", BUILD_ID);
+  json.addUInt("uptime_ms", millis());
+  json.addUInt("free_heap", ESP.getFreeHeap());
+  json.addUInt("discovery_probes", discovery_probesAnswered());
+  RecorderStats recorder;
+  recorder_getStats(&recorder);
+  json.addBool("recorder_storage_ok", recorder.storage_ok);
+  json.addUInt("recorder_boot", recorder.boot);
+  json.addUInt("recorder_flash_records", recorder.flash_records);
+  json.addUInt("recorder_flush_failures", recorder.flush_failures);
+
+  // Boot breakdown: boot_<phase>_ms = duration, boot_<phase>_end_ms = finished at (ms since app start)
+  char key[32];
+  for (int i = 0; i < BOOT_PHASE_COUNT; i++) {
+    uint32_t start = bootPhaseStartMs[i];
+    uint32_t end = bootPhaseEndMs[i];
+    snprintf(key, sizeof(key), "boot_%s_ms", BOOT_PHASE_NAMES[i]);
+    if (end) json.addUInt(key, end - start); else json.addString(key, "pending");
+    snprintf(key, sizeof(key), "boot_%s_end_ms", BOOT_PHASE_NAMES[i]);
+    json.addUInt(key, end);
+  }
+  // Reachable = HTTP server up and WiFi has an IP
+  uint32_t reachable = bootPhaseEndMs[BOOT_WIFI] > bootPhaseEndMs[BOOT_HTTP] ? bootPhaseEndMs[BOOT_WIFI] : bootPhaseEndMs[BOOT_HTTP];
+  if (bootPhaseEndMs[BOOT_WIFI] && bootPhaseEndMs[BOOT_HTTP]) json.addUInt("boot_reachable_ms", reachable);
+  else json.addString("boot_reachable_ms", "pending");
+  return httpServer_sendJson(req, 200, json);
+}
+
+// GET /perf - where the time goes. Histograms since boot (or the last ?reset=1):
+// <name>_count/_min_us/_avg_us/_p99_us/_max_us, loop_hist_le_<us> = iterations per
+// power-of-two bucket, http_<route>_* per handler, task_<name>_stack_free (bytes never
+// used) and task_<name>_cpu_pct since the previous /perf call
+#define PERF_JSON_MAX  8192     // All routes and tasks - static, the server task is single-threaded
+
+void addPerfHistogram(JsonWriter& json, const char* prefix, const PerfHistogram* h) {
+  char key[48];
+  snprintf(key, sizeof(key), "%s_count", prefix);
+  json.addUInt(key, h->count);
+  snprintf(key, sizeof(key), "%s_min_us", prefix);
+  json.addUInt(key, h->min_us);
+  snprintf(key, sizeof(key), "%s_avg_us", prefix);
+  json.addUInt(key, perfHist_avgUs(h));
+  snprintf(key, sizeof(key), "%s_p99_us", prefix);
+  json.addUInt(key, perfHist_percentileUs(h, 99));
+  snprintf(key, sizeof(key), "%s_max_us", prefix);
+  json.addUInt(key, h->max_us);
+}
+
+esp_err_t handlePerf(httpd_req_t* req) {
+  static char buf[PERF_JSON_MAX];
+  JsonWriter json(buf, sizeof(buf));
+  char key[48];
+  json.addUInt("uptime_ms", millis());
+
+  // Heap: the minimum shows how close we came to running out, the largest block
+  // whether a big allocation (TLS, HTTP buffers) can still succeed
+  json.addUInt("free_heap", ESP.getFreeHeap());
+  json.addUInt("min_free_heap", ESP.getMinFreeHeap());
+  json.addUInt("largest_free_block", ESP.getMaxAllocHeap());
+
+  // Audio: render time against the time one block takes to play
+  json.addUInt("audio_deadline_us", AUDIO_BLOCK_DEADLINE_US);
+  json.addUInt("audio_deadline_misses", audioDeadlineMisses);
+  addPerfHistogram(json, "audio_render", &audioRenderPerf);
+  addPerfHistogram(json, "audio_block", &audioBlockPerf);
+  addPerfHistogram(json, "audio_write", &audioWritePerf);
+  I2sOutputStats i2s;
+  i2sOutput_getStats(&i2s);
+  json.addBool("i2s_running", i2s.running);
+  json.addBool("i2s_adaptive", i2s.adaptive);
+  json.addUInt("i2s_dma_desc_num", i2s.desc_num);
+  json.addUInt("i2s_latency_us", i2s.latency_us);
+  json.addUInt("i2s_underruns", i2s.underruns);
+  json.addUInt("i2s_window_underruns", i2s.window_underruns);
+  json.addUInt("i2s_blocks_sent", i2s.blocks_sent);
+  json.addUInt("i2s_dma_grows", i2s.grows);
+  json.addUInt("i2s_dma_shrinks", i2s.shrinks);
+  json.addUInt("i2s_shrink_quiet_ms", i2s.shrink_quiet_ms);
+  json.addUInt("i2s_rebuild_failures", i2s.rebuild_failures);
+
+  // RC capture: frames taken by the RMT ISR vs. frames it threw away
+  static const char* const RC_NAMES[RC_CHANNEL_COUNT] = { "throttle", "servo" };
+  for (int i = 0; i < RC_CHANNEL_COUNT; i++) {
+    RcChannelStats rc;
+    rcCapture_getStats((RcChannel)i, &rc);
+    snprintf(key, sizeof(key), "rc_%s_frames", RC_NAMES[i]);
+    json.addUInt(key, rc.frames);
+    snprintf(key, sizeof(key), "rc_%s_rejected", RC_NAMES[i]);
+    json.addUInt(key, rc.rejected);
+    snprintf(key, sizeof(key), "rc_%s_rearm_failures", RC_NAMES[i]);
+    json.addUInt(key, rc.rearm_failures);
   }
 
-  String body = server.arg("plain");
+  addPerfHistogram(json, "loop", &loopPerf);
+  for (int i = 0; i < PERF_BUCKETS; i++) {
+    if (loopPerf.buckets[i] == 0) continue;
+    snprintf(key, sizeof(key), "loop_hist_le_%lu", i == 0 ? 0UL : (1UL << i) - 1);
+    json.addUInt(key, loopPerf.buckets[i]);
+  }
+
+  // Per route: "/telemetry/stream" -> http_telemetry_stream_*
+  for (size_t i = 0; i < httpServer_routeCount(); i++) {
+    char prefix[32] = "http";
+    size_t len = strlen(prefix);
+    for (const char* c = httpServer_routeUri(i); *c && len < sizeof(prefix) - 1; c++) {
+      prefix[len++] = (*c == '/' || *c == '-') ? '_' : *c;
+    }
+    prefix[len] = '\0';
+    addPerfHistogram(json, prefix, httpServer_routeLatency(i));
+  }
+
+  static PerfTaskInfo tasks[PERF_MAX_TASKS];
+  uint32_t windowMs = 0;
+  size_t taskCount = perf_taskSnapshot(tasks, PERF_MAX_TASKS, &windowMs);
+  json.addUInt("task_count", taskCount);
+  json.addUInt("cpu_window_ms", windowMs);
+  for (size_t i = 0; i < taskCount; i++) {
+    snprintf(key, sizeof(key), "task_%s_stack_free", tasks[i].name);
+    json.addUInt(key, tasks[i].stack_free);
+    if (tasks[i].cpu_permille != PERF_CPU_UNKNOWN) {
+      snprintf(key, sizeof(key), "task_%s_cpu_pct", tasks[i].name);
+      json.addFloat(key, tasks[i].cpu_permille / 10.0f, 1);
+    }
+  }
+
+  char value[4];
+  if (httpServer_queryValue(req, "reset", value, sizeof(value)) && value[0] == '1') {
+    perfHist_requestReset(&loopPerf);
+    perfHist_requestReset(&audioRenderPerf);
+    perfHist_requestReset(&audioBlockPerf);
+    perfHist_requestReset(&audioWritePerf);
+    httpServer_resetLatency();
+    audioDeadlineMisses = 0;
+    json.addBool("reset", true);
+  }
+  return httpServer_sendJson(req, 200, json);
+}
+
+// GET /history?since=<ms>&step=<n>&boot=<id>&limit=<n> - flight recorder range query.
+// Rows are [t_ms, battery_mv, throttle_us, servo_us, free_heap_kb, rssi_dbm, flags]
+// (flags = RECORD_FLAG_*), sent as a chunked body so the full log never sits in RAM.
+// next_since continues a truncated range; boot defaults to the current one.
+// Runs on its own worker task (http_server.h): a long range over a weak link can take
+// seconds to drain, which would otherwise stall every other route
+#define HISTORY_DEFAULT_LIMIT  3600
+#define HISTORY_MAX_LIMIT      6000
+#define HISTORY_CHUNK_FLUSH    896     // Send the chunk buffer once it holds this much
+
+bool historyFlush(HistoryStream* s) {
+  if (s->len > 0 && !s->failed && httpd_resp_send_chunk(s->req, s->buf, s->len) != ESP_OK) s->failed = true;
+  s->len = 0;
+  return !s->failed;
+}
+
+bool historySink(const HistoryRecord* records, size_t count, void* ctx) {
+  HistoryStream* s = (HistoryStream*)ctx;
+  for (size_t i = 0; i < count; i++) {
+    const HistoryRecord& r = records[i];
+    s->len += snprintf(s->buf + s->len, sizeof(s->buf) - s->len, "%s[%lu,%u,%u,%u,%u,%d,%u]",
+                       s->first ? "" : ",", (unsigned long)r.timestamp_ms, r.battery_mv, r.throttle_us,
+                       r.servo_us, r.free_heap_kb, r.rssi_dbm, r.flags);
+    s->first = false;
+    s->last_ts = r.timestamp_ms;
+    if (s->len >= HISTORY_CHUNK_FLUSH && !historyFlush(s)) return false;  // Client went away
+  }
+  return true;
+}
+
+esp_err_t handleHistory(httpd_req_t* req) {
+  char value[16];
+  uint32_t since = httpServer_queryValue(req, "since", value, sizeof(value)) ? strtoul(value, NULL, 10) : 0;
+  uint32_t step = httpServer_queryValue(req, "step", value, sizeof(value)) ? strtoul(value, NULL, 10) : 1;
+  uint16_t boot = httpServer_queryValue(req, "boot", value, sizeof(value)) ? strtoul(value, NULL, 10) : recorder_bootId();
+  size_t limit = httpServer_queryValue(req, "limit", value, sizeof(value)) ? strtoul(value, NULL, 10) : HISTORY_DEFAULT_LIMIT;
+  if (step == 0) step = 1;
+  if (limit == 0 || limit > HISTORY_MAX_LIMIT) limit = HISTORY_MAX_LIMIT;
+
+  static HistoryStream stream;   // Too big for the handler stack; the recorder serialises queries anyway
+  static SemaphoreHandle_t streamMutex = xSemaphoreCreateMutex();
+  xSemaphoreTake(streamMutex, portMAX_DELAY);
+  stream.req = req;
+  stream.last_ts = 0;
+  stream.first = true;
+  stream.failed = false;
+  stream.len = snprintf(stream.buf, sizeof(stream.buf),
+    "{\"boot\":%u,\"current_boot\":%u,\"since\":%lu,\"step\":%lu,"
+    "\"fields\":[\"t_ms\",\"battery_mv\",\"throttle_us\",\"servo_us\",\"free_heap_kb\",\"rssi_dbm\",\"flags\"],"
+    "\"samples\":[",
+    boot, recorder_bootId(), (unsigned long)since, (unsigned long)step);
+
+  httpd_resp_set_type(req, "application/json");
+  size_t count = recorder_query(boot, since, step, limit, historySink, &stream);
+  // A full page may have more behind it - the client asks again from next_since
+  stream.len += snprintf(stream.buf + stream.len, sizeof(stream.buf) - stream.len,
+    "],\"count\":%u,\"truncated\":%s,\"next_since\":%lu}",
+    (unsigned)count, count >= limit ? "true" : "false",
+    (unsigned long)(count > 0 ? stream.last_ts + 1 : since));
+  historyFlush(&stream);
+  bool failed = stream.failed;
+  xSemaphoreGive(streamMutex);
+  if (failed) return ESP_FAIL;
+  return httpd_resp_send_chunk(req, NULL, 0);
+}
+
+esp_err_t handleLed(httpd_req_t* req) {
+  char body[HTTP_BODY_MAX];
+  readRequestBody(req, body, sizeof(body));
   
   // Simple parsing (avoid external JSON library for now)
-  bool modeRunning = body.indexOf("\"running\"") >= 0;
-  bool modeFlood = body.indexOf("\"flood\"") >= 0;
-  bool stateOn = body.indexOf("\"on\"") >= 0;
+  bool modeRunning = strstr(body, "\"running\"") != NULL;
+  bool modeFlood = strstr(body, "\"flood\"") != NULL;
+  bool stateOn = strstr(body, "\"on\"") != NULL;
 
   if (modeRunning) {
     ledRunningState = stateOn;
@@ -575,187 +1128,277 @@ void handleLed() {
     digitalWrite(FLOOD_OUT_PIN, ledFloodState ? HIGH : LOW);
   }
 
-  String json = "{";
-  json += "\"running_led\":" + String(ledRunningState ? "true" : "false") + ",";
-  json += "\"flood_led\":" + String(ledFloodState ? "true" : "false");
-  json += "}";
-  server.send(200, "application/json", json);
+  char buf[JSON_RESPONSE_MAX];
+  JsonWriter json(buf, sizeof(buf));
+  json.addBool("running_led", ledRunningState);
+  json.addBool("flood_led", ledFloodState);
+  return httpServer_sendJson(req, 200, json);
 }
 
-void handleHorn() {
-  addCORSHeaders();
-  if (server.method() != HTTP_POST) {
-    server.send(405, "application/json", "{\"error\":\"POST required\"}");
-    return;
+// DFPlayer requests are queued (dfplayer_queue.h) - the response carries the request
+// ID, GET /dfplayer?id=N reports whether it has been played yet. requestId 0 means the
+// queue was full (503). logLine (may be NULL) is printed only once the command is queued.
+// json may already hold handler-specific fields (easter egg message, radio id)
+esp_err_t sendDfPlayerAccepted(httpd_req_t* req, JsonWriter& json, const char* flag,
+                               uint32_t requestId, const char* logLine) {
+  if (requestId == 0) {
+    return httpServer_sendJson(req, 503, "{\"error\":\"DFPlayer queue full\"}");
   }
+  if (logLine) Serial.println(logLine);
+  json.addBool(flag, true);
+  json.addString("source", "dfplayer");
+  json.addUInt("request_id", requestId);
+  return httpServer_sendJson(req, 200, json);
+}
 
-  // DFPlayer ONLY - no PWM fallback for audio files
+esp_err_t sendDfPlayerAccepted(httpd_req_t* req, const char* flag, uint32_t requestId,
+                               const char* logLine) {
+  char buf[JSON_RESPONSE_MAX];
+  JsonWriter json(buf, sizeof(buf));
+  return sendDfPlayerAccepted(req, json, flag, requestId, logLine);
+}
+
+// Effects in the engine bank (ENGINE_KIND_ONESHOT) are mixed into the I2S output:
+// no UART round trip, and only one amplifier drawing current. Returns false if the
+// bank has no such effect (caller falls back to DFPlayer)
+bool playEngineEffect(httpd_req_t* req, const char* name, uint8_t levelPercent,
+                      const char* flag, esp_err_t* result) {
+  int voice = audioEngine_findVoice(name);
+  if (voice < 0) return false;
+  if (!audioEngine_playVoice(voice, levelPercent)) {
+    *result = httpServer_sendJson(req, 503, "{\"error\":\"Engine control queue full\"}");
+    return true;
+  }
+  char buf[JSON_RESPONSE_MAX];
+  JsonWriter json(buf, sizeof(buf));
+  json.addBool(flag, true);
+  json.addString("source", "engine");
+  *result = httpServer_sendJson(req, 200, json);
+  return true;
+}
+
+esp_err_t handleHorn(httpd_req_t* req) {
+  // Bank "horn" effect through the engine mix when present
+  esp_err_t result;
+  if (playEngineEffect(req, "horn", 90, "horn_active", &result)) return result;
+
+  // Otherwise DFPlayer ONLY - no PWM fallback for audio files
   if (!dfPlayerAvailable) {
-    server.send(503, "application/json", "{\"error\":\"DFPlayer not available\"}");
-    return;
+    return httpServer_sendJson(req, 503, "{\"error\":\"DFPlayer not available\"}");
   }
 
   // Track 4: Horn sound at 60% volume (reduced to prevent power brownout with concurrent audio)
-  playDFPlayerTrack(4, 60);
-  server.send(200, "application/json", "{\"horn_active\":true}");
+  return sendDfPlayerAccepted(req, "horn_active", dfPlayer_playTrack(4, 60, false), NULL);
 }
 
-void handleSOS() {
-  addCORSHeaders();
-  if (server.method() != HTTP_POST) {
-    server.send(405, "application/json", "{\"error\":\"POST required\"}");
-    return;
+esp_err_t handleSOS(httpd_req_t* req) {
+  // Bank "sos" effect through the engine mix when present
+  esp_err_t result;
+  if (playEngineEffect(req, "sos", 80, "sos_active", &result)) {
+    Serial.println("SOS (engine effect)");
+    return result;
   }
 
-  // DFPlayer ONLY - no PWM fallback (SOS is critical, should have audio file)
+  // Otherwise DFPlayer ONLY - no PWM fallback (SOS is critical, should have audio file)
   if (!dfPlayerAvailable) {
-    server.send(503, "application/json", "{\"error\":\"DFPlayer not available\"}");
-    return;
+    return httpServer_sendJson(req, 503, "{\"error\":\"DFPlayer not available\"}");
   }
 
-  // Force SINGLE play mode (play once and stop - don't continue to next tracks)
-  DF1201S.setPlayMode(DF1201S.SINGLE);
-  delay(100);
-
-  // Track 5: SOS morse code audio (9 seconds)
-  playDFPlayerTrack(5, 50);  // 50% volume
-  Serial.println("SOS (DFPlayer track 5)");
-
-  server.send(200, "application/json", "{\"sos_active\":true}");
+  // Track 5: SOS morse code audio (9 seconds) at 50% volume
+  // SINGLE play mode (play once and stop - don't continue to next tracks)
+  return sendDfPlayerAccepted(req, "sos_active", dfPlayer_playTrack(5, 50, true), "SOS (DFPlayer track 5)");
 }
 
-void handleEasterEgg() {
-  addCORSHeaders();
-  if (server.method() != HTTP_POST) {
-    server.send(405, "application/json", "{\"error\":\"POST required\"}");
-    return;
-  }
-
+esp_err_t handleEasterEgg(httpd_req_t* req) {
   // DFPlayer required for easter egg
   if (!dfPlayerAvailable) {
-    server.send(503, "application/json", "{\"error\":\"DFPlayer not available\"}");
-    return;
+    return httpServer_sendJson(req, 503, "{\"error\":\"DFPlayer not available\"}");
   }
 
-  // Play Edmund Fitzgerald song by file path
-  playEdmundEasterEgg();
-  
-  server.send(200, "application/json", "{\"easter_egg\":true,\"message\":\"The legend lives on...\"}");
+  // Edmund Fitzgerald song by file path (avoids index dependency), 85%, SINGLE mode
+  uint32_t requestId = dfPlayer_playFile("/SFX/EDMUND.MP3", 85, true);
+  char buf[JSON_RESPONSE_MAX];
+  JsonWriter json(buf, sizeof(buf));
+  json.addString("message", "The legend lives on...");
+  return sendDfPlayerAccepted(req, json, "easter_egg", requestId, "Playing Edmund Fitzgerald easter egg...");
 }
 
-void handleRadio() {
-  addCORSHeaders();
-  if (server.method() != HTTP_POST) {
-    server.send(405, "application/json", "{\"error\":\"POST required\"}");
-    return;
-  }
-
-  if (!server.hasArg("plain")) {
-    server.send(400, "application/json", "{\"error\":\"Missing request body\"}");
-    return;
+esp_err_t handleRadio(httpd_req_t* req) {
+  char body[HTTP_BODY_MAX];
+  if (httpServer_readBody(req, body, sizeof(body)) < 0) {
+    return httpServer_sendJson(req, 400, "{\"error\":\"Missing request body\"}");
   }
 
   // DFPlayer ONLY - no PWM fallback for audio files
   if (!dfPlayerAvailable) {
-    server.send(503, "application/json", "{\"error\":\"DFPlayer not available\"}");
-    return;
+    return httpServer_sendJson(req, 503, "{\"error\":\"DFPlayer not available\"}");
   }
 
-  String body = server.arg("plain");
   int radioId = 1;
   
-  int idIndex = body.indexOf("\"radio_id\"");
-  if (idIndex >= 0) {
-    int colonIndex = body.indexOf(":", idIndex);
-    if (colonIndex >= 0) {
-      String idStr = body.substring(colonIndex + 1);
-      idStr.trim();
-      radioId = idStr.toInt();
+  const char* idField = strstr(body, "\"radio_id\"");
+  if (idField) {
+    const char* colon = strchr(idField, ':');
+    if (colon) {
+      // atoi skips leading whitespace and stops at the first non-digit
+      radioId = atoi(colon + 1);
     }
   }
 
   if (radioId < 1 || radioId > 3) {
-    server.send(400, "application/json", "{\"error\":\"Invalid radio_id (must be 1-3)\"}");
-    return;
+    return httpServer_sendJson(req, 400, "{\"error\":\"Invalid radio_id (must be 1-3)\"}");
   }
 
   // DFPlayer tracks: 1=radio1, 2=radio2, 3=radio3
-  playDFPlayerTrack(radioId, 47);  // 47% volume
+  uint32_t requestId = dfPlayer_playTrack(radioId, 47, false);  // 47% volume
+  char buf[JSON_RESPONSE_MAX];
+  JsonWriter json(buf, sizeof(buf));
+  json.addInt("radio_id", radioId);
+  char logLine[32];
+  snprintf(logLine, sizeof(logLine), "Radio %d (DFPlayer track %d)", radioId, radioId);
+  return sendDfPlayerAccepted(req, json, "radio_active", requestId, logLine);
+}
 
-  String json = "{\"radio_active\":true,\"radio_id\":" + String(radioId) + "}";
-  server.send(200, "application/json", json);
+esp_err_t handleDfPlayerState(httpd_req_t* req) {
+  DfPlayerState state;
+  dfPlayer_getState(&state);
+
+  char buf[JSON_RESPONSE_MAX];
+  JsonWriter json(buf, sizeof(buf));
+  json.addBool("dfplayer_available", dfPlayerAvailable && state.running);
+  json.addBool("busy", state.busy);
+  json.addUInt("queued", state.queued);
+  json.addUInt("track", state.track);
+  json.addInt("volume", state.volume);
+  json.addUInt("last_request_id", state.last_request_id);
+  json.addUInt("completed_request_id", state.completed_request_id);
+  json.addUInt("coalesced", state.coalesced);
+  json.addUInt("dropped", state.dropped);
+
+  // ?id=N: "done" once handled (played, or superseded by a newer request)
+  char idText[12];
+  if (httpServer_queryValue(req, "id", idText, sizeof(idText))) {
+    uint32_t id = strtoul(idText, NULL, 10);
+    const char* requestState = "unknown";
+    if (id > 0 && id <= state.completed_request_id) requestState = "done";
+    else if (id > 0 && id <= state.last_request_id) requestState = "pending";
+    json.addString("request_state", requestState);
+  }
+  return httpServer_sendJson(req, 200, json);
 }
 
-void handleOptions() {
-  addCORSHeaders();
-  server.send(200);
+// ==================== HTTP OTA ====================
+// POST /ota streams a plain, gzip or delta image into the next OTA partition. It runs on
+// its own worker task (http_server.h), so /telemetry, the SSE streams and the control
+// routes are still served during the upload; one upload at a time, a second gets 503.
+// The engine keeps playing while the body streams in and is muted only for the final
+// verify (esp_ota_end) and the reboot.
+// Upload time scales with the compressed or changed bytes, not the image size.
+// loop() reboots once the response is sent.
+volatile uint32_t otaRestartAtMs = 0;    // 0 = no restart pending
+bool otaMutedForFinish = false;          // /ota worker only
+bool otaWasMuted = false;
+
+void onOtaProgress(uint32_t image_bytes, uint32_t body_bytes, uint32_t body_total) {
+  Serial.printf("Progress: %u%% (%lu bytes written)\r", (unsigned)((uint64_t)body_bytes * 100 / body_total),
+                (unsigned long)image_bytes);
 }
 
-void handleNotFound() {
-  addCORSHeaders();
-  server.send(404, "application/json", "{\"error\":\"not found\"}");
+// Whole image written: mute for the verify and the reboot that follows (as ArduinoOTA does)
+void onOtaFinishing() {
+  otaWasMuted = audioEngine_getMuted();
+  otaMutedForFinish = true;
+  audioEngine_setMuted(true);
 }
 
+// X-OTA-Password header matches OTA_PASSWORD (POST /ota and POST /engine-bench)
+bool otaPasswordValid(httpd_req_t* req) {
+  char password[32];
+  return httpd_req_get_hdr_value_str(req, OTA_PASSWORD_HEADER, password, sizeof(password)) == ESP_OK &&
+         strcmp(password, OTA_PASSWORD) == 0;
+}
+
+esp_err_t handleOta(httpd_req_t* req) {
+  if (!otaPasswordValid(req)) {
+    return httpServer_sendJson(req, 401, "{\"error\":\"Missing or wrong X-OTA-Password\"}");
+  }
+
+  Serial.printf("Start updating sketch over HTTP (%u bytes)\n", (unsigned)req->content_len);
+  otaMutedForFinish = false;
+  OtaStreamResult result;
+  bool ok = otaStream_receive(req, onOtaProgress, onOtaFinishing, &result);
+  if (ok) {
+    Serial.printf("\nOTA Update Complete! %lu bytes (%lu copied from running) from %lu received in %lu ms\n",
+                  (unsigned long)result.image_size, (unsigned long)result.copied,
+                  (unsigned long)result.received, (unsigned long)result.duration_ms);
+    otaRestartAtMs = (millis() + OTA_RESTART_DELAY_MS) | 1;
+  } else {
+    Serial.printf("\n✗ OTA failed: %s\n", result.error);
+    if (otaMutedForFinish) audioEngine_setMuted(otaWasMuted);  // Verify failed, no reboot
+  }
+
+  char buf[JSON_RESPONSE_MAX];
+  JsonWriter json(buf, sizeof(buf));
+  json.addBool("ok", ok);
+  if (!ok) json.addString("error", result.error);
+  json.addBool("gzip", (result.format & OTA_FORMAT_GZIP) != 0);
+  json.addBool("delta", (result.format & OTA_FORMAT_DELTA) != 0);
+  json.addUInt("received", result.received);
+  json.addUInt("image_size", result.image_size);
+  json.addUInt("copied", result.copied);
+  json.addUInt("duration_ms", result.duration_ms);
+  json.addBool("restarting", ok);
+  return httpServer_sendJson(req, ok ? 200 : 400, json);
+}
+
+// Every route, once - http_server.cpp adds CORS headers, OPTIONS preflight and the JSON 404/405.
+// true = long-running, handled on the route's own worker task
+const HttpRoute HTTP_ROUTES[] = {
+  { "/status",           HTTP_GET,  handleStatus },
+  { "/telemetry",        HTTP_GET,  handleTelemetry },
+  { "/telemetry/stream", HTTP_GET,  handleTelemetryStream },
+  { "/led",              HTTP_POST, handleLed },
+  { "/horn",             HTTP_POST, handleHorn },
+  { "/sos",              HTTP_POST, handleSOS },
+  { "/radio",            HTTP_POST, handleRadio },
+  { "/easter-egg",       HTTP_POST, handleEasterEgg },
+  { "/engine-debug",     HTTP_GET,  handleEngineDebug },
+  { "/engine-mute",      HTTP_POST, handleEngineMute },
+  { "/engine-bench",     HTTP_GET,  handleEngineBench },
+  { "/engine-bench",     HTTP_POST, handleEngineBenchRun },
+  { "/system-debug",     HTTP_GET,  handleSystemDebug },
+  { "/dfplayer",         HTTP_GET,  handleDfPlayerState },
+  { "/history",          HTTP_GET,  handleHistory,  true },
+  { "/perf",             HTTP_GET,  handlePerf },
+  { "/ota",              HTTP_POST, handleOta,      true },
+};
+
 // ==================== SETUP ====================
 void setup() {
+  bootPhaseBegin(BOOT_SETUP);
   Serial.begin(115200);
-  delay(2000);  // CRITICAL: 2-second stabilization (match diagnostic timing)
   
   Serial.println();
   Serial.println("=== Boat Telemetry Starting ===");
   
-  // Init DFPlayer Pro FIRST (before any other peripherals)
+  // CRITICAL: Initialize ADC first (before I2S/WiFi to prevent conflict)
+  // Continuous mode uses I2S0 for DMA on the ESP32 - engine audio stays on I2S_NUM_1
   Serial.println();
-  Serial.println("========================================");
-  Serial.println("DFPlayer Pro Initialization");
-  Serial.println("========================================");
-  Serial.print("RX: GPIO");
-  Serial.print(DFPLAYER_RX);
-  Serial.print(" | TX: GPIO");
-  Serial.println(DFPLAYER_TX);
+  Serial.println("Initializing Battery ADC (continuous DMA)...");
+  bootPhaseBegin(BOOT_ADC);
+  adcInitialized = batteryMonitor_init(BATTERY_ADC_PIN);
+  bootPhaseEnd(BOOT_ADC);
   
-  // Initialize Serial2 at 115200 baud for DFPlayer Pro
-  Serial.println("Starting Serial2 at 115200 baud...");
-  Serial2.begin(115200, SERIAL_8N1, DFPLAYER_RX, DFPLAYER_TX);
-  delay(1000);
-  Serial.println("Attempting DF1201S.begin()...");
-  
-  // Initialize DF1201S library
-  if (!DF1201S.begin(Serial2)) {
-    Serial.println("✗ DFPlayer Pro init failed!");
-    Serial.println("  Check: Power, wiring, or try power-cycling ESP32");
-    dfPlayerAvailable = false;
-  } else {
-    Serial.println("✓ DFPlayer Pro connected!");
-    
-    // Switch to MUSIC mode
-    Serial.println("Switching to MUSIC mode...");
-    DF1201S.switchFunction(DF1201S.MUSIC);
-    delay(2000);  // Wait for prompt tone
-    
-    // Set play mode to single (play once)
-    Serial.println("Setting play mode to SINGLE...");
-    DF1201S.setPlayMode(DF1201S.SINGLE);
-    delay(200);
-    
-    // Set initial volume (0-30)
-    Serial.println("Setting volume to 20/30...");
-    DF1201S.setVol(20);
-  delay(200);
-    
-    dfPlayerAvailable = true;
-    Serial.println("✓ DFPlayer Pro ready for playback!");
-  }
-  Serial.println("========================================");
-  
-  // CRITICAL: Initialize ADC now (after DFPlayer, before I2S/WiFi to prevent conflict)
-  Serial.println();
-  Serial.println("Initializing Battery ADC...");
-  pinMode(BATTERY_ADC_PIN, INPUT);
-  int dummy = analogRead(BATTERY_ADC_PIN);  // Force ADC init before I2S/WiFi
-  adcInitialized = true;
-  Serial.printf("Battery ADC initialized (dummy read: %d)\n", dummy);
+  // Start WiFi association now so it overlaps the rest of bring-up
+  // (cached AP first; the link task keeps reconnecting on its own)
   Serial.println();
+  bootPhaseBegin(BOOT_WIFI);
+  wifiLink_start(WIFI_NETWORKS, sizeof(WIFI_NETWORKS) / sizeof(WIFI_NETWORKS[0]), onWiFiConnected);
+  
+  // DFPlayer Pro: UART now, module bring-up in its own task (power-up wait + prompt tone)
+  Serial.printf("DFPlayer Pro: Serial2 at 115200 baud (RX: GPIO%d | TX: GPIO%d)\n", DFPLAYER_RX, DFPLAYER_TX);
+  Serial2.begin(115200, SERIAL_8N1, DFPLAYER_RX, DFPLAYER_TX);
+  xTaskCreatePinnedToCore(dfPlayerBootTask, "DFPlayerBoot", 4096, NULL, 1, NULL, 0);
   
   // Init LED pins
   pinMode(LED_RUNNING_PIN, OUTPUT);
@@ -766,14 +1409,20 @@ void setup() {
   digitalWrite(LED_FLOOD_PIN, LOW);
   digitalWrite(RUNNING_OUT_PIN, LOW);
   digitalWrite(FLOOD_OUT_PIN, LOW);
+
+  // Startup feedback: visual flash = "Booting" (plays while setup continues)
+  setupLightFlash();
+  bootPhaseBegin(BOOT_FLASH);
+  flashRunningLights(1, 1000, 0);
   
-  // Init RMT for non-blocking throttle PWM capture
+  // Init RMT RX for event-driven throttle and servo PWM capture
   Serial.println();
   Serial.println("========================================");
   Serial.println("RMT PWM Capture Initialization");
   Serial.println("========================================");
+  bootPhaseBegin(BOOT_RMT);
   setupRMT();
-  delay(100);  // Let RMT stabilize
+  bootPhaseEnd(BOOT_RMT);
   Serial.println("========================================");
   
   // Init I2S audio output for MAX98357A
@@ -781,7 +1430,9 @@ void setup() {
   Serial.println("========================================");
   Serial.println("I2S Audio System Initialization");
   Serial.println("========================================");
+  bootPhaseBegin(BOOT_I2S);
   setupI2S();
+  bootPhaseEnd(BOOT_I2S);
   Serial.println("========================================");
   
   // Init audio engine and start FreeRTOS task
@@ -789,32 +1440,28 @@ void setup() {
   Serial.println("========================================");
   Serial.println("Engine Audio System Initialization");
   Serial.println("========================================");
-  audioEngine_init();
+  bootPhaseBegin(BOOT_AUDIO);
+  audioEngine_init(I2S_SAMPLE_RATE);
   setupAudioTask();
+  bootPhaseEnd(BOOT_AUDIO);
   Serial.println("========================================");
   
-  // Init water sensor pin (digital with internal pullup)
-  pinMode(WATER_SENSOR_PIN, INPUT_PULLUP);
-  // Initialize debouncing state (assume dry/secure at startup)
-  waterLastRawState = (digitalRead(WATER_SENSOR_PIN) == HIGH);  // true = dry
-  waterDebouncedState = false;  // Start as secure
-  waterStateChangeTime = millis();
+  // Init water sensor pin (internal pullup, edge interrupt; starts secure)
+  bootPhaseBegin(BOOT_SENSORS);
+  waterSensor_init(WATER_SENSOR_PIN);
   
-  // Battery ADC already initialized at top of setup()
+  // Battery ADC already started at top of setup()
   
   // Init RC receiver PWM input pins (no pullup - receiver drives the signal)
   pinMode(THROTTLE_PWM_PIN, INPUT);
   pinMode(SERVO_PWM_PIN, INPUT);
-
-  startTime = millis();
   
-  // Startup feedback: visual flash = "Boot successful"
-  Serial.println("Boot complete - flashing running lights");
-  flashRunningLights(1, 1000, 0);
-  delay(500);  // Brief pause before WiFi connection
+  // Start fixed-rate sampling once every input is configured
+  setupSensorTask();
+  recorder_start();             // Folds the sensor ring into the 1 Hz flight log
+  bootPhaseEnd(BOOT_SENSORS);
 
-  // Connect WiFi
-  connectWiFi();
+  startTime = millis();
 
   // ==================== SETUP OTA (OVER-THE-AIR UPDATES) ====================
   Serial.println();
@@ -822,8 +1469,9 @@ void setup() {
   Serial.println("OTA (Over-The-Air) Update Setup");
   Serial.println("========================================");
   
-  ArduinoOTA.setHostname("edmund-fitzgerald");
-  ArduinoOTA.setPassword("boat2026");  // Password required for OTA uploads
+  bootPhaseBegin(BOOT_OTA);
+  ArduinoOTA.setHostname(OTA_HOSTNAME);
+  ArduinoOTA.setPassword(OTA_PASSWORD);  // Password required for OTA uploads
   
   ArduinoOTA.onStart([]() {
     String type;
@@ -855,67 +1503,42 @@ void setup() {
     else if (error == OTA_END_ERROR) Serial.println("End Failed");
   });
   
+  // Started before WiFi has an IP - the OTA socket and mDNS come up with the interface
   ArduinoOTA.begin();
+  discovery_start(&DISCOVERY_INFO);  // Adds _edmund._tcp to the mDNS responder OTA started
+  bootPhaseEnd(BOOT_OTA);
   Serial.println("✓ OTA Ready!");
-  Serial.print("  Hostname: edmund-fitzgerald");
-  Serial.print("  IP: ");
-  Serial.println(WiFi.localIP());
+  Serial.println("  Hostname: edmund-fitzgerald (IP printed when WiFi connects)");
   Serial.println("========================================");
 
-  // Setup HTTP routes
-  server.on("/status", HTTP_GET, handleStatus);
-  server.on("/telemetry", HTTP_GET, handleTelemetry);
-  server.on("/led", HTTP_POST, handleLed);
-  server.on("/horn", HTTP_POST, handleHorn);
-  server.on("/sos", HTTP_POST, handleSOS);
-  server.on("/radio", HTTP_POST, handleRadio);
-  server.on("/easter-egg", HTTP_POST, handleEasterEgg);
-  server.on("/engine-debug", HTTP_GET, handleEngineDebug);
-  server.on("/engine-mute", HTTP_POST, handleEngineMute);
-  server.on("/system-debug", HTTP_GET, handleSystemDebug);
-  server.on("/status", HTTP_OPTIONS, handleOptions);
-  server.on("/telemetry", HTTP_OPTIONS, handleOptions);
-  server.on("/led", HTTP_OPTIONS, handleOptions);
-  server.on("/horn", HTTP_OPTIONS, handleOptions);
-  server.on("/sos", HTTP_OPTIONS, handleOptions);
-  server.on("/radio", HTTP_OPTIONS, handleOptions);
-  server.on("/easter-egg", HTTP_OPTIONS, handleOptions);
-  server.on("/engine-debug", HTTP_OPTIONS, handleOptions);
-  server.on("/engine-mute", HTTP_OPTIONS, handleOptions);
-  server.on("/system-debug", HTTP_OPTIONS, handleOptions);
-  server.onNotFound(handleNotFound);
-
-  server.begin();
-  Serial.println("HTTP server started on port 80.");
+  // HTTP server runs in its own task (core 0) - handlers never block loop()
+  bootPhaseBegin(BOOT_HTTP);
+  httpServer_start(HTTP_ROUTES, sizeof(HTTP_ROUTES) / sizeof(HTTP_ROUTES[0]));
+  setupTelemetryStream();
+  bootPhaseEnd(BOOT_HTTP);
+
+  bootPhaseEnd(BOOT_SETUP);
+  Serial.printf("Setup done in %lu ms (DFPlayer and WiFi continue in their tasks)\n",
+                (unsigned long)(bootPhaseEndMs[BOOT_SETUP] - bootPhaseStartMs[BOOT_SETUP]));
 }
 
 // ==================== LOOP ====================
-unsigned long lastWiFiCheck = 0;
-
 void loop() {
   // Handle OTA updates (must be called frequently)
   ArduinoOTA.handle();
-  
-  // Always handle HTTP requests (whether WiFi is connected or not)
-  server.handleClient();
-  
-  // Update throttle from RMT (non-blocking)
-  updateThrottleRMT();
-  
-  // Update water sensor debouncing
-  updateWaterSensorDebounce();
-
-  // Retry WiFi every 30 seconds if disconnected — full re-scan to find any available network
-  if (WiFi.status() != WL_CONNECTED && millis() - lastWiFiCheck > 30000) {
-    lastWiFiCheck = millis();
-    Serial.println("\nWiFi disconnected. Running full re-scan...");
-    connectWiFi();
+  if (otaRestartAtMs != 0 && (int32_t)(millis() - otaRestartAtMs) >= 0) {
+    Serial.println("Restarting into the new firmware...");
+    ESP.restart();
   }
+  
+  // HTTP requests and /telemetry/stream events are served by the HTTP server task
+  // (/ota and /history on their own workers);
+  // RC capture and water debouncing run in the sensor task (fixed rate, core 0);
+  // WiFi reconnects are handled by the WiFi link task (no scans in loop)
 
-  // Keep alive marker every 5 seconds
-  static unsigned long lastKeepAlive = 0;
-  if (millis() - lastKeepAlive > 5000) {
-    lastKeepAlive = millis();
-    Serial.print(".");
-  }
+  // Iteration period (OTA handling + whatever preempted loopTask) for /perf
+  static uint32_t lastLoopUs = 0;
+  uint32_t now = micros();
+  if (lastLoopUs != 0) perfHist_record(&loopPerf, now - lastLoopUs);
+  lastLoopUs = now;
 }
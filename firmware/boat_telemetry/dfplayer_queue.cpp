@@ -0,0 +1,156 @@
+// dfplayer_queue.cpp
+// DFPlayer Pro driver task: queue -> coalesce -> paced AT commands
+
+#include "dfplayer_queue.h"
+#include <Arduino.h>
+#include "DFRobot_DF1201S.h"
+
+typedef struct {
+  uint32_t id;
+  uint16_t track;       // 0 = play path instead
+  const char* path;
+  uint8_t volume_pct;
+  bool single_mode;
+} DfPlayerCommand;
+
+static DFRobot_DF1201S* player = NULL;
+static HardwareSerial* uart = NULL;
+static QueueHandle_t commandQueue = NULL;
+static SemaphoreHandle_t postMutex = NULL;   // Keeps request IDs in queue order
+
+// Shared with handlers, guarded by stateMux
+static DfPlayerState state = { false, false, 0, 0, -1, 0, 0, 0, 0 };
+static portMUX_TYPE stateMux = portMUX_INITIALIZER_UNLOCKED;
+
+// Task-only module state (what the player was last told)
+static int8_t sentVolume = -1;
+static bool singleModeSet = false;
+
+static void execute(const DfPlayerCommand& cmd) {
+  // Volume (0-30 for DF1201S), only when it changes
+  int8_t volume = map(cmd.volume_pct, 0, 100, 0, 30);
+  if (volume != sentVolume) {
+    player->setVol(volume);
+    sentVolume = volume;
+    vTaskDelay(pdMS_TO_TICKS(DFPLAYER_CMD_GAP_MS));
+  }
+
+  // SINGLE play mode (play once and stop), only the first time it is asked for
+  if (cmd.single_mode && !singleModeSet) {
+    player->setPlayMode(player->SINGLE);
+    singleModeSet = true;
+    vTaskDelay(pdMS_TO_TICKS(DFPLAYER_MODE_GAP_MS));
+  }
+
+  if (cmd.track > 0) {
+    // Play file by number (based on write order to module)
+    player->playFileNum(cmd.track);
+    Serial.printf("DFPlayer Pro: Track %u @ %u%% (request %lu)\n",
+                  cmd.track, cmd.volume_pct, (unsigned long)cmd.id);
+  } else {
+    // Play by file path using raw AT command (bypasses FileNumber index)
+    // AT+PLAYFILE requires CRLF termination
+    uart->printf("AT+PLAYFILE=%s\r\n", cmd.path);
+    uart->flush();
+    Serial.printf("DFPlayer Pro: %s @ %u%% (request %lu)\n",
+                  cmd.path, cmd.volume_pct, (unsigned long)cmd.id);
+  }
+  vTaskDelay(pdMS_TO_TICKS(DFPLAYER_CMD_GAP_MS));
+}
+
+static void dfPlayerTask(void* param) {
+  DfPlayerCommand cmd;
+  while (true) {
+    if (xQueueReceive(commandQueue, &cmd, portMAX_DELAY) != pdTRUE) continue;
+
+    // Everything queued meanwhile is a newer playback request - only the newest
+    // still matters (each one would restart playback anyway)
+    uint32_t superseded = 0;
+    DfPlayerCommand next;
+    while (xQueueReceive(commandQueue, &next, 0) == pdTRUE) {
+      cmd = next;
+      superseded++;
+    }
+
+    portENTER_CRITICAL(&stateMux);
+    state.busy = true;
+    state.coalesced += superseded;
+    portEXIT_CRITICAL(&stateMux);
+
+    execute(cmd);
+
+    portENTER_CRITICAL(&stateMux);
+    state.busy = false;
+    state.track = cmd.track;
+    state.volume = sentVolume;
+    state.completed_request_id = cmd.id;
+    portEXIT_CRITICAL(&stateMux);
+  }
+}
+
+bool dfPlayer_start(DFRobot_DF1201S* df, HardwareSerial* serial) {
+  player = df;
+  uart = serial;
+  commandQueue = xQueueCreate(DFPLAYER_QUEUE_DEPTH, sizeof(DfPlayerCommand));
+  postMutex = xSemaphoreCreateMutex();
+  if (commandQueue == NULL || postMutex == NULL) {
+    Serial.println("✗ DFPlayer queue allocation failed");
+    return false;
+  }
+  if (xTaskCreatePinnedToCore(dfPlayerTask, "DFPlayer", 4096, NULL,
+                              DFPLAYER_TASK_PRIORITY, NULL, DFPLAYER_TASK_CORE) != pdPASS) {
+    Serial.println("✗ DFPlayer task creation failed");
+    return false;
+  }
+
+  portENTER_CRITICAL(&stateMux);
+  state.running = true;
+  portEXIT_CRITICAL(&stateMux);
+  Serial.printf("DFPlayer task created on Core %d (priority %d, queue %d)\n",
+                DFPLAYER_TASK_CORE, DFPLAYER_TASK_PRIORITY, DFPLAYER_QUEUE_DEPTH);
+  return true;
+}
+
+static uint32_t post(uint16_t track, const char* path, uint8_t volumePercent, bool singleMode) {
+  if (commandQueue == NULL) return 0;
+
+  DfPlayerCommand cmd;
+  cmd.track = track;
+  cmd.path = path;
+  cmd.volume_pct = min(volumePercent, (uint8_t)100);
+  cmd.single_mode = singleMode;
+
+  // IDs are assigned and queued under one mutex so they reach the task in order
+  // (queue calls are not allowed inside the stateMux critical section)
+  xSemaphoreTake(postMutex, portMAX_DELAY);
+  portENTER_CRITICAL(&stateMux);
+  cmd.id = state.last_request_id + 1;
+  portEXIT_CRITICAL(&stateMux);
+  bool queued = xQueueSend(commandQueue, &cmd, 0) == pdTRUE;
+  portENTER_CRITICAL(&stateMux);
+  if (queued) {
+    state.last_request_id = cmd.id;
+  } else {
+    state.dropped++;
+  }
+  portEXIT_CRITICAL(&stateMux);
+  xSemaphoreGive(postMutex);
+  return queued ? cmd.id : 0;
+}
+
+uint32_t dfPlayer_playTrack(uint16_t track, uint8_t volumePercent, bool singleMode) {
+  if (track == 0) return 0;
+  return post(track, NULL, volumePercent, singleMode);
+}
+
+uint32_t dfPlayer_playFile(const char* path, uint8_t volumePercent, bool singleMode) {
+  if (path == NULL) return 0;
+  return post(0, path, volumePercent, singleMode);
+}
+
+void dfPlayer_getState(DfPlayerState* out) {
+  portENTER_CRITICAL(&stateMux);
+  *out = state;
+  portEXIT_CRITICAL(&stateMux);
+  out->queued = commandQueue ? uxQueueMessagesWaiting(commandQueue) : 0;
+}
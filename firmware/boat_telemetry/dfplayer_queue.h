@@ -0,0 +1,49 @@
+// dfplayer_queue.h
+// DFPlayer Pro (DF1201S) command queue with its own UART task
+// HTTP handlers post playback requests and return immediately with a request ID;
+// the task paces the AT commands (the module drops commands sent back to back),
+// skips volume/mode commands that would not change anything, and collapses a
+// burst of queued requests (e.g. horn repeat) into the newest one.
+
+#ifndef DFPLAYER_QUEUE_H
+#define DFPLAYER_QUEUE_H
+
+#include <stdint.h>
+#include <cstddef>
+
+class DFRobot_DF1201S;
+class HardwareSerial;
+
+#define DFPLAYER_QUEUE_DEPTH    8
+#define DFPLAYER_TASK_CORE      0       // Off the audio core
+#define DFPLAYER_TASK_PRIORITY  2       // Below the sensor task
+#define DFPLAYER_CMD_GAP_MS     50      // Pause after volume/play commands
+#define DFPLAYER_MODE_GAP_MS    100     // Pause after a play mode change
+
+// Snapshot of the player state (see dfPlayer_getState)
+typedef struct {
+  bool running;                   // Task started (module initialized)
+  bool busy;                      // A command is being sent right now
+  uint8_t queued;                 // Requests waiting in the queue
+  uint16_t track;                 // Last track started (0 = file path / none)
+  int8_t volume;                  // Last volume sent (0-30, -1 = not set yet)
+  uint32_t last_request_id;       // Newest accepted request
+  uint32_t completed_request_id;  // Newest request handled (older ones are done or superseded)
+  uint32_t coalesced;             // Requests superseded by a newer one before they ran
+  uint32_t dropped;               // Requests rejected because the queue was full
+} DfPlayerState;
+
+// Start the task (after DF1201S.begin() succeeded). uart carries the raw AT
+// commands the library has no wrapper for
+bool dfPlayer_start(DFRobot_DF1201S* player, HardwareSerial* uart);
+
+// Queue playback. volume is 0-100 %, singleMode forces SINGLE play mode first.
+// Returns the request ID, or 0 if the task is not running or the queue is full
+uint32_t dfPlayer_playTrack(uint16_t track, uint8_t volumePercent, bool singleMode);
+
+// Play by file path (path must stay valid - pass a string literal)
+uint32_t dfPlayer_playFile(const char* path, uint8_t volumePercent, bool singleMode);
+
+void dfPlayer_getState(DfPlayerState* out);
+
+#endif // DFPLAYER_QUEUE_H
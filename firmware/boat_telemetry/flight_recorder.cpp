@@ -0,0 +1,336 @@
+// flight_recorder.cpp
+// 1 Hz telemetry records: sensor ring -> RAM ring -> LittleFS segment files
+
+#include "flight_recorder.h"
+#include "sensor_ring.h"
+#include <Arduino.h>
+#include <WiFi.h>
+#include <LittleFS.h>
+#include <Preferences.h>
+
+#define RECORDER_DIR        "/rec"
+#define QUERY_BATCH         32          // Records copied per lock (sink runs unlocked)
+
+static HistoryRecord ram[RECORDER_RAM_RECORDS];
+static SemaphoreHandle_t recMutex = NULL;     // RAM ring, segment files and stats
+static SemaphoreHandle_t queryMutex = NULL;   // One query at a time (shared QueryState)
+
+// Guarded by recMutex
+static uint32_t recordSeq = 0;                // Records since boot
+static uint32_t flushedSeq = 0;               // Records handed to flash (or dropped)
+static uint32_t firstSegment = 0;             // Oldest segment file number
+static uint32_t lastSegment = 0;              // Segment being appended
+static uint32_t segmentRecords = 0;           // Records in lastSegment
+static uint32_t olderRecords = 0;             // Records in the segments before lastSegment
+static File segmentFile;
+static RecorderStats stats = { false, false, 0, 0, 0, 0, 0, 0, 0 };
+
+static void segmentPath(uint32_t n, char* out, size_t cap) {
+  snprintf(out, cap, RECORDER_DIR "/seg_%lu.bin", (unsigned long)n);
+}
+
+static uint32_t segmentSize(uint32_t n) {
+  char path[32];
+  segmentPath(n, path, sizeof(path));
+  File f = LittleFS.open(path, FILE_READ);
+  if (!f) return 0;
+  uint32_t size = f.size();
+  f.close();
+  return size;
+}
+
+// ==================== STORAGE ====================
+// Find the existing segments and reopen (or start) the newest one for appending
+static bool openStorage() {
+  if (!LittleFS.begin(true)) {  // Formats the partition on first use
+    Serial.println("✗ Recorder: LittleFS mount failed - RAM ring only");
+    return false;
+  }
+  LittleFS.mkdir(RECORDER_DIR);
+
+  bool any = false;
+  File dir = LittleFS.open(RECORDER_DIR);
+  for (File f = dir.openNextFile(); f; f = dir.openNextFile()) {
+    unsigned long n;
+    if (sscanf(f.name(), "seg_%lu.bin", &n) == 1) {
+      if (!any || n < firstSegment) firstSegment = n;
+      if (!any || n > lastSegment) lastSegment = n;
+      any = true;
+    }
+    f.close();
+  }
+  dir.close();
+
+  olderRecords = 0;
+  for (uint32_t n = firstSegment; any && n < lastSegment; n++) {
+    olderRecords += segmentSize(n) / sizeof(HistoryRecord);
+  }
+
+  // Keep appending to the newest segment unless it is full or ends in a torn record (brownout)
+  uint32_t size = any ? segmentSize(lastSegment) : 0;
+  if (any && (size % sizeof(HistoryRecord) != 0 || size / sizeof(HistoryRecord) >= RECORDER_SEGMENT_RECORDS)) {
+    olderRecords += size / sizeof(HistoryRecord);
+    lastSegment++;
+    size = 0;
+  }
+  segmentRecords = size / sizeof(HistoryRecord);
+
+  char path[32];
+  segmentPath(lastSegment, path, sizeof(path));
+  segmentFile = LittleFS.open(path, FILE_APPEND);
+  if (!segmentFile) {
+    Serial.println("✗ Recorder: cannot open segment file - RAM ring only");
+    return false;
+  }
+  Serial.printf("✓ Recorder: segments %lu-%lu, %lu records on flash\n", (unsigned long)firstSegment,
+                (unsigned long)lastSegment, (unsigned long)(olderRecords + segmentRecords));
+  return true;
+}
+
+// Close the full segment, drop the oldest beyond RECORDER_SEGMENTS, open the next
+static bool rotateSegment() {
+  segmentFile.close();
+  olderRecords += segmentRecords;
+  segmentRecords = 0;
+  lastSegment++;
+  char path[32];
+  while (lastSegment - firstSegment + 1 > RECORDER_SEGMENTS) {
+    olderRecords -= min(olderRecords, segmentSize(firstSegment) / (uint32_t)sizeof(HistoryRecord));
+    segmentPath(firstSegment, path, sizeof(path));
+    LittleFS.remove(path);
+    firstSegment++;
+  }
+  segmentPath(lastSegment, path, sizeof(path));
+  segmentFile = LittleFS.open(path, FILE_APPEND);
+  return (bool)segmentFile;
+}
+
+// Append the pending RAM records (caller holds recMutex)
+static void flushPending() {
+  // Storage stalled long enough for the ring to wrap: the overwritten records are gone
+  if (recordSeq - flushedSeq > RECORDER_RAM_RECORDS) flushedSeq = recordSeq - RECORDER_RAM_RECORDS;
+  if (!stats.storage_ok) {
+    flushedSeq = recordSeq;
+    return;
+  }
+
+  bool wrote = false;
+  while (flushedSeq < recordSeq) {
+    if (segmentRecords >= RECORDER_SEGMENT_RECORDS && !rotateSegment()) {
+      stats.flush_failures++;
+      return;
+    }
+    // Contiguous run in the ring, bounded by the room left in this segment
+    uint32_t index = flushedSeq & (RECORDER_RAM_RECORDS - 1);
+    uint32_t n = min(recordSeq - flushedSeq, (uint32_t)RECORDER_RAM_RECORDS - index);
+    n = min(n, (uint32_t)RECORDER_SEGMENT_RECORDS - segmentRecords);
+    size_t bytes = n * sizeof(HistoryRecord);
+    if (segmentFile.write((const uint8_t*)&ram[index], bytes) != bytes) {
+      stats.flush_failures++;
+      return;  // Retried at the next flush
+    }
+    flushedSeq += n;
+    segmentRecords += n;
+    stats.flushed += n;
+    wrote = true;
+  }
+  if (wrote) segmentFile.flush();
+}
+
+// ==================== RECORDER TASK ====================
+static void recorderTask(void* param) {
+  SensorSample samples[64];       // > one second of sensor passes at 50 Hz
+  uint32_t nextSensorSeq = 0;
+  uint8_t lastWaterFlags = 0;
+  TickType_t lastWake = xTaskGetTickCount();
+
+  while (true) {
+    vTaskDelayUntil(&lastWake, pdMS_TO_TICKS(RECORDER_INTERVAL_MS));
+
+    // Everything sampled since the last record; water flags are OR-ed across it
+    size_t n = sensorRing_read(nextSensorSeq, samples, sizeof(samples) / sizeof(samples[0]));
+    if (n == 0) {
+      if (!sensorRing_latest(&samples[0])) continue;
+      n = 1;
+    }
+    const SensorSample& latest = samples[n - 1];
+    nextSensorSeq = latest.seq + 1;
+
+    HistoryRecord rec;
+    rec.timestamp_ms = millis();
+    rec.boot = stats.boot;
+    rec.battery_mv = latest.battery_mv;
+    rec.throttle_us = latest.throttle_us;
+    rec.servo_us = latest.servo_us;
+    rec.free_heap_kb = min(ESP.getFreeHeap() / 1024, (uint32_t)65535);
+    bool connected = WiFi.isConnected();
+    rec.rssi_dbm = connected ? (int8_t)WiFi.RSSI() : 0;
+    rec.flags = connected ? RECORD_FLAG_WIFI_CONNECTED : 0;
+    if (latest.flags & SENSOR_FLAG_THROTTLE_VALID) rec.flags |= RECORD_FLAG_THROTTLE_VALID;
+    if (latest.flags & SENSOR_FLAG_SERVO_VALID) rec.flags |= RECORD_FLAG_SERVO_VALID;
+    if (latest.flags & SENSOR_FLAG_BATTERY_LOW) rec.flags |= RECORD_FLAG_BATTERY_LOW;
+    for (size_t i = 0; i < n; i++) {
+      if (!(samples[i].flags & SENSOR_FLAG_WATER_RAW_DRY)) rec.flags |= RECORD_FLAG_WATER_RAW_WET;
+      if (samples[i].flags & SENSOR_FLAG_WATER_BREACHED) rec.flags |= RECORD_FLAG_WATER_BREACHED;
+    }
+
+    // A water state change goes to flash straight away (the record that matters most)
+    uint8_t waterFlags = rec.flags & (RECORD_FLAG_WATER_RAW_WET | RECORD_FLAG_WATER_BREACHED);
+    bool waterChanged = waterFlags != lastWaterFlags;
+    lastWaterFlags = waterFlags;
+
+    xSemaphoreTake(recMutex, portMAX_DELAY);
+    ram[recordSeq & (RECORDER_RAM_RECORDS - 1)] = rec;
+    recordSeq++;
+    stats.recorded = recordSeq;
+    if (recordSeq - flushedSeq >= RECORDER_FLUSH_RECORDS || waterChanged) flushPending();
+    xSemaphoreGive(recMutex);
+  }
+}
+
+bool recorder_start() {
+  recMutex = xSemaphoreCreateMutex();
+  queryMutex = xSemaphoreCreateMutex();
+  if (recMutex == NULL || queryMutex == NULL) {
+    Serial.println("✗ Recorder allocation failed");
+    return false;
+  }
+
+  // Boot counter: millis() timestamps are only comparable within one boot
+  Preferences prefs;
+  if (prefs.begin("recorder", false)) {
+    stats.boot = prefs.getUShort("boot", 0) + 1;
+    prefs.putUShort("boot", stats.boot);
+    prefs.end();
+  }
+
+  stats.storage_ok = openStorage();
+  if (xTaskCreatePinnedToCore(recorderTask, "Recorder", 6144, NULL,
+                              RECORDER_TASK_PRIORITY, NULL, RECORDER_TASK_CORE) != pdPASS) {
+    Serial.println("✗ Recorder task creation failed");
+    return false;
+  }
+  stats.running = true;
+  Serial.printf("Recorder task created on Core %d (boot %u, %d s per record)\n",
+                RECORDER_TASK_CORE, stats.boot, RECORDER_INTERVAL_MS / 1000);
+  return true;
+}
+
+// ==================== QUERIES ====================
+typedef struct {
+  uint16_t boot;
+  uint32_t since_ms;
+  uint32_t step;
+  size_t limit;
+  RecorderSink sink;
+  void* ctx;
+  bool seen;                // Any record of this boot seen yet
+  uint32_t last_ts;         // Newest timestamp of this boot seen (dedups flash vs. RAM)
+  uint32_t matches;
+  size_t delivered;
+  bool stopped;
+  HistoryRecord out[QUERY_BATCH];
+  size_t out_count;
+} QueryState;
+
+static void emit(QueryState* q) {
+  if (q->out_count == 0 || q->stopped) return;
+  if (!q->sink(q->out, q->out_count, q->ctx)) q->stopped = true;
+  q->out_count = 0;
+}
+
+static void consider(QueryState* q, const HistoryRecord* recs, size_t n) {
+  for (size_t i = 0; i < n && !q->stopped; i++) {
+    const HistoryRecord& r = recs[i];
+    if (r.boot != q->boot) continue;
+    // Timestamps only grow within a boot; anything not newer was already seen
+    if (q->seen && r.timestamp_ms <= q->last_ts) continue;
+    q->seen = true;
+    q->last_ts = r.timestamp_ms;
+    if (r.timestamp_ms < q->since_ms) continue;
+    if (q->matches++ % q->step != 0) continue;
+    q->out[q->out_count++] = r;
+    q->delivered++;
+    if (q->out_count == QUERY_BATCH) emit(q);
+    if (q->delivered >= q->limit) {
+      emit(q);
+      q->stopped = true;
+    }
+  }
+}
+
+size_t recorder_query(uint16_t boot, uint32_t since_ms, uint32_t step, size_t limit,
+                      RecorderSink sink, void* ctx) {
+  if (recMutex == NULL || limit == 0) return 0;
+  static QueryState q;                    // Too big for the HTTP task stack
+  xSemaphoreTake(queryMutex, portMAX_DELAY);
+
+  memset(&q, 0, sizeof(q));
+  q.boot = boot;
+  q.since_ms = since_ms;
+  q.step = step > 0 ? step : 1;
+  q.limit = limit;
+  q.sink = sink;
+  q.ctx = ctx;
+  HistoryRecord batch[QUERY_BATCH];
+
+  // Flash segments, oldest first. Each batch is read under the lock, the sink (network
+  // send) runs without it so the recorder never waits on a slow client
+  xSemaphoreTake(recMutex, portMAX_DELAY);
+  uint32_t first = firstSegment, last = lastSegment;
+  bool storage = stats.storage_ok;
+  xSemaphoreGive(recMutex);
+  for (uint32_t seg = first; storage && seg <= last && !q.stopped; seg++) {
+    char path[32];
+    segmentPath(seg, path, sizeof(path));
+    uint32_t offset = 0;
+    while (!q.stopped) {
+      xSemaphoreTake(recMutex, portMAX_DELAY);
+      size_t got = 0;
+      File f = LittleFS.open(path, FILE_READ);  // Gone if rotated out meanwhile
+      if (f && f.seek(offset)) got = f.read((uint8_t*)batch, sizeof(batch)) / sizeof(HistoryRecord);
+      if (f) f.close();
+      xSemaphoreGive(recMutex);
+      if (got == 0) break;
+      offset += got * sizeof(HistoryRecord);
+      consider(&q, batch, got);
+    }
+  }
+
+  // Then whatever the RAM ring holds that flash did not have yet
+  uint32_t seq = 0;
+  while (!q.stopped) {
+    xSemaphoreTake(recMutex, portMAX_DELAY);
+    uint32_t oldest = recordSeq > RECORDER_RAM_RECORDS ? recordSeq - RECORDER_RAM_RECORDS : 0;
+    if (seq < oldest) seq = oldest;
+    size_t got = 0;
+    while (seq < recordSeq && got < QUERY_BATCH) batch[got++] = ram[seq++ & (RECORDER_RAM_RECORDS - 1)];
+    xSemaphoreGive(recMutex);
+    if (got == 0) break;
+    consider(&q, batch, got);
+  }
+  emit(&q);
+
+  size_t delivered = q.delivered;
+  xSemaphoreGive(queryMutex);
+  return delivered;
+}
+
+uint16_t recorder_bootId() {
+  return stats.boot;
+}
+
+void recorder_getStats(RecorderStats* out) {
+  if (recMutex == NULL) {
+    *out = stats;
+    return;
+  }
+  xSemaphoreTake(recMutex, portMAX_DELAY);
+  *out = stats;
+  out->flash_records = olderRecords + segmentRecords;
+  xSemaphoreGive(recMutex);
+  if (out->storage_ok) {
+    out->fs_used_bytes = LittleFS.usedBytes();
+    out->fs_total_bytes = LittleFS.totalBytes();
+  }
+}
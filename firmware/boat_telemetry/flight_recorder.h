@@ -0,0 +1,73 @@
+// flight_recorder.h
+// On-device telemetry log, so gaps in the app's log (app closed, phone out of range)
+// can be backfilled from the boat.
+// Once a second the recorder task folds the sensor ring into one fixed-size record:
+// the latest battery/RC values, plus the water flags OR-ed over the whole second so a
+// short wet reading is never lost. Records go to a RAM ring first. They are appended to
+// LittleFS (the "spiffs" partition) in batches, and a change in water state flushes at
+// once. The log is a few fixed-size segment files. Once they are all full, the oldest
+// segment file is deleted; a file is never rewritten in place.
+
+#ifndef FLIGHT_RECORDER_H
+#define FLIGHT_RECORDER_H
+
+#include <stdint.h>
+#include <cstddef>
+
+#define RECORDER_INTERVAL_MS      1000    // One record per second
+#define RECORDER_RAM_RECORDS      512     // RAM ring (power of two) - ~8.5 min
+#define RECORDER_FLUSH_RECORDS    64      // Append to flash once this many are pending (~1 min)
+#define RECORDER_SEGMENT_RECORDS  1536    // Records per segment file (24 KB)
+#define RECORDER_SEGMENTS         3       // Segment files kept (~77 min at 1 Hz in 128 KB)
+#define RECORDER_TASK_CORE        0
+#define RECORDER_TASK_PRIORITY    1       // Below the sensor task
+
+// Record flags
+#define RECORD_FLAG_WATER_RAW_WET     0x01   // Raw input read WET at least once this second
+#define RECORD_FLAG_WATER_BREACHED    0x02   // Debounced water state (any sample this second)
+#define RECORD_FLAG_THROTTLE_VALID    0x04
+#define RECORD_FLAG_SERVO_VALID       0x08
+#define RECORD_FLAG_BATTERY_LOW       0x10
+#define RECORD_FLAG_WIFI_CONNECTED    0x20
+
+// One record (16 bytes, little-endian, also the on-flash format)
+typedef struct __attribute__((packed)) {
+  uint32_t timestamp_ms;    // millis() of this boot
+  uint16_t boot;            // Boot counter (NVS) - timestamps restart at every boot
+  uint16_t battery_mv;
+  uint16_t throttle_us;
+  uint16_t servo_us;
+  uint16_t free_heap_kb;    // ESP.getFreeHeap() / 1024
+  int8_t rssi_dbm;          // 0 = not connected
+  uint8_t flags;            // RECORD_FLAG_*
+} HistoryRecord;
+
+static_assert(sizeof(HistoryRecord) == 16, "HistoryRecord is the on-flash format");
+
+typedef struct {
+  bool running;
+  bool storage_ok;          // LittleFS mounted (RAM ring only otherwise)
+  uint16_t boot;
+  uint32_t recorded;        // Records since boot
+  uint32_t flushed;         // Records appended to flash since boot
+  uint32_t flash_records;   // Records currently in the segment files (all boots)
+  uint32_t flush_failures;
+  uint32_t fs_used_bytes;
+  uint32_t fs_total_bytes;
+} RecorderStats;
+
+// Called with batches of matching records, oldest first. Return false to stop the query
+typedef bool (*RecorderSink)(const HistoryRecord* records, size_t count, void* ctx);
+
+// Mount storage, bump the boot counter and start the 1 Hz task (after the sensor task)
+bool recorder_start();
+
+// Records of one boot with timestamp_ms >= since_ms, every step-th match, at most limit.
+// Flash segments first, then RAM records not flushed yet. Returns the number delivered
+size_t recorder_query(uint16_t boot, uint32_t since_ms, uint32_t step, size_t limit,
+                      RecorderSink sink, void* ctx);
+
+uint16_t recorder_bootId();
+void recorder_getStats(RecorderStats* out);
+
+#endif // FLIGHT_RECORDER_H
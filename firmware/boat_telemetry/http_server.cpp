@@ -0,0 +1,245 @@
+// http_server.cpp
+// esp_http_server wrapper: route table, CORS, JSON responses, request helpers
+
+#include "http_server.h"
+#include <Arduino.h>
+#include <string.h>
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+
+static httpd_handle_t httpd = NULL;
+
+// One slot per table route (user_ctx of its registered handler). The histogram is
+// written by the task that runs the handler: the server task, or the route's worker
+typedef struct {
+  const char* uri;
+  HttpHandler handler;
+  PerfHistogram latency;
+  bool worker;
+  SemaphoreHandle_t start;  // Worker: given once pending is set
+  httpd_req_t* pending;     // Worker: async copy of the request being handled
+  volatile bool busy;       // Set by the server task, cleared by the worker when done
+} RouteSlot;
+
+static RouteSlot routeSlots[HTTP_SERVER_MAX_ROUTES];
+static size_t routeSlotCount = 0;
+
+static const char* statusText(int code) {
+  switch (code) {
+    case 200: return "200 OK";
+    case 204: return "204 No Content";
+    case 400: return "400 Bad Request";
+    case 404: return "404 Not Found";
+    case 405: return "405 Method Not Allowed";
+    case 413: return "413 Payload Too Large";
+    case 500: return "500 Internal Server Error";
+    case 503: return "503 Service Unavailable";
+    default:  return "500 Internal Server Error";
+  }
+}
+
+static void setCorsHeaders(httpd_req_t* req) {
+  httpd_resp_set_hdr(req, "Access-Control-Allow-Origin", "*");
+  httpd_resp_set_hdr(req, "Access-Control-Allow-Methods", "GET, POST, OPTIONS");
+  httpd_resp_set_hdr(req, "Access-Control-Allow-Headers", "Content-Type");
+}
+
+// Worker route task: runs the handler on the async request, then hands the socket back
+static void routeWorkerTask(void* param) {
+  RouteSlot* slot = (RouteSlot*)param;
+  while (true) {
+    xSemaphoreTake(slot->start, portMAX_DELAY);
+    httpd_req_t* req = slot->pending;
+    setCorsHeaders(req);
+    int64_t start = esp_timer_get_time();
+    esp_err_t result = slot->handler(req);
+    perfHist_record(&slot->latency, (uint32_t)(esp_timer_get_time() - start));
+    if (result != ESP_OK) httpd_sess_trigger_close(httpd, httpd_req_to_sockfd(req));  // As the server would
+    httpd_req_async_handler_complete(req);
+    slot->pending = NULL;
+    slot->busy = false;
+  }
+}
+
+// Every route goes through here (user_ctx = the route's slot)
+static esp_err_t dispatch(httpd_req_t* req) {
+  setCorsHeaders(req);
+  RouteSlot* slot = (RouteSlot*)req->user_ctx;
+  if (slot->worker) {
+    // Only the server task claims workers, so no lock is needed here
+    if (slot->busy) {
+      return httpServer_sendJson(req, 503, "{\"error\":\"busy with another request\"}");
+    }
+    httpd_req_t* async_req = NULL;
+    if (httpd_req_async_handler_begin(req, &async_req) != ESP_OK) {
+      return httpServer_sendJson(req, 500, "{\"error\":\"could not start request\"}");
+    }
+    slot->busy = true;
+    slot->pending = async_req;
+    xSemaphoreGive(slot->start);
+    return ESP_OK;
+  }
+  int64_t start = esp_timer_get_time();
+  esp_err_t result = slot->handler(req);
+  perfHist_record(&slot->latency, (uint32_t)(esp_timer_get_time() - start));
+  return result;
+}
+
+static esp_err_t handleOptions(httpd_req_t* req) {
+  setCorsHeaders(req);
+  httpd_resp_set_status(req, statusText(204));
+  return httpd_resp_send(req, NULL, 0);
+}
+
+static esp_err_t handleNotFound(httpd_req_t* req, httpd_err_code_t err) {
+  setCorsHeaders(req);
+  return httpServer_sendJson(req, 404, "{\"error\":\"not found\"}");
+}
+
+// Route exists but not for this method (e.g. GET on a POST-only control)
+static esp_err_t handleWrongMethod(httpd_req_t* req, httpd_err_code_t err) {
+  setCorsHeaders(req);
+  return httpServer_sendJson(req, 405, "{\"error\":\"method not allowed\"}");
+}
+
+bool httpServer_start(const HttpRoute* routes, size_t count) {
+  httpd_config_t config = HTTPD_DEFAULT_CONFIG();
+  config.server_port = HTTP_SERVER_PORT;
+  config.core_id = HTTP_SERVER_CORE;
+  config.stack_size = HTTP_SERVER_STACK;
+  config.max_open_sockets = HTTP_SERVER_MAX_SOCKETS;
+  config.max_uri_handlers = HTTP_SERVER_MAX_ROUTES;
+  config.lru_purge_enable = true;   // Reclaim the oldest idle socket instead of refusing new ones
+
+  if (httpd_start(&httpd, &config) != ESP_OK) {
+    Serial.println("✗ HTTP server failed to start");
+    httpd = NULL;
+    return false;
+  }
+
+  routeSlotCount = 0;
+  for (size_t i = 0; i < count; i++) {
+    if (routeSlotCount >= HTTP_SERVER_MAX_ROUTES) {
+      Serial.printf("✗ HTTP route %s not registered (table full)\n", routes[i].uri);
+      continue;
+    }
+    RouteSlot* slot = &routeSlots[routeSlotCount++];
+    slot->uri = routes[i].uri;
+    slot->handler = routes[i].handler;
+    memset(&slot->latency, 0, sizeof(slot->latency));
+    slot->worker = false;
+    slot->start = NULL;
+    slot->busy = false;
+    slot->pending = NULL;
+    if (routes[i].worker) {
+      // Task named after the route ("http/ota") so it is found on /perf
+      char name[16];
+      snprintf(name, sizeof(name), "http%s", routes[i].uri);
+      slot->start = xSemaphoreCreateBinary();
+      slot->worker = slot->start &&
+        xTaskCreatePinnedToCore(routeWorkerTask, name, HTTP_SERVER_STACK, slot,
+                                config.task_priority, NULL, HTTP_SERVER_CORE) == pdPASS;
+      if (!slot->worker) Serial.printf("✗ HTTP worker for %s not started, runs on the server task\n", routes[i].uri);
+    }
+    httpd_uri_t uri = {
+      .uri      = routes[i].uri,
+      .method   = routes[i].method,
+      .handler  = dispatch,
+      .user_ctx = slot
+    };
+    if (httpd_register_uri_handler(httpd, &uri) != ESP_OK) {
+      Serial.printf("✗ HTTP route %s not registered\n", routes[i].uri);
+    }
+
+    // CORS preflight, once per path (registered here so the table lists each route once;
+    // a wildcard OPTIONS route would turn every unknown path into a 405 instead of 404)
+    bool seen = false;
+    for (size_t j = 0; j < i; j++) {
+      if (strcmp(routes[j].uri, routes[i].uri) == 0) seen = true;
+    }
+    if (!seen) {
+      httpd_uri_t options_uri = {
+        .uri      = routes[i].uri,
+        .method   = HTTP_OPTIONS,
+        .handler  = handleOptions,
+        .user_ctx = NULL
+      };
+      httpd_register_uri_handler(httpd, &options_uri);
+    }
+  }
+
+  httpd_register_err_handler(httpd, HTTPD_404_NOT_FOUND, handleNotFound);
+  httpd_register_err_handler(httpd, HTTPD_405_METHOD_NOT_ALLOWED, handleWrongMethod);
+
+  Serial.printf("HTTP server started on port %d (%d routes, %d sockets, core %d)\n",
+                HTTP_SERVER_PORT, (int)count, HTTP_SERVER_MAX_SOCKETS, HTTP_SERVER_CORE);
+  return true;
+}
+
+httpd_handle_t httpServer_handle() {
+  return httpd;
+}
+
+size_t httpServer_routeCount() {
+  return routeSlotCount;
+}
+
+const char* httpServer_routeUri(size_t index) {
+  return index < routeSlotCount ? routeSlots[index].uri : NULL;
+}
+
+const PerfHistogram* httpServer_routeLatency(size_t index) {
+  return index < routeSlotCount ? &routeSlots[index].latency : NULL;
+}
+
+void httpServer_resetLatency() {
+  for (size_t i = 0; i < routeSlotCount; i++) perfHist_requestReset(&routeSlots[i].latency);
+}
+
+esp_err_t httpServer_send(httpd_req_t* req, int code, const char* type, const void* data, size_t len) {
+  httpd_resp_set_status(req, statusText(code));
+  httpd_resp_set_type(req, type);
+  return httpd_resp_send(req, (const char*)data, len);
+}
+
+esp_err_t httpServer_sendJson(httpd_req_t* req, int code, JsonWriter& json) {
+  const char* body = json.finish();
+  if (json.overflowed()) {
+    Serial.printf("HTTP: response for %s exceeded %d bytes\n", req->uri, JSON_RESPONSE_MAX);
+    return httpServer_sendJson(req, 500, "{\"error\":\"response too large\"}");
+  }
+  return httpServer_send(req, code, "application/json", body, json.length());
+}
+
+esp_err_t httpServer_sendJson(httpd_req_t* req, int code, const char* body) {
+  return httpServer_send(req, code, "application/json", body, strlen(body));
+}
+
+int httpServer_readBody(httpd_req_t* req, char* buf, size_t cap) {
+  if (req->content_len == 0 || req->content_len >= cap) return -1;
+  size_t received = 0;
+  int timeouts = 0;
+  while (received < req->content_len) {
+    int n = httpd_req_recv(req, buf + received, req->content_len - received);
+    if (n == HTTPD_SOCK_ERR_TIMEOUT && ++timeouts < 3) continue;  // Retry a slow client briefly
+    if (n <= 0) return -1;
+    received += n;
+  }
+  buf[received] = '\0';
+  return (int)received;
+}
+
+bool httpServer_queryValue(httpd_req_t* req, const char* key, char* out, size_t cap) {
+  char query[128];
+  esp_err_t err = httpd_req_get_url_query_str(req, query, sizeof(query));
+  if (err != ESP_OK && err != ESP_ERR_HTTPD_RESULT_TRUNC) return false;
+  return httpd_query_key_value(query, key, out, cap) == ESP_OK;
+}
+
+bool httpServer_headerContains(httpd_req_t* req, const char* header, const char* needle) {
+  char value[256];  // Browser Accept headers can be long; a truncated value is still searched
+  esp_err_t err = httpd_req_get_hdr_value_str(req, header, value, sizeof(value));
+  if (err != ESP_OK && err != ESP_ERR_HTTPD_RESULT_TRUNC) return false;
+  return strstr(value, needle) != NULL;
+}
@@ -0,0 +1,62 @@
+// http_server.h
+// Telemetry HTTP server on esp_http_server (same stack as camera_stream.ino)
+// Runs in its own task with several open sockets, so a slow client or a slow
+// handler no longer stalls loop() (OTA, WiFi retry). Routes come from one table;
+// CORS headers and OPTIONS preflight are added centrally for every route.
+// Handlers run on the one server task, so they must stay short. A long one (an upload,
+// a streamed body) is marked worker: the dispatcher hands the request off with
+// httpd_req_async_handler_begin() to that route's own task and the server task moves
+// on, so the short routes keep their latency while it runs.
+
+#ifndef HTTP_SERVER_H
+#define HTTP_SERVER_H
+
+#include <stdint.h>
+#include <cstddef>
+#include "esp_http_server.h"
+#include "json_writer.h"
+#include "perf_stats.h"
+
+#define HTTP_SERVER_PORT        80
+#define HTTP_SERVER_CORE        0       // Off the audio core
+#define HTTP_SERVER_STACK       8192    // Handlers keep JSON buffers on the stack (worker tasks too)
+#define HTTP_SERVER_MAX_SOCKETS 7       // LWIP default allows 10, 3 are used internally
+#define HTTP_SERVER_MAX_ROUTES  40      // Table routes + one OPTIONS handler per path
+#define HTTP_BODY_MAX           256     // Largest accepted request body
+
+typedef esp_err_t (*HttpHandler)(httpd_req_t* req);
+
+typedef struct {
+  const char* uri;
+  httpd_method_t method;
+  HttpHandler handler;
+  bool worker;              // Run on the route's own task (one request at a time, else 503)
+} HttpRoute;
+
+// Start the server and register every route (plus its OPTIONS preflight and the JSON 404/405),
+// with one task per worker route
+bool httpServer_start(const HttpRoute* routes, size_t count);
+
+httpd_handle_t httpServer_handle();
+
+// Per-route handler latency (dispatch to handler return), in table order
+size_t httpServer_routeCount();
+const char* httpServer_routeUri(size_t index);
+const PerfHistogram* httpServer_routeLatency(size_t index);
+void httpServer_resetLatency();
+
+// Responses (CORS headers are already set by the dispatcher)
+esp_err_t httpServer_sendJson(httpd_req_t* req, int code, JsonWriter& json);
+esp_err_t httpServer_sendJson(httpd_req_t* req, int code, const char* body);
+esp_err_t httpServer_send(httpd_req_t* req, int code, const char* type, const void* data, size_t len);
+
+// Read the request body into buf (NUL-terminated). Returns length, or -1 if missing/too large
+int httpServer_readBody(httpd_req_t* req, char* buf, size_t cap);
+
+// Query string value (false if absent)
+bool httpServer_queryValue(httpd_req_t* req, const char* key, char* out, size_t cap);
+
+// True if the request header exists and contains needle
+bool httpServer_headerContains(httpd_req_t* req, const char* header, const char* needle);
+
+#endif // HTTP_SERVER_H
@@ -0,0 +1,178 @@
+// i2s_output.cpp
+// I2S TX channel, underrun callbacks and adaptive DMA depth
+
+#include "i2s_output.h"
+#include <Arduino.h>
+
+static I2sOutputConfig config;
+static i2s_chan_handle_t txHandle = NULL;     // Audio task only after init
+
+// Written by the ISR callbacks
+static volatile uint32_t isrUnderruns = 0;
+static volatile uint32_t isrBlocksSent = 0;
+static volatile bool streaming = false;       // Overflows before the queue is first filled are not underruns
+static uint32_t writesSinceRebuild = 0;
+
+// Adaptation state (audio task)
+static uint32_t descNum = 0;
+static uint32_t windowStartMs = 0;
+static uint32_t windowStartUnderruns = 0;
+static uint32_t quietSinceMs = 0;
+static uint32_t lastShrinkMs = 0;
+static uint32_t shrinkQuietMs = I2S_ADAPT_SHRINK_QUIET_MS;
+static volatile uint32_t windowUnderruns = 0;
+static volatile uint32_t grows = 0;
+static volatile uint32_t shrinks = 0;
+static volatile uint32_t rebuildFailures = 0;
+
+static IRAM_ATTR bool onSent(i2s_chan_handle_t handle, i2s_event_data_t* event, void* ctx) {
+  isrBlocksSent++;
+  return false;
+}
+
+static IRAM_ATTR bool onSendQueueOverflow(i2s_chan_handle_t handle, i2s_event_data_t* event, void* ctx) {
+  if (streaming) isrUnderruns++;
+  return false;
+}
+
+static bool createChannel(uint32_t desc) {
+  i2s_chan_config_t chan_cfg = I2S_CHANNEL_DEFAULT_CONFIG(config.port, I2S_ROLE_MASTER);
+  chan_cfg.dma_desc_num = desc;
+  chan_cfg.dma_frame_num = config.frame_num;
+  chan_cfg.auto_clear = true;   // Underrun plays silence, not the last block again
+
+  esp_err_t err = i2s_new_channel(&chan_cfg, &txHandle, NULL);
+  if (err != ESP_OK) {
+    Serial.printf("ERROR: I2S channel creation failed: %d\n", err);
+    txHandle = NULL;
+    return false;
+  }
+
+  // Standard mode configuration (Philips I2S)
+  i2s_std_config_t std_cfg = {
+    .clk_cfg = I2S_STD_CLK_DEFAULT_CONFIG(config.sample_rate),
+    .slot_cfg = I2S_STD_PHILIPS_SLOT_DEFAULT_CONFIG(I2S_DATA_BIT_WIDTH_16BIT, I2S_SLOT_MODE_MONO),
+    .gpio_cfg = {
+      .mclk = I2S_GPIO_UNUSED,
+      .bclk = (gpio_num_t)config.bclk_pin,
+      .ws = (gpio_num_t)config.ws_pin,
+      .dout = (gpio_num_t)config.dout_pin,
+      .din = I2S_GPIO_UNUSED,
+      .invert_flags = {
+        .mclk_inv = false,
+        .bclk_inv = false,
+        .ws_inv = false,
+      },
+    },
+  };
+
+  i2s_event_callbacks_t callbacks = {};
+  callbacks.on_sent = onSent;
+  callbacks.on_send_q_ovf = onSendQueueOverflow;
+
+  err = i2s_channel_init_std_mode(txHandle, &std_cfg);
+  if (err == ESP_OK) err = i2s_channel_register_event_callback(txHandle, &callbacks, NULL);
+  if (err == ESP_OK) err = i2s_channel_enable(txHandle);
+  if (err != ESP_OK) {
+    Serial.printf("ERROR: I2S channel setup failed: %d\n", err);
+    i2s_del_channel(txHandle);
+    txHandle = NULL;
+    return false;
+  }
+  descNum = desc;
+  return true;
+}
+
+// Tear down and recreate with another depth (audio task, between writes)
+static void rebuildChannel(uint32_t desc) {
+  streaming = false;
+  writesSinceRebuild = 0;
+  i2s_channel_disable(txHandle);
+  i2s_del_channel(txHandle);
+  txHandle = NULL;
+  uint32_t previous = descNum;
+  if (!createChannel(desc)) {
+    rebuildFailures++;
+    createChannel(previous);   // Stays NULL if even that fails - writes then just pace
+  }
+}
+
+static void adapt() {
+  uint32_t now = millis();
+  uint32_t underruns = isrUnderruns;
+  windowUnderruns = underruns - windowStartUnderruns;
+  if (now - windowStartMs < I2S_ADAPT_WINDOW_MS) return;
+
+  uint32_t inWindow = windowUnderruns;
+  windowStartMs = now;
+  windowStartUnderruns = underruns;
+  windowUnderruns = 0;
+  if (inWindow > 0) quietSinceMs = now;
+
+  if (inWindow >= I2S_ADAPT_GROW_UNDERRUNS && descNum < I2S_DMA_DESC_MAX) {
+    // Growing right after a shrink: that depth was too shallow, wait longer next time
+    if (lastShrinkMs != 0 && now - lastShrinkMs < 2 * I2S_ADAPT_WINDOW_MS) {
+      shrinkQuietMs = min(shrinkQuietMs * 2, (uint32_t)I2S_ADAPT_SHRINK_QUIET_MAX);
+    }
+    rebuildChannel(descNum + 1);
+    grows++;
+    Serial.printf("I2S: %lu underruns in %d s - DMA depth %lu\n", (unsigned long)inWindow,
+                  I2S_ADAPT_WINDOW_MS / 1000, (unsigned long)descNum);
+  } else if (inWindow == 0 && descNum > config.desc_num && now - quietSinceMs >= shrinkQuietMs) {
+    rebuildChannel(descNum - 1);
+    shrinks++;
+    lastShrinkMs = now;
+    quietSinceMs = now;
+    Serial.printf("I2S: clean for %lu s - DMA depth %lu\n", (unsigned long)(shrinkQuietMs / 1000),
+                  (unsigned long)descNum);
+  }
+}
+
+bool i2sOutput_init(const I2sOutputConfig* cfg) {
+  config = *cfg;
+  if (!createChannel(config.desc_num)) return false;
+  windowStartMs = millis();
+  quietSinceMs = windowStartMs;
+  return true;
+}
+
+size_t i2sOutput_write(const int16_t* samples, size_t count) {
+  if (config.adaptive && txHandle != NULL) adapt();
+  if (txHandle == NULL) {
+    // No channel: keep the caller's block rate rather than spinning
+    vTaskDelay(pdMS_TO_TICKS(count * 1000 / config.sample_rate + 1));
+    return 0;
+  }
+  size_t written = 0;
+  i2s_channel_write(txHandle, samples, count * sizeof(int16_t), &written, portMAX_DELAY);
+  if (!streaming && ++writesSinceRebuild >= descNum) streaming = true;
+  return written;
+}
+
+void i2sOutput_suspend() {
+  streaming = false;
+  writesSinceRebuild = 0;
+  if (txHandle != NULL) i2s_channel_disable(txHandle);
+}
+
+void i2sOutput_resume() {
+  if (txHandle != NULL) i2s_channel_enable(txHandle);
+  // Fresh adaptation window: the pause says nothing about the depth
+  windowStartMs = millis();
+  windowStartUnderruns = isrUnderruns;
+  quietSinceMs = windowStartMs;
+}
+
+void i2sOutput_getStats(I2sOutputStats* out) {
+  out->running = txHandle != NULL;
+  out->adaptive = config.adaptive;
+  out->desc_num = descNum;
+  out->latency_us = config.sample_rate ? (uint32_t)((uint64_t)descNum * config.frame_num * 1000000ULL / config.sample_rate) : 0;
+  out->underruns = isrUnderruns;
+  out->window_underruns = windowUnderruns;
+  out->blocks_sent = isrBlocksSent;
+  out->grows = grows;
+  out->shrinks = shrinks;
+  out->shrink_quiet_ms = shrinkQuietMs;
+  out->rebuild_failures = rebuildFailures;
+}
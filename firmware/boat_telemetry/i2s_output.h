@@ -0,0 +1,63 @@
+// i2s_output.h
+// Engine audio I2S TX channel (new ESP-IDF 5.x driver) with underrun accounting
+// TX event callbacks count sent DMA blocks and send-queue overflows. An overflow
+// means the DMA came back for a buffer the audio task had not refilled in time, so it
+// is the underrun (auto_clear makes the DMA play silence instead of a stale block).
+// Adaptive depth: with underruns in a window the DMA queue grows by one descriptor,
+// buying headroom with 2.9 ms more latency. After a long quiet spell it shrinks
+// again. The channel is rebuilt between two writes by the audio task itself;
+// nothing else ever touches the handle.
+
+#ifndef I2S_OUTPUT_H
+#define I2S_OUTPUT_H
+
+#include <stdint.h>
+#include <cstddef>
+#include "driver/i2s_std.h"
+
+#define I2S_ADAPT_WINDOW_MS        5000     // Underruns are judged per window
+#define I2S_ADAPT_GROW_UNDERRUNS   2        // Underruns in one window that add a descriptor
+#define I2S_ADAPT_SHRINK_QUIET_MS  60000    // Clean time before trying one descriptor less
+#define I2S_ADAPT_SHRINK_QUIET_MAX 600000   // Backoff cap when a shrink keeps being undone
+#define I2S_DMA_DESC_MAX           8        // 8 x 2.9 ms = ~23 ms worst-case latency
+
+typedef struct {
+  i2s_port_t port;
+  uint32_t sample_rate;
+  int bclk_pin;
+  int ws_pin;
+  int dout_pin;
+  uint32_t frame_num;       // Samples per DMA descriptor (= one rendered block)
+  uint32_t desc_num;        // Starting (and minimum) queue depth
+  bool adaptive;
+} I2sOutputConfig;
+
+typedef struct {
+  bool running;
+  bool adaptive;
+  uint32_t desc_num;        // Current DMA queue depth
+  uint32_t latency_us;      // desc_num x one block
+  uint32_t underruns;       // Send queue overflows while streaming (since boot)
+  uint32_t window_underruns;// In the current adaptation window
+  uint32_t blocks_sent;     // DMA descriptors completed
+  uint32_t grows;
+  uint32_t shrinks;
+  uint32_t shrink_quiet_ms; // Current clean time required before a shrink
+  uint32_t rebuild_failures;
+} I2sOutputStats;
+
+// Create and enable the channel (cfg is copied)
+bool i2sOutput_init(const I2sOutputConfig* cfg);
+
+// Audio task: queue one block (blocks until a descriptor is free). May rebuild the
+// channel with a new depth first. Returns bytes written
+size_t i2sOutput_write(const int16_t* samples, size_t count);
+
+// Audio task: stop the DMA while it does something else for a while (engine benchmark).
+// Nothing is counted as an underrun until the queue is full again after resume
+void i2sOutput_suspend();
+void i2sOutput_resume();
+
+void i2sOutput_getStats(I2sOutputStats* out);
+
+#endif // I2S_OUTPUT_H
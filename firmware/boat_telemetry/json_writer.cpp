@@ -0,0 +1,132 @@
+// json_writer.cpp
+// Bounded JSON object writer used by every HTTP handler
+
+#include "json_writer.h"
+#include <stdarg.h>
+#include <stdio.h>
+#include <math.h>
+
+JsonWriter::JsonWriter(char* buffer, size_t capacity)
+  : buf(buffer), cap(capacity), len(0), written(0), index(0),
+    deltaHashes(NULL), deltaCount(0), deltaKeyframe(true),
+    first(true), closed(false), overflow(false) {
+  if (cap > 0) buf[0] = '\0';
+  appendf("{");
+}
+
+void JsonWriter::appendf(const char* fmt, ...) {
+  if (overflow) return;
+  va_list args;
+  va_start(args, fmt);
+  int n = vsnprintf(buf + len, cap - len, fmt, args);
+  va_end(args);
+  // Keep one byte free for the closing brace
+  if (n < 0 || len + n + 1 >= cap) {
+    overflow = true;
+    if (cap > 0) buf[len] = '\0';  // Drop the partial field
+    return;
+  }
+  len += n;
+}
+
+void JsonWriter::setDelta(uint32_t* hashes, size_t count, bool keyframe) {
+  deltaHashes = hashes;
+  deltaCount = count;
+  deltaKeyframe = keyframe;
+}
+
+// Emit one "name":value pair (value is already formatted JSON text)
+void JsonWriter::field(const char* name, const char* value) {
+  size_t i = index++;
+  bool tracked = deltaHashes && i < deltaCount;
+  uint32_t h = 2166136261u;
+  if (tracked) {
+    // FNV-1a over the value text
+    for (const char* p = value; *p; p++) {
+      h = (h ^ (uint8_t)*p) * 16777619u;
+    }
+    if (deltaHashes[i] == h && !deltaKeyframe) return;
+  }
+  appendf(first ? "\"%s\":%s" : ",\"%s\":%s", name, value);
+  if (overflow) return;  // Not sent, so not recorded as sent
+  first = false;
+  written++;
+  if (tracked) deltaHashes[i] = h;
+}
+
+void JsonWriter::addString(const char* name, const char* value) {
+  char text[JSON_VALUE_MAX];
+  size_t n = 0;
+  text[n++] = '"';
+  for (const char* p = value; p && *p; p++) {
+    unsigned char c = (unsigned char)*p;
+    // Worst case is a 6-byte \u escape plus the closing quote and NUL
+    if (n + 8 >= sizeof(text)) {
+      overflow = true;
+      index++;  // Keep later fields on their own delta hash slots
+      return;
+    }
+    if (c == '"' || c == '\\') {
+      text[n++] = '\\';
+      text[n++] = c;
+    } else if (c < 0x20) {
+      n += snprintf(text + n, sizeof(text) - n, "\\u%04x", c);
+    } else {
+      text[n++] = c;
+    }
+  }
+  text[n++] = '"';
+  text[n] = '\0';
+  field(name, text);
+}
+
+void JsonWriter::addInt(const char* name, int32_t value) {
+  char text[12];
+  snprintf(text, sizeof(text), "%ld", (long)value);
+  field(name, text);
+}
+
+void JsonWriter::addUInt(const char* name, uint32_t value) {
+  char text[12];
+  snprintf(text, sizeof(text), "%lu", (unsigned long)value);
+  field(name, text);
+}
+
+void JsonWriter::addUInt64(const char* name, uint64_t value) {
+  char text[24];
+  snprintf(text, sizeof(text), "%llu", (unsigned long long)value);
+  field(name, text);
+}
+
+// NaN / Inf (e.g. an average over zero samples) have no JSON form: written as null
+void JsonWriter::addFloat(const char* name, float value, int decimals) {
+  if (!isfinite(value)) {
+    field(name, "null");
+    return;
+  }
+  char text[48];   // FLT_MAX is 39 digits before the point
+  snprintf(text, sizeof(text), "%.*f", decimals, (double)value);
+  field(name, text);
+}
+
+void JsonWriter::addBool(const char* name, bool value) {
+  field(name, value ? "true" : "false");
+}
+
+void JsonWriter::addIp(const char* name, uint32_t ip) {
+  char text[20];
+  snprintf(text, sizeof(text), "\"%u.%u.%u.%u\"",
+           (unsigned)(ip & 0xFF), (unsigned)((ip >> 8) & 0xFF),
+           (unsigned)((ip >> 16) & 0xFF), (unsigned)((ip >> 24) & 0xFF));
+  field(name, text);
+}
+
+const char* JsonWriter::finish() {
+  if (!closed && cap > 0) {
+    // Room for "}" is reserved by appendf, so this always fits
+    buf[len++] = '}';
+    buf[len] = '\0';
+    closed = true;
+  }
+  return buf;
+}
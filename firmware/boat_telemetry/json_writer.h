@@ -0,0 +1,69 @@
+// json_writer.h
+// Minimal JSON object writer over a caller-owned buffer (no heap allocation)
+// Handlers build responses in a stack buffer and send it with a known length:
+//
+//   char buf[JSON_RESPONSE_MAX];
+//   JsonWriter json(buf, sizeof(buf));
+//   json.addBool("connected", true);
+//   json.addFloat("rate", 1.25f, 3);
+//   httpServer_sendJson(req, 200, json);
+//
+// Values are appended with snprintf; commas and the closing brace are handled
+// by the writer. On overflow the output is truncated and overflowed() is set.
+//
+// Delta mode (streams): with setDelta(), the writer keeps a hash of each field's
+// value text per call position and omits fields whose value is unchanged since
+// the previous object written with the same hash table (all fields on a keyframe).
+// Only fields that were appended are recorded; a caller that drops an overflowed
+// object restores its copy of the table.
+
+#ifndef JSON_WRITER_H
+#define JSON_WRITER_H
+
+#include <stdint.h>
+#include <cstddef>
+
+#define JSON_RESPONSE_MAX       1024    // Stack buffer size used by the HTTP handlers
+#define JSON_VALUE_MAX          96      // Longest formatted value (after escaping)
+
+class JsonWriter {
+public:
+  // Starts the object ("{") immediately
+  JsonWriter(char* buffer, size_t capacity);
+
+  void addString(const char* key, const char* value);  // Escapes quotes, backslashes, control chars
+  void addInt(const char* key, int32_t value);
+  void addUInt(const char* key, uint32_t value);
+  void addUInt64(const char* key, uint64_t value);     // Unix milliseconds and other 64-bit counts
+  void addFloat(const char* key, float value, int decimals);  // null if NaN / Inf
+  void addBool(const char* key, bool value);
+  void addIp(const char* key, uint32_t ip);            // Dotted quad (IPAddress uint32, LSB first)
+
+  // Delta mode: hashes holds one entry per field (in add order), owned by the caller
+  void setDelta(uint32_t* hashes, size_t count, bool keyframe);
+
+  // Closes the object (idempotent) and returns the text
+  const char* finish();
+
+  size_t length() const { return len; }
+  size_t fieldsWritten() const { return written; }
+  bool overflowed() const { return overflow; }
+
+private:
+  void field(const char* name, const char* value);
+  void appendf(const char* fmt, ...) __attribute__((format(printf, 2, 3)));
+
+  char* buf;
+  size_t cap;
+  size_t len;
+  size_t written;           // Fields emitted
+  size_t index;             // Fields offered (delta hash position)
+  uint32_t* deltaHashes;
+  size_t deltaCount;
+  bool deltaKeyframe;
+  bool first;
+  bool closed;
+  bool overflow;
+};
+
+#endif // JSON_WRITER_H
@@ -0,0 +1,113 @@
+// perf_stats.cpp
+// Power-of-two latency histograms + FreeRTOS task snapshot
+
+#include "perf_stats.h"
+#include <Arduino.h>
+
+void perfHist_record(PerfHistogram* h, uint32_t us) {
+  if (h->reset_requested) {
+    h->count = 0;
+    h->min_us = 0;
+    h->max_us = 0;
+    h->sum_us = 0;
+    memset(h->buckets, 0, sizeof(h->buckets));
+    h->reset_requested = false;
+  }
+  uint32_t bucket = us ? 32 - __builtin_clz(us) : 0;
+  if (bucket >= PERF_BUCKETS) bucket = PERF_BUCKETS - 1;
+  h->buckets[bucket]++;
+  if (h->count == 0 || us < h->min_us) h->min_us = us;
+  if (us > h->max_us) h->max_us = us;
+  h->sum_us += us;
+  h->count++;
+}
+
+void perfHist_requestReset(PerfHistogram* h) {
+  h->reset_requested = true;
+}
+
+uint32_t perfHist_avgUs(const PerfHistogram* h) {
+  uint32_t count = h->count;
+  return count ? (uint32_t)(h->sum_us / count) : 0;
+}
+
+uint32_t perfHist_percentileUs(const PerfHistogram* h, uint8_t percent) {
+  uint32_t count = h->count;
+  if (count == 0) return 0;
+  uint32_t target = (uint32_t)(((uint64_t)count * percent + 99) / 100);
+  uint32_t seen = 0;
+  for (int i = 0; i < PERF_BUCKETS; i++) {
+    seen += h->buckets[i];
+    if (seen >= target) {
+      uint32_t upper = i == 0 ? 0 : (1UL << i) - 1;
+      return upper < h->max_us ? upper : h->max_us;
+    }
+  }
+  return h->max_us;
+}
+
+// ==================== TASKS ====================
+#if configUSE_TRACE_FACILITY
+static TaskStatus_t taskStatus[PERF_MAX_TASKS];   // HTTP task only - one snapshot at a time
+
+#if configGENERATE_RUN_TIME_STATS
+typedef struct {
+  UBaseType_t number;
+  configRUN_TIME_COUNTER_TYPE runtime;
+} PrevRuntime;
+static PrevRuntime prevRuntime[PERF_MAX_TASKS];
+static size_t prevCount = 0;
+static configRUN_TIME_COUNTER_TYPE prevTotal = 0;
+#endif
+#endif
+
+size_t perf_taskSnapshot(PerfTaskInfo* out, size_t max, uint32_t* window_ms) {
+  *window_ms = 0;
+#if configUSE_TRACE_FACILITY
+  configRUN_TIME_COUNTER_TYPE total = 0;
+  size_t n = uxTaskGetSystemState(taskStatus, PERF_MAX_TASKS, &total);  // 0 if more tasks than slots
+  if (n > max) n = max;
+
+#if configGENERATE_RUN_TIME_STATS
+  // Run-time counter is in microseconds of wall time; both cores run tasks in that window
+  configRUN_TIME_COUNTER_TYPE window = total - prevTotal;
+  bool haveWindow = prevTotal != 0 && window > 0;
+  if (haveWindow) *window_ms = window / 1000;
+#endif
+
+  for (size_t i = 0; i < n; i++) {
+    const TaskStatus_t& t = taskStatus[i];
+    strlcpy(out[i].name, t.pcTaskName, sizeof(out[i].name));
+    out[i].stack_free = t.usStackHighWaterMark;  // Bytes on ESP-IDF (StackType_t is uint8_t)
+    out[i].priority = t.uxCurrentPriority;
+#if configTASKLIST_INCLUDE_COREID
+    out[i].core = t.xCoreID == tskNO_AFFINITY ? -1 : (int8_t)t.xCoreID;
+#else
+    out[i].core = -1;
+#endif
+    out[i].cpu_permille = PERF_CPU_UNKNOWN;
+#if configGENERATE_RUN_TIME_STATS
+    if (haveWindow) {
+      for (size_t j = 0; j < prevCount; j++) {
+        if (prevRuntime[j].number != t.xTaskNumber) continue;
+        uint64_t used = t.ulRunTimeCounter - prevRuntime[j].runtime;
+        out[i].cpu_permille = (uint16_t)(used * 1000 / ((uint64_t)window * portNUM_PROCESSORS));
+        break;
+      }
+    }
+#endif
+  }
+
+#if configGENERATE_RUN_TIME_STATS
+  prevCount = n;
+  for (size_t i = 0; i < n; i++) {
+    prevRuntime[i].number = taskStatus[i].xTaskNumber;
+    prevRuntime[i].runtime = taskStatus[i].ulRunTimeCounter;
+  }
+  prevTotal = total;
+#endif
+  return n;
+#else
+  return 0;
+#endif
+}
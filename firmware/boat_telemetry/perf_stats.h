@@ -0,0 +1,48 @@
+// perf_stats.h
+// Fixed-size timing histograms and FreeRTOS task snapshots for GET /perf
+// A histogram has one writer: the task whose timing it measures. Recording is a clz and
+// a few adds, with no lock, so it is safe on the audio and loop hot paths. Readers copy the
+// counters as they are. A value torn by a concurrent update is off by one sample at most.
+// Buckets are powers of two in microseconds, so p99 is the upper edge of a bucket
+// (never more than 2x the true value, and clamped to the maximum seen).
+
+#ifndef PERF_STATS_H
+#define PERF_STATS_H
+
+#include <stdint.h>
+#include <cstddef>
+
+#define PERF_BUCKETS      24      // [0], [1], [2,3], [4,7] ... [2^22, inf) us (~4 s)
+#define PERF_MAX_TASKS    32      // Tasks reported by perf_taskSnapshot
+#define PERF_CPU_UNKNOWN  0xFFFF  // cpu_permille without FreeRTOS run-time stats
+
+typedef struct {
+  uint32_t count;
+  uint32_t min_us;
+  uint32_t max_us;
+  uint64_t sum_us;
+  uint32_t buckets[PERF_BUCKETS];
+  volatile bool reset_requested;  // Set by a reader, applied by the writer on its next sample
+} PerfHistogram;
+
+// Writer side (single task per histogram)
+void perfHist_record(PerfHistogram* h, uint32_t us);
+
+// Reader side (any task)
+void perfHist_requestReset(PerfHistogram* h);
+uint32_t perfHist_avgUs(const PerfHistogram* h);
+uint32_t perfHist_percentileUs(const PerfHistogram* h, uint8_t percent);
+
+typedef struct {
+  char name[16];
+  uint32_t stack_free;      // Bytes never used (high-water mark)
+  uint16_t cpu_permille;    // Share of all CPU time since the previous snapshot (PERF_CPU_UNKNOWN if unavailable)
+  int8_t core;              // -1 = not pinned
+  uint8_t priority;
+} PerfTaskInfo;
+
+// Every task, with CPU share over the window since the previous call. *window_ms gets that
+// window (0 on the first call or without run-time stats). Returns the number of tasks filled in
+size_t perf_taskSnapshot(PerfTaskInfo* out, size_t max, uint32_t* window_ms);
+
+#endif // PERF_STATS_H
@@ -0,0 +1,130 @@
+// rc_capture.cpp
+// RMT RX channels with a per-frame done callback
+
+#include "rc_capture.h"
+#include <Arduino.h>
+#include "driver/rmt_rx.h"
+
+#define RC_RX_SYMBOLS  64      // One RMT memory block; a frame is one or two symbols
+
+typedef struct {
+  rmt_channel_handle_t handle;
+  RcPulseSink sink;
+  rmt_symbol_word_t symbols[RC_RX_SYMBOLS];   // Receive buffer (owned by the driver while armed)
+  volatile uint32_t pulse_us;
+  volatile uint32_t last_ms;                   // millis() timebase of the last valid pulse
+  volatile uint32_t frames;
+  volatile uint32_t rejected;
+  volatile uint32_t rearm_failures;
+  volatile bool needs_rearm;
+} RcInput;
+
+static RcInput inputs[RC_CHANNEL_COUNT];
+
+static const rmt_receive_config_t receiveConfig = {
+  .signal_range_min_ns = RC_GLITCH_NS,
+  .signal_range_max_ns = RC_FRAME_GAP_US * 1000,
+};
+
+// Width of the frame's only high level, 0 if there is none or more than one
+static uint32_t IRAM_ATTR framePulse(const rmt_symbol_word_t* symbols, size_t count) {
+  uint32_t pulse = 0;
+  int highs = 0;
+  for (size_t i = 0; i < count; i++) {
+    if (symbols[i].level0 == 1 && symbols[i].duration0 > 0) {
+      pulse = symbols[i].duration0;
+      highs++;
+    }
+    if (symbols[i].level1 == 1 && symbols[i].duration1 > 0) {
+      pulse = symbols[i].duration1;
+      highs++;
+    }
+  }
+  return highs == 1 ? pulse : 0;
+}
+
+static bool IRAM_ATTR onFrame(rmt_channel_handle_t channel, const rmt_rx_done_event_data_t* event, void* ctx) {
+  RcInput* input = (RcInput*)ctx;
+  uint32_t pulse = framePulse(event->received_symbols, event->num_symbols);
+  if (pulse >= RC_PULSE_MIN_US && pulse <= RC_PULSE_MAX_US) {
+    input->pulse_us = pulse;
+    input->last_ms = (uint32_t)(esp_timer_get_time() / 1000);
+    input->frames++;
+    if (input->sink) input->sink(pulse);
+  } else {
+    // Armed mid-pulse, a glitch-split pulse, or noise
+    input->rejected++;
+  }
+  // Arm the next frame right away (the buffer has been read)
+  if (rmt_receive(channel, input->symbols, sizeof(input->symbols), &receiveConfig) != ESP_OK) {
+    input->rearm_failures++;
+    input->needs_rearm = true;
+  }
+  return false;
+}
+
+bool rcCapture_init(RcChannel channel, int pin, RcPulseSink sink) {
+  RcInput* input = &inputs[channel];
+  input->sink = sink;
+  input->last_ms = 0;
+
+  rmt_rx_channel_config_t config = {};
+  config.gpio_num = (gpio_num_t)pin;
+  config.clk_src = RMT_CLK_SRC_DEFAULT;
+  config.resolution_hz = RC_CAPTURE_RESOLUTION_HZ;
+  config.mem_block_symbols = RC_RX_SYMBOLS;
+
+  esp_err_t err = rmt_new_rx_channel(&config, &input->handle);
+  if (err != ESP_OK) {
+    Serial.printf("✗ RMT RX channel on GPIO%d failed: %d\n", pin, err);
+    input->handle = NULL;
+    return false;
+  }
+
+  rmt_rx_event_callbacks_t callbacks = {};
+  callbacks.on_recv_done = onFrame;
+  err = rmt_rx_register_event_callbacks(input->handle, &callbacks, input);
+  if (err == ESP_OK) err = rmt_enable(input->handle);
+  if (err == ESP_OK) err = rmt_receive(input->handle, input->symbols, sizeof(input->symbols), &receiveConfig);
+  if (err != ESP_OK) {
+    Serial.printf("✗ RMT RX setup on GPIO%d failed: %d\n", pin, err);
+    rmt_disable(input->handle);
+    rmt_del_channel(input->handle);
+    input->handle = NULL;
+    return false;
+  }
+  return true;
+}
+
+void rcCapture_poll() {
+  for (int i = 0; i < RC_CHANNEL_COUNT; i++) {
+    RcInput* input = &inputs[i];
+    if (!input->needs_rearm || input->handle == NULL) continue;
+    input->needs_rearm = false;
+    if (rmt_receive(input->handle, input->symbols, sizeof(input->symbols), &receiveConfig) != ESP_OK) {
+      input->needs_rearm = true;   // Try again next pass
+    }
+  }
+}
+
+bool rcCapture_latest(RcChannel channel, uint32_t* pulse_us, uint32_t* age_ms) {
+  const RcInput* input = &inputs[channel];
+  if (input->frames == 0) return false;
+  *pulse_us = input->pulse_us;
+  *age_ms = millis() - input->last_ms;
+  return true;
+}
+
+void rcCapture_getStats(RcChannel channel, RcChannelStats* out) {
+  const RcInput* input = &inputs[channel];
+  out->frames = input->frames;
+  out->rejected = input->rejected;
+  out->rearm_failures = input->rearm_failures;
+  if (out->frames == 0) {
+    out->pulse_us = 0;
+    out->age_ms = UINT32_MAX;
+  } else {
+    out->pulse_us = input->pulse_us;
+    out->age_ms = millis() - input->last_ms;
+  }
+}
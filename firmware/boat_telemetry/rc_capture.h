@@ -0,0 +1,49 @@
+// rc_capture.h
+// RC receiver PWM capture on the ESP-IDF 5.x RMT RX driver (driver/rmt_rx.h)
+// Each channel is armed for one frame at a time: the receive ends when the line has been
+// low for RC_FRAME_GAP_US, and the done callback (RMT ISR) measures that frame's single
+// high pulse, publishes it and re-arms. Every frame is judged on its own - a backlog can
+// no longer sum several pulses into one bogus width.
+// An optional sink runs in the ISR for each valid pulse (the throttle posts straight to
+// the audio engine). It must be integer-only: no FPU in interrupt context.
+
+#ifndef RC_CAPTURE_H
+#define RC_CAPTURE_H
+
+#include <stdint.h>
+
+#define RC_CAPTURE_RESOLUTION_HZ  1000000   // 1 tick = 1 us
+#define RC_PULSE_MIN_US           800       // Valid RC pulse range (nominal 1000-2000 us)
+#define RC_PULSE_MAX_US           2200
+#define RC_FRAME_GAP_US           3000      // Low this long ends a frame (pulse <= 2.2 ms, period ~20 ms)
+#define RC_GLITCH_NS              1000      // Shorter spikes are filtered by the RMT (ESP32 limit ~3 us)
+
+typedef enum {
+  RC_THROTTLE = 0,
+  RC_SERVO,
+  RC_CHANNEL_COUNT
+} RcChannel;
+
+// Called from the RMT ISR with each valid pulse width
+typedef void (*RcPulseSink)(uint32_t pulse_us);
+
+typedef struct {
+  uint32_t pulse_us;        // Last valid pulse (0 = none yet)
+  uint32_t age_ms;          // Since that pulse (UINT32_MAX = none yet)
+  uint32_t frames;          // Valid pulses since boot
+  uint32_t rejected;        // Frames without exactly one in-range high pulse
+  uint32_t rearm_failures;  // rmt_receive() refused in the ISR (channel re-armed by rcCapture_poll)
+} RcChannelStats;
+
+// Create, enable and arm the channel on pin (sink may be NULL)
+bool rcCapture_init(RcChannel channel, int pin, RcPulseSink sink);
+
+// Any task: re-arm a channel the ISR could not (cheap no-op otherwise)
+void rcCapture_poll();
+
+// Any task: latest pulse and its age. Returns false if no valid pulse yet
+bool rcCapture_latest(RcChannel channel, uint32_t* pulse_us, uint32_t* age_ms);
+
+void rcCapture_getStats(RcChannel channel, RcChannelStats* out);
+
+#endif // RC_CAPTURE_H
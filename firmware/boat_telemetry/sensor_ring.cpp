@@ -0,0 +1,58 @@
+// sensor_ring.cpp
+// Ring buffer of SensorSample entries (single writer, any number of readers)
+
+#include "sensor_ring.h"
+#include <Arduino.h>
+
+static SensorSample ring[SENSOR_RING_SIZE];
+static uint32_t nextSeq = 0;   // Guarded by ringMux
+static portMUX_TYPE ringMux = portMUX_INITIALIZER_UNLOCKED;
+
+void sensorRing_init() {
+  portENTER_CRITICAL(&ringMux);
+  memset(ring, 0, sizeof(ring));
+  nextSeq = 0;
+  portEXIT_CRITICAL(&ringMux);
+}
+
+uint32_t sensorRing_push(const SensorSample& sample) {
+  portENTER_CRITICAL(&ringMux);
+  uint32_t seq = nextSeq;
+  SensorSample* slot = &ring[seq & (SENSOR_RING_SIZE - 1)];
+  *slot = sample;
+  slot->seq = seq;
+  nextSeq = seq + 1;
+  portEXIT_CRITICAL(&ringMux);
+  return seq;
+}
+
+bool sensorRing_latest(SensorSample* out) {
+  bool have = false;
+  portENTER_CRITICAL(&ringMux);
+  if (nextSeq > 0) {
+    *out = ring[(nextSeq - 1) & (SENSOR_RING_SIZE - 1)];
+    have = true;
+  }
+  portEXIT_CRITICAL(&ringMux);
+  return have;
+}
+
+size_t sensorRing_read(uint32_t first_seq, SensorSample* out, size_t max) {
+  size_t n = 0;
+  portENTER_CRITICAL(&ringMux);
+  uint32_t oldest = nextSeq > SENSOR_RING_SIZE ? nextSeq - SENSOR_RING_SIZE : 0;
+  if (first_seq < oldest) first_seq = oldest;
+  // Copy in one pass; entries are 24 bytes so the critical section stays short
+  for (uint32_t seq = first_seq; seq < nextSeq && n < max; seq++) {
+    out[n++] = ring[seq & (SENSOR_RING_SIZE - 1)];
+  }
+  portEXIT_CRITICAL(&ringMux);
+  return n;
+}
+
+uint32_t sensorRing_nextSeq() {
+  portENTER_CRITICAL(&ringMux);
+  uint32_t seq = nextSeq;
+  portEXIT_CRITICAL(&ringMux);
+  return seq;
+}
@@ -0,0 +1,51 @@
+// sensor_ring.h
+// Fixed-rate sensor samples (battery, water, throttle, servo) in a preallocated ring buffer
+// Written only by the sensor task; HTTP handlers and later consumers (history,
+// streaming) copy entries out by sequence number
+
+#ifndef SENSOR_RING_H
+#define SENSOR_RING_H
+
+#include <stdint.h>
+#include <cstddef>
+
+#define SENSOR_RING_SIZE        256        // Entries (power of two) - ~5 s at 50 Hz
+
+// Sample flags
+#define SENSOR_FLAG_WATER_RAW_DRY   0x01   // Raw water input HIGH (pullup, dry)
+#define SENSOR_FLAG_WATER_BREACHED  0x02   // Debounced water state (hull breached)
+#define SENSOR_FLAG_THROTTLE_VALID  0x04   // Throttle frame received within the timeout
+#define SENSOR_FLAG_SERVO_VALID     0x08   // Servo frame received within the timeout
+#define SENSOR_FLAG_BATTERY_LOW     0x10   // Pack below BATTERY_LOW_MV (battery_monitor.h)
+
+// One sample (24 bytes)
+typedef struct {
+  uint32_t seq;             // Sample number since boot (assigned by sensorRing_push)
+  uint32_t timestamp_ms;    // millis() at sampling time
+  uint16_t battery_raw;     // Filtered ADC counts (0-4095)
+  uint16_t battery_mv;      // Filtered, calibrated pack voltage (0 = ADC not running)
+  uint16_t throttle_us;     // RC pulse width (1500 = neutral fallback)
+  uint16_t servo_us;        // RC pulse width (0 = no signal)
+  uint16_t throttle_age_ms; // Time since the last valid throttle frame (saturates at 65535)
+  uint16_t servo_age_ms;    // Time since the last valid servo frame (saturates at 65535)
+  uint8_t flags;            // SENSOR_FLAG_*
+  uint8_t reserved[3];
+} SensorSample;
+
+// Reset the ring (call before the sensor task starts)
+void sensorRing_init();
+
+// Sensor task: append a sample (overwrites the oldest once full), returns its seq
+uint32_t sensorRing_push(const SensorSample& sample);
+
+// Copy the newest sample (returns false until the first push)
+bool sensorRing_latest(SensorSample* out);
+
+// Copy up to max samples starting at seq first_seq (clamped to the oldest retained),
+// oldest first. Returns the number copied
+size_t sensorRing_read(uint32_t first_seq, SensorSample* out, size_t max);
+
+// Sequence number the next push will get (= total samples since boot)
+uint32_t sensorRing_nextSeq();
+
+#endif // SENSOR_RING_H
@@ -0,0 +1,48 @@
+// telemetry_frame.h
+// Packed binary /telemetry frame (opt-in with ?format=bin or Accept: application/octet-stream)
+// Same fields as the JSON response, numeric and fixed-layout. Little-endian, 40 bytes.
+// Any layout change bumps TELEMETRY_FRAME_VERSION; decoders must check magic + version.
+// App decoder: boat-telemetry-app/src/services/esp32Service.ts (decodeTelemetryFrame)
+
+#ifndef TELEMETRY_FRAME_H
+#define TELEMETRY_FRAME_H
+
+#include <stdint.h>
+
+#define TELEMETRY_FRAME_MAGIC       0x4654  // "TF" little-endian
+#define TELEMETRY_FRAME_VERSION     1
+#define TELEMETRY_FRAME_MIME        "application/octet-stream"
+
+// flags
+#define TELEMETRY_FLAG_WATER_INTRUSION  0x01   // Debounced water state (hull breached)
+#define TELEMETRY_FLAG_WATER_RAW_DRY    0x02   // Raw water input (1 = dry)
+#define TELEMETRY_FLAG_BATTERY_LOW      0x04
+#define TELEMETRY_FLAG_RUNNING_LIGHTS   0x08
+#define TELEMETRY_FLAG_FLOOD_LIGHTS     0x10
+#define TELEMETRY_FLAG_DFPLAYER         0x20   // DFPlayer available
+#define TELEMETRY_FLAG_ENGINE_MUTED     0x40
+#define TELEMETRY_FLAG_WIFI_CONNECTED   0x80
+
+typedef struct __attribute__((packed)) {
+  uint16_t magic;           // TELEMETRY_FRAME_MAGIC
+  uint8_t version;          // TELEMETRY_FRAME_VERSION
+  uint8_t flags;            // TELEMETRY_FLAG_*
+  uint32_t timestamp_ms;    // millis() when the sample was taken (JSON "timestamp")
+  uint32_t uptime_s;
+  uint32_t free_heap;       // Bytes
+  uint32_t sensor_seq;      // SensorSample sequence number the frame was built from
+  uint8_t ip[4];            // Station IP, dotted-quad order
+  uint16_t battery_mv;      // Pack voltage
+  uint16_t battery_pin_mv;  // Voltage at the ADC pin
+  uint16_t battery_adc_raw; // Filtered ADC counts
+  uint16_t throttle_us;     // RC pulse width
+  uint16_t servo_us;        // RC pulse width (0 = no signal)
+  uint16_t throttle_age_ms;
+  uint16_t servo_age_ms;
+  int8_t rssi_dbm;
+  uint8_t water_wet_duty_pct;  // Raw wet time over the last minute (was reserved, always 0 before)
+} TelemetryFrame;
+
+static_assert(sizeof(TelemetryFrame) == 40, "TelemetryFrame layout changed - bump TELEMETRY_FRAME_VERSION");
+
+#endif // TELEMETRY_FRAME_H
@@ -0,0 +1,164 @@
+// water_sensor.cpp
+// Edge-interrupt water probe: ISR edge queue, edge-timed debounce, wet statistics
+
+#include "water_sensor.h"
+#include <Arduino.h>
+#include <atomic>
+#include "hal/gpio_ll.h"
+
+typedef struct {
+  int64_t time_us;          // esp_timer_get_time() at the interrupt
+  bool dry;                 // Pin level read in the ISR (HIGH = dry)
+} WaterEdge;
+
+// Edge queue: the ISR owns head, the sensor task owns tail
+static WaterEdge edgeQueue[WATER_EDGE_QUEUE_SIZE];
+static std::atomic<uint32_t> queueHead(0);
+static std::atomic<uint32_t> queueTail(0);
+static volatile uint32_t queueOverflows = 0;
+static uint8_t sensorPin = 0;
+
+// Debounce and integration state (sensor task)
+static bool rawDry = true;
+static int64_t rawSinceUs = 0;          // Time of the edge that set rawDry
+static bool spellStarted = false;       // A wet spell has been seen (onset is valid)
+static int64_t accountedUs = 0;         // Wet time integrated up to here
+static int64_t windowStartUs = 0;
+static int64_t windowWetUs = 0;
+static int64_t wetTotalUs = 0;
+static uint32_t seenOverflows = 0;
+
+// Published (written by the sensor task, read by any task)
+static volatile bool publishedRawDry = true;
+static volatile bool breached = false;
+static volatile uint8_t wetDutyPct = 0;
+static volatile uint32_t firstWetMs = 0;
+static volatile uint32_t wetOnsetMs = 0;
+static volatile uint32_t wetTotalMs = 0;
+static volatile uint32_t wetEdges = 0;
+static volatile uint32_t edgeCount = 0;
+
+static void IRAM_ATTR onEdge() {
+  uint32_t head = queueHead.load(std::memory_order_relaxed);
+  if (head - queueTail.load(std::memory_order_acquire) >= WATER_EDGE_QUEUE_SIZE) {
+    queueOverflows++;
+    return;
+  }
+  WaterEdge& edge = edgeQueue[head & (WATER_EDGE_QUEUE_SIZE - 1)];
+  edge.time_us = esp_timer_get_time();
+  edge.dry = gpio_ll_get_level(&GPIO, sensorPin) != 0;
+  queueHead.store(head + 1, std::memory_order_release);
+}
+
+// millis() timebase for an esp_timer time (0 is reserved for "never")
+static uint32_t toMillis(int64_t us) {
+  uint32_t ms = (uint32_t)(us / 1000);
+  return ms ? ms : 1;
+}
+
+static void integrateTo(int64_t t) {
+  if (t <= accountedUs) return;
+  if (!rawDry) {
+    windowWetUs += t - accountedUs;
+    wetTotalUs += t - accountedUs;
+    wetTotalMs = (uint32_t)(wetTotalUs / 1000);
+  }
+  accountedUs = t;
+}
+
+// The alarm follows the raw level once it has held for WATER_DEBOUNCE_MS (judged at time t)
+static void debounceAt(int64_t t) {
+  if (breached != !rawDry && t - rawSinceUs >= (int64_t)WATER_DEBOUNCE_MS * 1000) {
+    breached = !rawDry;
+  }
+}
+
+static void applyLevel(bool dry, int64_t t) {
+  debounceAt(t);
+  if (dry == rawDry) return;   // Bounce read back the level already held
+  integrateTo(t);
+  if (!dry) {
+    wetEdges++;
+    if (firstWetMs == 0) firstWetMs = toMillis(t);
+    // A new wet spell starts after the probe has been dry for a full debounce time;
+    // shorter dry gaps belong to the same (intermittent) leak
+    if (!spellStarted || t - rawSinceUs >= (int64_t)WATER_DEBOUNCE_MS * 1000) {
+      wetOnsetMs = toMillis(t);
+      spellStarted = true;
+    }
+  }
+  rawDry = dry;
+  rawSinceUs = t;
+  publishedRawDry = dry;
+  edgeCount++;
+}
+
+bool waterSensor_init(uint8_t pin) {
+  sensorPin = pin;
+  pinMode(pin, INPUT_PULLUP);
+  int64_t now = esp_timer_get_time();
+  rawDry = digitalRead(pin) == HIGH;
+  rawSinceUs = now;
+  accountedUs = now;
+  windowStartUs = now;
+  publishedRawDry = rawDry;
+  breached = false;   // Start as secure; a wet probe raises the alarm after the debounce time
+  if (!rawDry) {
+    firstWetMs = toMillis(now);
+    wetOnsetMs = firstWetMs;
+    spellStarted = true;
+  }
+  attachInterrupt(digitalPinToInterrupt(pin), onEdge, CHANGE);
+  return true;
+}
+
+void waterSensor_update() {
+  uint32_t tail = queueTail.load(std::memory_order_relaxed);
+  uint32_t head = queueHead.load(std::memory_order_acquire);
+  while (tail != head) {
+    const WaterEdge& edge = edgeQueue[tail & (WATER_EDGE_QUEUE_SIZE - 1)];
+    applyLevel(edge.dry, edge.time_us);
+    tail++;
+  }
+  queueTail.store(tail, std::memory_order_release);
+
+  int64_t now = esp_timer_get_time();
+  uint32_t overflows = queueOverflows;
+  if (overflows != seenOverflows) {
+    // Edges were lost: take the pin as it is now
+    seenOverflows = overflows;
+    applyLevel(digitalRead(sensorPin) == HIGH, now);
+  }
+  debounceAt(now);
+  integrateTo(now);
+
+  if (now - windowStartUs >= (int64_t)WATER_DUTY_WINDOW_MS * 1000) {
+    wetDutyPct = (uint8_t)(windowWetUs * 100 / (now - windowStartUs));
+    windowStartUs = now;
+    windowWetUs = 0;
+  }
+}
+
+bool waterSensor_isRawDry() {
+  return publishedRawDry;
+}
+
+bool waterSensor_isBreached() {
+  return breached;
+}
+
+uint8_t waterSensor_getWetDutyPct() {
+  return wetDutyPct;
+}
+
+void waterSensor_getStats(WaterSensorStats* out) {
+  out->raw_dry = publishedRawDry;
+  out->breached = breached;
+  out->wet_duty_pct = wetDutyPct;
+  out->first_wet_ms = firstWetMs;
+  out->wet_onset_ms = wetOnsetMs;
+  out->wet_total_ms = wetTotalMs;
+  out->wet_edges = wetEdges;
+  out->edges = edgeCount;
+  out->queue_overflows = queueOverflows;
+}
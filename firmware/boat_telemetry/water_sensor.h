@@ -0,0 +1,45 @@
+// water_sensor.h
+// Water intrusion probe on a GPIO edge interrupt
+// The ISR timestamps every transition (esp_timer, us) into a small single-producer /
+// single-consumer queue; the sensor task drains it and computes the debounced state
+// from the edge times, so leak onset is known to the millisecond instead of to the
+// sampling pass. Between edges nothing runs.
+// Debounce: the raw level must hold for WATER_DEBOUNCE_MS before the alarm state
+// follows it. Seeps that come and go faster than that never raise the alarm, but they
+// still show up in the wet duty cycle and the first-wet / onset times.
+
+#ifndef WATER_SENSOR_H
+#define WATER_SENSOR_H
+
+#include <stdint.h>
+
+#define WATER_DEBOUNCE_MS       10000   // Raw level must hold this long to change the alarm state
+#define WATER_EDGE_QUEUE_SIZE   32      // Edges buffered between sensor passes (power of two)
+#define WATER_DUTY_WINDOW_MS    60000   // Wet duty cycle is reported per window
+
+typedef struct {
+  bool raw_dry;               // Current raw level (pullup: HIGH = dry)
+  bool breached;              // Debounced alarm state
+  uint8_t wet_duty_pct;       // Raw wet time in the last complete duty window (0-100)
+  uint32_t first_wet_ms;      // millis() of the first wet edge since boot (0 = never wet)
+  uint32_t wet_onset_ms;      // millis() of the wet edge that started the current / last wet spell
+  uint32_t wet_total_ms;      // Raw wet time since boot
+  uint32_t wet_edges;         // Dry -> wet transitions since boot
+  uint32_t edges;             // All transitions taken from the queue
+  uint32_t queue_overflows;   // Edges dropped with the queue full (state resynced from the pin)
+} WaterSensorStats;
+
+// Configure the pin (INPUT_PULLUP) and attach the edge interrupt
+bool waterSensor_init(uint8_t pin);
+
+// Sensor task: drain queued edges and update the debounced state (never blocks)
+void waterSensor_update();
+
+bool waterSensor_isRawDry();
+bool waterSensor_isBreached();
+uint8_t waterSensor_getWetDutyPct();
+
+// Any task: copy of the statistics (fields are individually consistent)
+void waterSensor_getStats(WaterSensorStats* out);
+
+#endif // WATER_SENSOR_H
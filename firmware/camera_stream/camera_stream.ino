@@ -1,13 +1,22 @@
 /*
  * camera_stream.ino
  * Minimal ESP32-CAM firmware for MJPEG streaming
- * Serves /stream endpoint with CORS headers for web app integration
+ * Control server (port 80): /status, /still, /settings, /ota - /stream redirects to port 81
+ * Stream server (port 81): /stream (MJPEG), in its own httpd task
+ * All endpoints send CORS headers for web app integration
+ * Every MJPEG part carries X-Timestamp (capture time, Unix seconds once SNTP has synced)
+ * and X-Frame-Seq, to line video up with the boat's telemetry (same clock, time_sync.h)
  */
 
 #include "esp_camera.h"
 #include <WiFi.h>
 #include "esp_http_server.h"
 #include "secrets.h"
+#include "frame_hub.h"            // Shared capture task + frame fan-out
+#include <wifi_link.h>            // Event-driven WiFi with cached-BSSID reconnect
+#include <discovery.h>            // mDNS _edmund._tcp + UDP discovery beacon
+#include <ota_stream.h>           // HTTP OTA with gzip / delta images (POST /ota)
+#include <time_sync.h>            // SNTP wall clock shared with the boat (frame X-Timestamp)
 
 // ==================== CAMERA MODEL ====================
 #define CAMERA_MODEL_AI_THINKER
@@ -17,271 +26,796 @@
 #define FIRMWARE_VERSION   "1.0.0"
 #define BUILD_ID           "20260109"             // YYYYMMDD format
 
+// ==================== OTA ====================
+#define OTA_PASSWORD         "boat2026"   // X-OTA-Password header on POST /ota (same as the boat)
+#define OTA_RESTART_DELAY_MS 1000         // Reboot into the new image after the /ota response is out
+
+// ==================== HTTP SERVERS ====================
+// Two httpd instances, each with its own task: the MJPEG loop occupies the stream
+// server's worker for as long as a viewer is connected, so control requests must
+// not queue behind it
+#define CONTROL_HTTP_PORT   80
+#define STREAM_HTTP_PORT    81
+#define STREAM_MAX_CLIENTS  3    // Concurrent /stream viewers (one sender task each)
+
+// ==================== CAMERA SETTINGS ====================
+#define CAMERA_MAX_FRAMESIZE FRAMESIZE_SVGA  // Framebuffers are allocated for this size
+// One framebuffer per viewer and /still (each may hold a frame while sending), plus
+// the hub's newest frame and one for the driver to fill, so capture never waits
+#define CAMERA_FB_COUNT     (STREAM_MAX_CLIENTS + 3)
+
+// ==================== ADAPTIVE STREAM QUALITY ====================
+// Stream modes from smallest to largest; the adaptive controller steps through them
+// to hold the target frame rate for the slowest viewer
+#define STREAM_TARGET_FPS    10       // Default frame rate to hold
+#define STREAM_MODE_DEFAULT  2        // QVGA q20 (the old fixed setting)
+#define ADAPT_INTERVAL_MS    500      // Controller period (loop)
+#define ADAPT_HOLD_MS        3000     // Settle time after a mode change
+#define ADAPT_DOWN_MS        1500     // Below target this long -> step down
+#define ADAPT_UP_MS          6000     // Headroom this long -> step up
+#define ADAPT_DOWN_RATIO     0.85f    // "Below target": capacity < target x this
+#define ADAPT_UP_RATIO       1.8f     // "Headroom": capacity > target x this
+#define ADAPT_EWMA_ALPHA     0.2f     // Per-frame smoothing of send time and frame rate
+
+typedef struct {
+  framesize_t size;
+  int quality;              // JPEG quality (lower = better, bigger frames)
+} StreamMode;
+
+static const StreamMode STREAM_MODES[] = {
+  { FRAMESIZE_QQVGA, 25 },
+  { FRAMESIZE_QVGA,  30 },
+  { FRAMESIZE_QVGA,  20 },
+  { FRAMESIZE_QVGA,  12 },
+  { FRAMESIZE_CIF,   15 },
+  { FRAMESIZE_VGA,   15 },
+  { FRAMESIZE_VGA,   12 },
+  { FRAMESIZE_SVGA,  12 },
+};
+#define STREAM_MODE_COUNT  (int)(sizeof(STREAM_MODES) / sizeof(STREAM_MODES[0]))
+
 // ==================== GLOBALS ====================
 httpd_handle_t stream_httpd = NULL;
 httpd_handle_t control_httpd = NULL;
+SemaphoreHandle_t sensorLock = NULL;       // Serializes sensor_t changes (settings vs. controller)
+volatile bool streamAdaptive = true;       // Controller owns framesize/quality
+volatile int streamModeLevel = STREAM_MODE_DEFAULT;
+volatile int streamTargetFps = STREAM_TARGET_FPS;
+volatile int streamMaxFps = 0;             // Per-viewer send cap (0 = uncapped)
+
+// One sender task per viewer slot (declared above the first function, where the
+// Arduino builder inserts its generated prototypes - sendStream() takes a StreamSlot*)
+typedef struct {
+  httpd_req_t* req;           // Async copy of the /stream request
+  SemaphoreHandle_t start;    // Given by stream_handler when req is set
+  volatile bool active;
+  uint32_t frames_sent;
+  uint32_t frames_skipped;    // Newer frames arrived while the previous one was sending
+  float send_ms_avg;          // Time to push one frame through httpd_resp_send_chunk
+  float bytes_avg;            // Frame size
+  float fps_avg;              // Frames delivered per second
+  float delay_ms_avg;         // Capture to start of send (on-board share of video latency)
+  uint32_t connected_ms;
+  uint64_t bytes_sent;
+  // Per-second counters for /status (sender task writes, status reads the last full window)
+  uint32_t window_start_ms;
+  uint32_t window_frames;
+  uint32_t window_bytes;
+  uint32_t window_skipped;
+  float window_fps;
+  uint32_t window_bytes_per_s;
+  uint32_t window_dropped;
+} StreamSlot;
+
+StreamSlot streamSlots[STREAM_MAX_CLIENTS];
+
+// ==================== WIFI NETWORKS ====================
+// Home WiFi first, iPhone hotspot as fallback (wifi_link tries the cached AP before scanning)
+const WifiCandidate WIFI_NETWORKS[] = {
+  { HOME_WIFI_SSID, HOME_WIFI_PASSWORD, false, false },
+  { HOTSPOT_SSID,   HOTSPOT_PASSWORD,   false, false },
+};
+
+// mDNS records and UDP beacon reply (the app finds the camera without a subnet sweep)
+const DiscoveryInfo DISCOVERY_INFO = {
+  "edmund-camera",
+  "camera",
+  "Edmund Fitzgerald Camera",
+  FIRMWARE_VERSION,
+  BUILD_ID,
+  CONTROL_HTTP_PORT,
+  STREAM_HTTP_PORT
+};
+
+// Runs in the WiFi link task after every (re)connection
+void onWiFiConnected() {
+  Serial.print("Camera stream available at: http://");
+  Serial.print(WiFi.localIP());
+  Serial.printf(":%d/stream\n", STREAM_HTTP_PORT);
+  timeSync_start();   // Frame stamps switch to Unix time at the first SNTP answer
+}
 
-// ==================== WIFI CONNECT ====================
-void connectWiFi() {
-  Serial.println();
-  Serial.println("Scanning for WiFi networks...");
-
-  WiFi.mode(WIFI_STA);
-  int numNetworks = WiFi.scanNetworks();
-  
-  Serial.print("Networks found: ");
-  Serial.println(numNetworks);
-  
-  String ssidToConnect = "";
-  String passwordToUse = "";
-  bool foundHomeWiFi = false;
-  
-  for (int i = 0; i < numNetworks; i++) {
-    String scannedSSID = WiFi.SSID(i);
-    Serial.print("[");
-    Serial.print(i);
-    Serial.print("] ");
-    Serial.println(scannedSSID);
-    
-    if (scannedSSID == HOME_WIFI_SSID) {
-      ssidToConnect = scannedSSID;
-      passwordToUse = HOME_WIFI_PASSWORD;
-      foundHomeWiFi = true;
-      Serial.println(">>> Matched home WiFi");
-      break;
-    }
-  }
-  
-  // Fallback to iPhone hotspot
-  if (!foundHomeWiFi) {
-    for (int i = 0; i < numNetworks; i++) {
-      String scannedSSID = WiFi.SSID(i);
-      if (scannedSSID == HOTSPOT_SSID) {
-        ssidToConnect = scannedSSID;
-        passwordToUse = HOTSPOT_PASSWORD;
-        Serial.print(">>> Using iPhone hotspot: ");
-        Serial.println(ssidToConnect);
-        break;
-      }
-    }
-  }
-
-  if (ssidToConnect.length() == 0) {
-    Serial.println("No known networks found!");
-    return;
-  }
-
-  Serial.print("Connecting to: ");
-  Serial.println(ssidToConnect);
-  WiFi.begin(ssidToConnect.c_str(), passwordToUse.c_str());
-
-  int attempts = 0;
-  while (WiFi.status() != WL_CONNECTED && attempts < 40) {
-    delay(500);
-    Serial.print(".");
-    attempts++;
-  }
-
-  if (WiFi.status() == WL_CONNECTED) {
-    Serial.println();
-    Serial.println("WiFi connected!");
-    Serial.print("Camera stream available at: http://");
-    Serial.print(WiFi.localIP());
-    Serial.println("/stream");
-  } else {
-    Serial.println();
-    Serial.println("WiFi connection failed!");
-  }
+// ==================== CORS HELPER ====================
+void setCorsHeaders(httpd_req_t *req) {
+  httpd_resp_set_hdr(req, "Access-Control-Allow-Origin", "*");
+  httpd_resp_set_hdr(req, "Access-Control-Allow-Methods", "GET, POST, OPTIONS");
+  httpd_resp_set_hdr(req, "Access-Control-Allow-Headers", "Content-Type");
 }
 
-// ==================== MJPEG STREAM HANDLER ====================
+// ==================== MJPEG STREAM (FAN-OUT) ====================
+// The capture task (frame_hub.h) grabs each frame once. Every viewer gets a sender
+// task; /stream hands the request over with httpd_req_async_handler_begin() so the
+// stream server's worker is free again at once. A sender always picks the newest
+// frame, so a slow viewer skips frames instead of holding back the others.
 #define PART_BOUNDARY "123456789000000000000987654321"
 static const char* _STREAM_CONTENT_TYPE = "multipart/x-mixed-replace;boundary=" PART_BOUNDARY;
 static const char* _STREAM_BOUNDARY = "\r\n--" PART_BOUNDARY "\r\n";
-static const char* _STREAM_PART = "Content-Type: image/jpeg\r\nContent-Length: %u\r\n\r\n";
+static const char* _STREAM_PART = "Content-Type: image/jpeg\r\nContent-Length: %u\r\n"
+                                   "X-Timestamp: %lld.%06ld\r\nX-Timestamp-Source: %s\r\nX-Frame-Seq: %lu\r\n\r\n";
 
-esp_err_t stream_handler(httpd_req_t *req) {
-  camera_fb_t *fb = NULL;
-  esp_err_t res = ESP_OK;
-  size_t _jpg_buf_len = 0;
-  uint8_t *_jpg_buf = NULL;
-  char part_buf[64];
+#define STREAM_FRAME_TIMEOUT_MS  3000   // No frame for this long = camera stalled, end the stream
+
+int activeStreamClients() {
+  int n = 0;
+  for (int i = 0; i < STREAM_MAX_CLIENTS; i++) {
+    if (streamSlots[i].active) n++;
+  }
+  return n;
+}
+
+// Send frames to one viewer until the connection fails
+esp_err_t sendStream(StreamSlot* slot) {
+  httpd_req_t* req = slot->req;
+  char part_buf[160];
+  char framerate[8];
+  uint32_t last_seq = 0;
+  uint32_t last_start_ms = 0;
 
   // CORS headers - very permissive for web app access
-  httpd_resp_set_hdr(req, "Access-Control-Allow-Origin", "*");
-  httpd_resp_set_hdr(req, "Access-Control-Allow-Methods", "GET, OPTIONS");
-  httpd_resp_set_hdr(req, "Access-Control-Allow-Headers", "Content-Type");
+  setCorsHeaders(req);
   httpd_resp_set_hdr(req, "Cache-Control", "no-cache, no-store, must-revalidate");
   httpd_resp_set_hdr(req, "Pragma", "no-cache");
-  httpd_resp_set_hdr(req, "X-Framerate", "10");
-
-  res = httpd_resp_set_type(req, _STREAM_CONTENT_TYPE);
-  if (res != ESP_OK) {
-    return res;
-  }
+  snprintf(framerate, sizeof(framerate), "%d", streamMaxFps > 0 ? streamMaxFps : streamTargetFps);
+  httpd_resp_set_hdr(req, "X-Framerate", framerate);
+  esp_err_t res = httpd_resp_set_type(req, _STREAM_CONTENT_TYPE);
+
+  while (res == ESP_OK) {
+    // Optional frame-rate cap
+    int max_fps = streamMaxFps;
+    if (max_fps > 0 && last_start_ms) {
+      int32_t wait_ms = 1000 / max_fps - (int32_t)(millis() - last_start_ms);
+      if (wait_ms > 0) vTaskDelay(pdMS_TO_TICKS(wait_ms));
+    }
 
-  while (true) {
-    fb = esp_camera_fb_get();
-    if (!fb) {
-      Serial.println("Camera capture failed");
+    CameraFrame* frame = frameHub_acquire(last_seq, pdMS_TO_TICKS(STREAM_FRAME_TIMEOUT_MS));
+    if (!frame) {
+      Serial.println("Stream: no frame from camera");
       res = ESP_FAIL;
-    } else {
-      if (fb->format != PIXFORMAT_JPEG) {
-        bool jpeg_converted = frame2jpg(fb, 80, &_jpg_buf, &_jpg_buf_len);
-        esp_camera_fb_return(fb);
-        fb = NULL;
-        if (!jpeg_converted) {
-          Serial.println("JPEG compression failed");
-          res = ESP_FAIL;
-        }
-      } else {
-        _jpg_buf_len = fb->len;
-        _jpg_buf = fb->buf;
-      }
+      break;
     }
-
-    if (res == ESP_OK) {
-      res = httpd_resp_send_chunk(req, _STREAM_BOUNDARY, strlen(_STREAM_BOUNDARY));
+    uint32_t skipped = 0;
+    if (last_seq && frame->seq > last_seq + 1) {
+      skipped = frame->seq - last_seq - 1;
+      slot->frames_skipped += skipped;
     }
+    last_seq = frame->seq;
+
+    // Capture time on the shared clock (seconds since boot until SNTP has synced)
+    int64_t stamp_us = timeSync_epochUs(frame->timestamp_us);
+    const char* stamp_source = "sntp";
+    if (stamp_us == 0) {
+      stamp_us = frame->timestamp_us;
+      stamp_source = "boot";
+    }
+    // fb->timestamp is esp_timer time on current drivers; older ones stamp wall time
+    bool monotonic_stamp = frame->timestamp_us < TIME_SYNC_EPOCH_MIN_US;
+    int64_t delay_us = esp_timer_get_time() - frame->timestamp_us;
+
+    uint32_t start_ms = millis();
+    res = httpd_resp_send_chunk(req, _STREAM_BOUNDARY, strlen(_STREAM_BOUNDARY));
     if (res == ESP_OK) {
-      size_t hlen = snprintf(part_buf, 64, _STREAM_PART, _jpg_buf_len);
+      size_t hlen = snprintf(part_buf, sizeof(part_buf), _STREAM_PART, frame->len,
+                             (long long)(stamp_us / 1000000), (long)(stamp_us % 1000000), stamp_source,
+                             (unsigned long)frame->seq);
       res = httpd_resp_send_chunk(req, part_buf, hlen);
     }
     if (res == ESP_OK) {
-      res = httpd_resp_send_chunk(req, (const char *)_jpg_buf, _jpg_buf_len);
+      res = httpd_resp_send_chunk(req, (const char *)frame->jpg, frame->len);
+    }
+    size_t frame_len = frame->len;
+    frameHub_release(frame);
+    if (res != ESP_OK) break;
+
+    // Throughput measurements for the adaptive controller
+    float send_ms = (float)(millis() - start_ms);
+    if (slot->frames_sent == 0) {
+      slot->send_ms_avg = send_ms;
+      slot->bytes_avg = frame_len;
+    } else {
+      slot->send_ms_avg += ADAPT_EWMA_ALPHA * (send_ms - slot->send_ms_avg);
+      slot->bytes_avg += ADAPT_EWMA_ALPHA * ((float)frame_len - slot->bytes_avg);
+    }
+    if (last_start_ms) {
+      uint32_t interval_ms = start_ms - last_start_ms;
+      float fps = 1000.0f / (interval_ms > 0 ? interval_ms : 1);
+      slot->fps_avg = slot->frames_sent <= 1 ? fps : slot->fps_avg + ADAPT_EWMA_ALPHA * (fps - slot->fps_avg);
     }
+    last_start_ms = start_ms;
+    slot->frames_sent++;
+    slot->bytes_sent += frame_len;
 
-    if (fb) {
-      esp_camera_fb_return(fb);
-      fb = NULL;
-      _jpg_buf = NULL;
-    } else if (_jpg_buf) {
-      free(_jpg_buf);
-      _jpg_buf = NULL;
+    if (monotonic_stamp && delay_us >= 0) {
+      float delay_ms = delay_us / 1000.0f;
+      slot->delay_ms_avg = slot->frames_sent == 1 ? delay_ms : slot->delay_ms_avg + ADAPT_EWMA_ALPHA * (delay_ms - slot->delay_ms_avg);
     }
 
-    if (res != ESP_OK) {
-      break;
+    // Counters over whole seconds (what /status reports per stream)
+    slot->window_frames++;
+    slot->window_bytes += frame_len;
+    slot->window_skipped += skipped;
+    uint32_t window_ms = millis() - slot->window_start_ms;
+    if (window_ms >= 1000) {
+      slot->window_fps = slot->window_frames * 1000.0f / window_ms;
+      slot->window_bytes_per_s = (uint32_t)((uint64_t)slot->window_bytes * 1000 / window_ms);
+      slot->window_dropped = slot->window_skipped;
+      slot->window_start_ms = millis();
+      slot->window_frames = 0;
+      slot->window_bytes = 0;
+      slot->window_skipped = 0;
     }
   }
-
   return res;
 }
 
+void streamSenderTask(void* param) {
+  StreamSlot* slot = (StreamSlot*)param;
+  while (true) {
+    xSemaphoreTake(slot->start, portMAX_DELAY);
+    slot->frames_sent = 0;
+    slot->frames_skipped = 0;
+    slot->send_ms_avg = 0.0f;
+    slot->bytes_avg = 0.0f;
+    slot->fps_avg = 0.0f;
+    slot->delay_ms_avg = 0.0f;
+    slot->connected_ms = millis();
+    slot->bytes_sent = 0;
+    slot->window_start_ms = millis();
+    slot->window_frames = 0;
+    slot->window_bytes = 0;
+    slot->window_skipped = 0;
+    slot->window_fps = 0.0f;
+    slot->window_bytes_per_s = 0;
+    slot->window_dropped = 0;
+    frameHub_subscribe();
+    Serial.printf("Stream client connected (%d/%d)\n", activeStreamClients(), STREAM_MAX_CLIENTS);
+
+    sendStream(slot);
+
+    frameHub_unsubscribe();
+    httpd_req_async_handler_complete(slot->req);
+    slot->req = NULL;
+    slot->active = false;
+    Serial.printf("Stream client disconnected after %lu frames (%lu skipped)\n",
+                  (unsigned long)slot->frames_sent, (unsigned long)slot->frames_skipped);
+  }
+}
+
+void setupStreamSenders() {
+  for (int i = 0; i < STREAM_MAX_CLIENTS; i++) {
+    streamSlots[i].start = xSemaphoreCreateBinary();
+    streamSlots[i].active = false;
+    xTaskCreate(streamSenderTask, "StreamSend", 4096, &streamSlots[i], 4, NULL);
+  }
+}
+
+esp_err_t stream_handler(httpd_req_t *req) {
+  setCorsHeaders(req);
+
+  // Only the stream server task claims slots, so no lock is needed here
+  StreamSlot* slot = NULL;
+  for (int i = 0; i < STREAM_MAX_CLIENTS && !slot; i++) {
+    if (!streamSlots[i].active) slot = &streamSlots[i];
+  }
+  if (!slot) {
+    httpd_resp_set_status(req, "503 Service Unavailable");
+    httpd_resp_set_type(req, "application/json");
+    return httpd_resp_sendstr(req, "{\"error\":\"Too many stream clients\"}");
+  }
+
+  httpd_req_t* async_req = NULL;
+  if (httpd_req_async_handler_begin(req, &async_req) != ESP_OK) {
+    httpd_resp_send_500(req);
+    return ESP_FAIL;
+  }
+  slot->req = async_req;
+  slot->active = true;
+  xSemaphoreGive(slot->start);
+  return ESP_OK;
+}
+
+// ==================== STREAM REDIRECT ====================
+// Old clients still ask the control port for /stream
+esp_err_t stream_redirect_handler(httpd_req_t *req) {
+  char location[48];
+  snprintf(location, sizeof(location), "http://%s:%d/stream",
+           WiFi.localIP().toString().c_str(), STREAM_HTTP_PORT);
+  setCorsHeaders(req);
+  httpd_resp_set_status(req, "302 Found");
+  httpd_resp_set_hdr(req, "Location", location);
+  return httpd_resp_send(req, NULL, 0);
+}
+
 // ==================== STATUS HANDLER ====================
+// Sized for every viewer slot in use with worst-case field widths
+#define STATUS_JSON_HEAD_MAX    640   // Everything up to "streams":[ plus the closing ]}
+#define STATUS_JSON_STREAM_MAX  256   // One "streams" entry
+#define STATUS_JSON_MAX  (STATUS_JSON_HEAD_MAX + STREAM_MAX_CLIENTS * STATUS_JSON_STREAM_MAX)
+
 esp_err_t status_handler(httpd_req_t *req) {
-  httpd_resp_set_hdr(req, "Access-Control-Allow-Origin", "*");
+  setCorsHeaders(req);
   httpd_resp_set_type(req, "application/json");
   
-  char json[256];
-  snprintf(json, sizeof(json),
-    "{\"firmware_version\":\"%s\",\"build_id\":\"%s\",\"camera\":\"online\",\"ip\":\"%s\",\"rssi\":%d}",
+  float worst_fps, worst_send_ms, worst_bytes;
+  worstStreamSlot(&worst_fps, &worst_send_ms, &worst_bytes);
+  sensor_t *s = esp_camera_sensor_get();
+
+  static char json[STATUS_JSON_MAX];   // Static, the control server task is single-threaded
+  int len = snprintf(json, sizeof(json),
+    "{\"type\":\"camera\",\"name\":\"%s\",\"firmware_version\":\"%s\",\"build_id\":\"%s\",\"camera\":\"online\",\"ip\":\"%s\",\"rssi\":%d,"
+    "\"stream_port\":%d,\"stream_clients\":%d,\"stream_max_clients\":%d,\"frames_captured\":%lu,"
+    "\"adaptive\":%s,\"stream_mode\":%d,\"framesize\":\"%s\",\"quality\":%d,"
+    "\"target_fps\":%d,\"max_fps\":%d,\"stream_fps\":%.1f,\"stream_send_ms\":%.1f,\"stream_frame_bytes\":%.0f,"
+    "\"clock_synced\":%s,\"clock_sync_age_ms\":%ld,\"epoch_ms\":%lld,\"streams\":[",
+    DISCOVERY_INFO.name,
     FIRMWARE_VERSION,
     BUILD_ID,
     WiFi.localIP().toString().c_str(),
-    WiFi.RSSI()
+    WiFi.RSSI(),
+    STREAM_HTTP_PORT,
+    activeStreamClients(),
+    STREAM_MAX_CLIENTS,
+    (unsigned long)frameHub_framesCaptured(),
+    streamAdaptive ? "true" : "false",
+    streamModeLevel,
+    s ? frameSizeName(s->status.framesize) : "unknown",
+    s ? s->status.quality : 0,
+    streamTargetFps,
+    streamMaxFps,
+    worst_fps,
+    worst_send_ms,
+    worst_bytes,
+    timeSync_isSynced() ? "true" : "false",
+    timeSync_isSynced() ? (long)timeSync_lastSyncAgeMs() : -1L,
+    (long long)(timeSync_epochUs(esp_timer_get_time()) / 1000)
   );
-  
-  return httpd_resp_sendstr(req, json);
+
+  // Per viewer: last whole second of fps / bytes / frames dropped (skipped for newer ones)
+  bool first = true;
+  for (int i = 0; i < STREAM_MAX_CLIENTS && len > 0 && len < (int)sizeof(json); i++) {
+    StreamSlot* slot = &streamSlots[i];
+    if (!slot->active) continue;
+    len += snprintf(json + len, sizeof(json) - len,
+      "%s{\"slot\":%d,\"connected_s\":%lu,\"fps\":%.1f,\"bytes_per_s\":%lu,\"dropped_per_s\":%lu,"
+      "\"frames_sent\":%lu,\"frames_dropped\":%lu,\"bytes_sent\":%llu,\"send_ms\":%.1f,\"capture_delay_ms\":%.1f}",
+      first ? "" : ",",
+      i,
+      (unsigned long)((millis() - slot->connected_ms) / 1000),
+      slot->window_fps,
+      (unsigned long)slot->window_bytes_per_s,
+      (unsigned long)slot->window_dropped,
+      (unsigned long)slot->frames_sent,
+      (unsigned long)slot->frames_skipped,
+      (unsigned long long)slot->bytes_sent,
+      slot->send_ms_avg,
+      slot->delay_ms_avg
+    );
+    first = false;
+  }
+  if (len > 0 && len < (int)sizeof(json)) len += snprintf(json + len, sizeof(json) - len, "]}");
+
+  // A truncated body is not JSON: report it rather than send half an object
+  if (len <= 0 || len >= (int)sizeof(json)) {
+    Serial.printf("✗ /status body overflowed %d bytes\n", (int)sizeof(json));
+    httpd_resp_set_status(req, "500 Internal Server Error");
+    return httpd_resp_sendstr(req, "{\"error\":\"Status response too large\"}");
+  }
+  return httpd_resp_send(req, json, len);
 }
 
 // ==================== STILL IMAGE HANDLER ====================
+// Shares the capture task with the viewers (no competing esp_camera_fb_get)
 esp_err_t still_handler(httpd_req_t *req) {
-  camera_fb_t *fb = NULL;
-  esp_err_t res = ESP_OK;
-  size_t _jpg_buf_len = 0;
-  uint8_t *_jpg_buf = NULL;
-
-  httpd_resp_set_hdr(req, "Access-Control-Allow-Origin", "*");
+  setCorsHeaders(req);
   httpd_resp_set_hdr(req, "Cache-Control", "no-cache, no-store, must-revalidate");
 
-  fb = esp_camera_fb_get();
-  if (!fb) {
+  frameHub_subscribe();
+  CameraFrame* frame = frameHub_acquire(0, pdMS_TO_TICKS(STREAM_FRAME_TIMEOUT_MS));
+  frameHub_unsubscribe();
+  if (!frame) {
     httpd_resp_send_500(req);
     return ESP_FAIL;
   }
 
-  if (fb->format != PIXFORMAT_JPEG) {
-    bool jpeg_converted = frame2jpg(fb, 80, &_jpg_buf, &_jpg_buf_len);
-    esp_camera_fb_return(fb);
-    if (!jpeg_converted) {
-      httpd_resp_send_500(req);
-      return ESP_FAIL;
-    }
-  } else {
-    _jpg_buf_len = fb->len;
-    _jpg_buf = fb->buf;
-  }
-
   httpd_resp_set_type(req, "image/jpeg");
   httpd_resp_set_hdr(req, "Content-Disposition", "inline; filename=frame.jpg");
-  res = httpd_resp_send(req, (const char *)_jpg_buf, _jpg_buf_len);
-
-  if (fb) {
-    esp_camera_fb_return(fb);
-  } else if (_jpg_buf) {
-    free(_jpg_buf);
-  }
-
+  esp_err_t res = httpd_resp_send(req, (const char *)frame->jpg, frame->len);
+  frameHub_release(frame);
   return res;
 }
 
 // ==================== OPTIONS HANDLER (CORS) ====================
 esp_err_t options_handler(httpd_req_t *req) {
-  httpd_resp_set_hdr(req, "Access-Control-Allow-Origin", "*");
-  httpd_resp_set_hdr(req, "Access-Control-Allow-Methods", "GET, OPTIONS");
-  httpd_resp_set_hdr(req, "Access-Control-Allow-Headers", "Content-Type");
+  setCorsHeaders(req);
+  httpd_resp_set_status(req, "204 No Content");
   httpd_resp_send(req, NULL, 0);
   return ESP_OK;
 }
 
-// ==================== START SERVER ====================
-void startCameraServer() {
-  httpd_config_t config = HTTPD_DEFAULT_CONFIG();
-  config.server_port = 80;
+// ==================== SETTINGS HANDLER ====================
+// GET /settings reports the sensor settings, POST /settings changes any of them:
+//   {"framesize":"vga","quality":12,"brightness":1,"contrast":0,"saturation":0,"vflip":false,"hmirror":false}
+// plus the stream controller: {"adaptive":true,"target_fps":10,"max_fps":0}
+// Setting framesize or quality by hand turns adaptive off unless the same body sets "adaptive":true.
+typedef struct {
+  framesize_t size;
+  const char* name;
+} FrameSizeName;
+
+static const FrameSizeName FRAME_SIZES[] = {
+  { FRAMESIZE_QQVGA, "qqvga" },   // 160x120
+  { FRAMESIZE_QVGA,  "qvga" },    // 320x240
+  { FRAMESIZE_CIF,   "cif" },     // 400x296
+  { FRAMESIZE_VGA,   "vga" },     // 640x480
+  { FRAMESIZE_SVGA,  "svga" },    // 800x600
+};
+
+const char* frameSizeName(framesize_t size) {
+  for (size_t i = 0; i < sizeof(FRAME_SIZES) / sizeof(FRAME_SIZES[0]); i++) {
+    if (FRAME_SIZES[i].size == size) return FRAME_SIZES[i].name;
+  }
+  return "other";
+}
 
-  // Stream endpoint
-  httpd_uri_t stream_uri = {
-    .uri       = "/stream",
-    .method    = HTTP_GET,
-    .handler   = stream_handler,
-    .user_ctx  = NULL
-  };
+// Minimal body parsing (same approach as the telemetry firmware - no JSON library)
+bool findJsonValue(const char* body, const char* key, const char** value) {
+  char pattern[24];
+  snprintf(pattern, sizeof(pattern), "\"%s\"", key);
+  const char* p = strstr(body, pattern);
+  if (!p) return false;
+  p = strchr(p + strlen(pattern), ':');
+  if (!p) return false;
+  p++;
+  while (*p == ' ') p++;
+  *value = p;
+  return true;
+}
 
-  // Still frame endpoint (single JPEG)
-  httpd_uri_t still_uri = {
-    .uri       = "/still",
-    .method    = HTTP_GET,
-    .handler   = still_handler,
-    .user_ctx  = NULL
-  };
+esp_err_t sendSettings(httpd_req_t *req) {
+  sensor_t *s = esp_camera_sensor_get();
+  if (!s) {
+    httpd_resp_send_500(req);
+    return ESP_FAIL;
+  }
+  char json[288];
+  snprintf(json, sizeof(json),
+    "{\"framesize\":\"%s\",\"quality\":%d,\"brightness\":%d,\"contrast\":%d,\"saturation\":%d,"
+    "\"vflip\":%s,\"hmirror\":%s,\"adaptive\":%s,\"target_fps\":%d,\"max_fps\":%d}",
+    frameSizeName(s->status.framesize),
+    s->status.quality,
+    s->status.brightness,
+    s->status.contrast,
+    s->status.saturation,
+    s->status.vflip ? "true" : "false",
+    s->status.hmirror ? "true" : "false",
+    streamAdaptive ? "true" : "false",
+    streamTargetFps,
+    streamMaxFps
+  );
+  httpd_resp_set_type(req, "application/json");
+  return httpd_resp_sendstr(req, json);
+}
 
-  // Status endpoint
-  httpd_uri_t status_uri = {
-    .uri       = "/status",
-    .method    = HTTP_GET,
-    .handler   = status_handler,
-    .user_ctx  = NULL
-  };
+esp_err_t sendBadRequest(httpd_req_t *req, const char* message) {
+  char json[96];
+  snprintf(json, sizeof(json), "{\"error\":\"%s\"}", message);
+  httpd_resp_set_status(req, "400 Bad Request");
+  httpd_resp_set_type(req, "application/json");
+  return httpd_resp_sendstr(req, json);
+}
+
+esp_err_t settings_get_handler(httpd_req_t *req) {
+  setCorsHeaders(req);
+  return sendSettings(req);
+}
+
+esp_err_t settings_post_handler(httpd_req_t *req) {
+  setCorsHeaders(req);
+
+  char body[256];
+  if (req->content_len == 0 || req->content_len >= sizeof(body)) {
+    return sendBadRequest(req, "Missing or oversized body");
+  }
+  size_t received = 0;
+  int timeouts = 0;
+  while (received < req->content_len) {
+    int n = httpd_req_recv(req, body + received, req->content_len - received);
+    if (n == HTTPD_SOCK_ERR_TIMEOUT && ++timeouts < 3) continue;  // Retry a slow client briefly
+    if (n <= 0) return ESP_FAIL;
+    received += n;
+  }
+  body[received] = '\0';
+
+  sensor_t *s = esp_camera_sensor_get();
+  if (!s) {
+    httpd_resp_send_500(req);
+    return ESP_FAIL;
+  }
+
+  const char* v;
+  bool adaptive = streamAdaptive;
+  if (findJsonValue(body, "target_fps", &v)) {
+    int fps = atoi(v);
+    if (fps < 1 || fps > 30) return sendBadRequest(req, "target_fps must be 1-30");
+    streamTargetFps = fps;
+  }
+  if (findJsonValue(body, "max_fps", &v)) {
+    int fps = atoi(v);
+    if (fps < 0 || fps > 30) return sendBadRequest(req, "max_fps must be 0-30");
+    streamMaxFps = fps;
+  }
+
+  xSemaphoreTake(sensorLock, portMAX_DELAY);
+  if (findJsonValue(body, "framesize", &v)) {
+    int found = -1;
+    for (size_t i = 0; i < sizeof(FRAME_SIZES) / sizeof(FRAME_SIZES[0]); i++) {
+      size_t len = strlen(FRAME_SIZES[i].name);
+      if (*v == '"' && strncmp(v + 1, FRAME_SIZES[i].name, len) == 0 && v[len + 1] == '"') {
+        found = i;
+      }
+    }
+    // Framebuffers are sized for CAMERA_MAX_FRAMESIZE at init
+    if (found < 0 || FRAME_SIZES[found].size > CAMERA_MAX_FRAMESIZE) {
+      xSemaphoreGive(sensorLock);
+      return sendBadRequest(req, "Unsupported framesize");
+    }
+    s->set_framesize(s, FRAME_SIZES[found].size);
+    adaptive = false;
+  }
+  if (findJsonValue(body, "quality", &v)) {
+    int quality = atoi(v);
+    if (quality < 4 || quality > 63) {
+      xSemaphoreGive(sensorLock);
+      return sendBadRequest(req, "quality must be 4-63");
+    }
+    s->set_quality(s, quality);
+    adaptive = false;
+  }
+  if (findJsonValue(body, "brightness", &v)) s->set_brightness(s, constrain(atoi(v), -2, 2));
+  if (findJsonValue(body, "contrast", &v)) s->set_contrast(s, constrain(atoi(v), -2, 2));
+  if (findJsonValue(body, "saturation", &v)) s->set_saturation(s, constrain(atoi(v), -2, 2));
+  if (findJsonValue(body, "vflip", &v)) s->set_vflip(s, strncmp(v, "true", 4) == 0);
+  if (findJsonValue(body, "hmirror", &v)) s->set_hmirror(s, strncmp(v, "true", 4) == 0);
+  xSemaphoreGive(sensorLock);
+
+  if (findJsonValue(body, "adaptive", &v)) adaptive = strncmp(v, "true", 4) == 0;
+  if (adaptive != streamAdaptive) {
+    streamAdaptive = adaptive;
+    Serial.printf("Adaptive stream quality %s\n", adaptive ? "on" : "off");
+    if (adaptive) applyStreamMode(streamModeLevel);  // Take back over from any manual setting
+  }
+
+  return sendSettings(req);
+}
+
+// ==================== OTA HANDLER ====================
+// POST /ota streams a plain, gzip or delta image into the next OTA partition
+// (scripts/ota_push.py). Runs on the control server: streaming continues, but /status and
+// the other control routes wait until it finishes. loop() reboots once the response is sent
+volatile uint32_t otaRestartAtMs = 0;    // 0 = no restart pending
 
-  // CORS preflight
-  httpd_uri_t options_uri = {
-    .uri       = "/stream",
-    .method    = HTTP_OPTIONS,
-    .handler   = options_handler,
+void onOtaProgress(uint32_t image_bytes, uint32_t body_bytes, uint32_t body_total) {
+  Serial.printf("OTA: %u%% (%lu bytes written)\r", (unsigned)((uint64_t)body_bytes * 100 / body_total),
+                (unsigned long)image_bytes);
+}
+
+esp_err_t ota_handler(httpd_req_t *req) {
+  setCorsHeaders(req);
+  char password[32];
+  if (httpd_req_get_hdr_value_str(req, OTA_PASSWORD_HEADER, password, sizeof(password)) != ESP_OK ||
+      strcmp(password, OTA_PASSWORD) != 0) {
+    httpd_resp_set_status(req, "401 Unauthorized");
+    httpd_resp_set_type(req, "application/json");
+    return httpd_resp_sendstr(req, "{\"error\":\"Missing or wrong X-OTA-Password\"}");
+  }
+
+  Serial.printf("OTA: receiving %u bytes\n", (unsigned)req->content_len);
+  OtaStreamResult result;
+  bool ok = otaStream_receive(req, onOtaProgress, NULL, &result);
+  if (ok) {
+    Serial.printf("\nOTA: complete, %lu bytes (%lu copied from running) from %lu received in %lu ms\n",
+                  (unsigned long)result.image_size, (unsigned long)result.copied,
+                  (unsigned long)result.received, (unsigned long)result.duration_ms);
+    otaRestartAtMs = (millis() + OTA_RESTART_DELAY_MS) | 1;
+  } else {
+    Serial.printf("\nOTA: failed: %s\n", result.error);
+  }
+
+  char json[320];
+  snprintf(json, sizeof(json),
+    "{\"ok\":%s,\"error\":\"%s\",\"gzip\":%s,\"delta\":%s,\"received\":%lu,"
+    "\"image_size\":%lu,\"copied\":%lu,\"duration_ms\":%lu,\"restarting\":%s}",
+    ok ? "true" : "false",
+    ok ? "" : result.error,
+    (result.format & OTA_FORMAT_GZIP) ? "true" : "false",
+    (result.format & OTA_FORMAT_DELTA) ? "true" : "false",
+    (unsigned long)result.received,
+    (unsigned long)result.image_size,
+    (unsigned long)result.copied,
+    (unsigned long)result.duration_ms,
+    ok ? "true" : "false"
+  );
+  if (!ok) httpd_resp_set_status(req, "400 Bad Request");
+  httpd_resp_set_type(req, "application/json");
+  return httpd_resp_sendstr(req, json);
+}
+
+// ==================== ADAPTIVE STREAM QUALITY ====================
+// Each sender measures how long one frame takes to push into its socket. The slowest
+// viewer's send time gives the frame rate the link can carry at the current mode; the
+// controller steps down when that (or the capture rate) falls short of the target and
+// steps up only after a long stretch of headroom, with a hold time after every change
+// so one mode switch settles before the next decision.
+
+// Slowest active viewer (lowest delivered fps, longest send and its frame size). False if nobody is streaming
+bool worstStreamSlot(float* fps, float* send_ms, float* frame_bytes) {
+  bool any = false;
+  *fps = 0.0f;
+  *send_ms = 0.0f;
+  *frame_bytes = 0.0f;
+  for (int i = 0; i < STREAM_MAX_CLIENTS; i++) {
+    StreamSlot* slot = &streamSlots[i];
+    if (!slot->active || slot->frames_sent < 2) continue;
+    if (!any || slot->fps_avg < *fps) *fps = slot->fps_avg;
+    if (slot->send_ms_avg > *send_ms) {
+      *send_ms = slot->send_ms_avg;
+      *frame_bytes = slot->bytes_avg;
+    }
+    any = true;
+  }
+  return any;
+}
+
+void applyStreamMode(int level) {
+  sensor_t *s = esp_camera_sensor_get();
+  if (!s) return;
+  level = constrain(level, 0, STREAM_MODE_COUNT - 1);
+  const StreamMode* mode = &STREAM_MODES[level];
+  if (mode->size > CAMERA_MAX_FRAMESIZE) return;  // Framebuffers are sized at init
+
+  xSemaphoreTake(sensorLock, portMAX_DELAY);
+  if (s->status.framesize != mode->size) s->set_framesize(s, mode->size);
+  if (s->status.quality != mode->quality) s->set_quality(s, mode->quality);
+  xSemaphoreGive(sensorLock);
+
+  streamModeLevel = level;
+  Serial.printf("Stream mode %d: %s q%d\n", level, frameSizeName(mode->size), mode->quality);
+}
+
+// Called from loop() every ADAPT_INTERVAL_MS
+void adaptStreamQuality() {
+  static uint32_t lastFrames = 0;
+  static uint32_t lastRun = 0;
+  static uint32_t lastChange = 0;
+  static uint32_t lowSince = 0;
+  static uint32_t highSince = 0;
+  static float captureFps = 0.0f;
+
+  uint32_t now = millis();
+  uint32_t frames = frameHub_framesCaptured();
+  if (lastRun) {
+    float fps = (frames - lastFrames) * 1000.0f / (now - lastRun);
+    captureFps += 0.3f * (fps - captureFps);
+  }
+  lastFrames = frames;
+  lastRun = now;
+
+  float worst_fps, worst_send_ms, worst_bytes;
+  if (!streamAdaptive || !worstStreamSlot(&worst_fps, &worst_send_ms, &worst_bytes) || now - lastChange < ADAPT_HOLD_MS) {
+    lowSince = 0;
+    highSince = 0;
+    return;
+  }
+
+  // What this mode can carry: the link (from send time) or the sensor, whichever is lower
+  float capacity = 1000.0f / (worst_send_ms > 1.0f ? worst_send_ms : 1.0f);
+  if (captureFps < capacity) capacity = captureFps;
+
+  // A max_fps cap below the target is the goal to hold, not a shortfall
+  float target = streamTargetFps;
+  if (streamMaxFps > 0 && streamMaxFps < target) target = streamMaxFps;
+
+  if (capacity < target * ADAPT_DOWN_RATIO && streamModeLevel > 0) {
+    highSince = 0;
+    if (!lowSince) lowSince = now;
+    if (now - lowSince >= ADAPT_DOWN_MS) {
+      Serial.printf("Stream capacity %.1f fps < target %.0f (send %.0f ms) - stepping down\n",
+                    capacity, target, worst_send_ms);
+      applyStreamMode(streamModeLevel - 1);
+      lastChange = now;
+      lowSince = 0;
+    }
+  } else if (capacity > target * ADAPT_UP_RATIO && streamModeLevel < STREAM_MODE_COUNT - 1 &&
+             STREAM_MODES[streamModeLevel + 1].size <= CAMERA_MAX_FRAMESIZE) {
+    lowSince = 0;
+    if (!highSince) highSince = now;
+    if (now - highSince >= ADAPT_UP_MS) {
+      applyStreamMode(streamModeLevel + 1);
+      lastChange = now;
+      highSince = 0;
+    }
+  } else {
+    lowSince = 0;
+    highSince = 0;
+  }
+}
+
+// ==================== START SERVERS ====================
+void registerRoute(httpd_handle_t server, const char* uri, httpd_method_t method,
+                   esp_err_t (*handler)(httpd_req_t *req)) {
+  httpd_uri_t route = {
+    .uri       = uri,
+    .method    = method,
+    .handler   = handler,
     .user_ctx  = NULL
   };
+  httpd_register_uri_handler(server, &route);
+}
 
-  Serial.println("Starting camera server...");
-  if (httpd_start(&stream_httpd, &config) == ESP_OK) {
-    httpd_register_uri_handler(stream_httpd, &stream_uri);
-    httpd_register_uri_handler(stream_httpd, &still_uri);
-    httpd_register_uri_handler(stream_httpd, &status_uri);
-    httpd_register_uri_handler(stream_httpd, &options_uri);
-    Serial.println("Camera server started on port 80");
-    Serial.println("  /stream  - MJPEG stream");
-    Serial.println("  /still   - Single JPEG frame");
-    Serial.println("  /status  - JSON status");
+void startCameraServer() {
+  // Control server: short requests only
+  httpd_config_t config = HTTPD_DEFAULT_CONFIG();
+  config.server_port = CONTROL_HTTP_PORT;
+  config.max_uri_handlers = 12;
+  config.lru_purge_enable = true;
+  config.stack_size = 6144;   // OTA receive and the JSON handlers
+
+  Serial.println("Starting camera servers...");
+  if (httpd_start(&control_httpd, &config) == ESP_OK) {
+    registerRoute(control_httpd, "/status", HTTP_GET, status_handler);
+    registerRoute(control_httpd, "/still", HTTP_GET, still_handler);
+    registerRoute(control_httpd, "/settings", HTTP_GET, settings_get_handler);
+    registerRoute(control_httpd, "/settings", HTTP_POST, settings_post_handler);
+    registerRoute(control_httpd, "/stream", HTTP_GET, stream_redirect_handler);
+    registerRoute(control_httpd, "/ota", HTTP_POST, ota_handler);
+    registerRoute(control_httpd, "/status", HTTP_OPTIONS, options_handler);
+    registerRoute(control_httpd, "/still", HTTP_OPTIONS, options_handler);
+    registerRoute(control_httpd, "/settings", HTTP_OPTIONS, options_handler);
+    registerRoute(control_httpd, "/stream", HTTP_OPTIONS, options_handler);
+    registerRoute(control_httpd, "/ota", HTTP_OPTIONS, options_handler);
+    Serial.printf("Control server started on port %d\n", CONTROL_HTTP_PORT);
+    Serial.println("  /status   - JSON status");
+    Serial.println("  /still    - Single JPEG frame");
+    Serial.println("  /settings - Camera settings (GET/POST)");
+    Serial.println("  /ota      - Firmware update (POST image, .gz or delta)");
+  } else {
+    Serial.println("Control server failed to start");
+  }
+
+  // Stream server: second instance, so it needs its own port and control socket
+  httpd_config_t stream_config = HTTPD_DEFAULT_CONFIG();
+  stream_config.server_port = STREAM_HTTP_PORT;
+  stream_config.ctrl_port = config.ctrl_port + 1;
+  stream_config.max_open_sockets = STREAM_MAX_CLIENTS + 1;  // One spare to answer 503/OPTIONS
+  stream_config.max_uri_handlers = 4;
+  stream_config.lru_purge_enable = false;  // Idle-looking stream sockets must not be reclaimed
+
+  if (httpd_start(&stream_httpd, &stream_config) == ESP_OK) {
+    registerRoute(stream_httpd, "/stream", HTTP_GET, stream_handler);
+    registerRoute(stream_httpd, "/stream", HTTP_OPTIONS, options_handler);
+    Serial.printf("Stream server started on port %d (max %d clients)\n", STREAM_HTTP_PORT, STREAM_MAX_CLIENTS);
+    Serial.println("  /stream   - MJPEG stream");
+  } else {
+    Serial.println("Stream server failed to start");
   }
 }
 
@@ -316,10 +850,11 @@ void setup() {
   config.pixel_format = PIXFORMAT_JPEG;
   config.grab_mode = CAMERA_GRAB_LATEST;
 
-  // Optimized for streaming stability
-  config.frame_size = FRAMESIZE_QVGA;  // 320x240
+  // Optimized for streaming stability (buffers sized for the largest /settings framesize,
+  // the sensor is switched down to QVGA below)
+  config.frame_size = CAMERA_MAX_FRAMESIZE;
   config.jpeg_quality = 20;             // Higher = more compression
-  config.fb_count = 2;
+  config.fb_count = CAMERA_FB_COUNT;
   config.fb_location = CAMERA_FB_IN_PSRAM;
 
   // Init camera with retry logic
@@ -353,34 +888,48 @@ void setup() {
   Serial.println("Frame capture verified - camera fully operational");
 
   // Apply additional sensor settings
+  sensorLock = xSemaphoreCreateMutex();
   sensor_t *s = esp_camera_sensor_get();
   if (s) {
-    s->set_framesize(s, FRAMESIZE_QVGA);
-    s->set_quality(s, 20);
+    s->set_framesize(s, STREAM_MODES[STREAM_MODE_DEFAULT].size);
+    s->set_quality(s, STREAM_MODES[STREAM_MODE_DEFAULT].quality);
     s->set_brightness(s, 0);
     s->set_contrast(s, 0);
     s->set_saturation(s, 0);
   }
 
-  // Connect WiFi
-  connectWiFi();
+  // Connect WiFi (cached AP first; the link task keeps reconnecting on its own)
+  wifiLink_start(WIFI_NETWORKS, sizeof(WIFI_NETWORKS) / sizeof(WIFI_NETWORKS[0]), onWiFiConnected);
+  if (!wifiLink_waitConnected(20000)) {
+    Serial.println("WiFi not connected yet - starting servers anyway");
+  }
 
-  // Start server
+  // Start the shared capture task and one sender per stream slot, then the servers
+  if (!frameHub_start()) {
+    Serial.println("Frame hub failed to start. Rebooting...");
+    delay(1000);
+    ESP.restart();
+  }
+  setupStreamSenders();
   startCameraServer();
+  discovery_start(&DISCOVERY_INFO);
 
   Serial.println("=== Camera Ready ===");
 }
 
 // ==================== LOOP ====================
 void loop() {
-  // Reconnect WiFi if disconnected
-  static unsigned long lastCheck = 0;
-  if (millis() - lastCheck > 30000) {
-    lastCheck = millis();
-    if (WiFi.status() != WL_CONNECTED) {
-      Serial.println("WiFi lost, reconnecting...");
-      connectWiFi();
-    }
+  // WiFi reconnects are handled by the WiFi link task
+  if (otaRestartAtMs != 0 && (int32_t)(millis() - otaRestartAtMs) >= 0) {
+    Serial.println("Restarting into the new firmware...");
+    ESP.restart();
+  }
+
+  // Match framesize/quality to what the viewers' links can carry
+  static unsigned long lastAdapt = 0;
+  if (millis() - lastAdapt >= ADAPT_INTERVAL_MS) {
+    lastAdapt = millis();
+    adaptStreamQuality();
   }
   delay(10);
 }
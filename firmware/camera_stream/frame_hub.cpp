@@ -0,0 +1,179 @@
+// frame_hub.cpp
+// Capture task + refcounted frame fan-out
+
+#include "frame_hub.h"
+#include <Arduino.h>
+#include "img_converters.h"
+#include "freertos/event_groups.h"
+
+#define FRAME_READY_BIT  0x01
+
+// Record state: refs > 0 in use, 0 free, -1 reserved (being filled or freed)
+static CameraFrame frames[FRAME_HUB_MAX_FRAMES];
+static CameraFrame* latest = NULL;      // Newest frame (the hub holds one reference)
+static uint32_t captureSeq = 0;
+static uint32_t captureFailures = 0;
+static int subscribers = 0;
+static portMUX_TYPE hubMux = portMUX_INITIALIZER_UNLOCKED;
+static EventGroupHandle_t frameEvents = NULL;
+
+// Give the framebuffer back once nobody uses the frame (caller holds no lock)
+static void freeFrame(CameraFrame* frame) {
+  if (frame->fb) {
+    esp_camera_fb_return(frame->fb);
+  } else if (frame->converted) {
+    free(frame->converted);
+  }
+  portENTER_CRITICAL(&hubMux);
+  frame->fb = NULL;
+  frame->converted = NULL;
+  frame->jpg = NULL;
+  frame->refs = 0;              // Record is free again
+  portEXIT_CRITICAL(&hubMux);
+}
+
+void frameHub_release(CameraFrame* frame) {
+  if (!frame) return;
+  bool last;
+  portENTER_CRITICAL(&hubMux);
+  last = --frame->refs == 0;
+  if (last) frame->refs = -1;   // Being freed: not available for reuse yet
+  portEXIT_CRITICAL(&hubMux);
+  if (last) freeFrame(frame);
+}
+
+// Capture task only
+static CameraFrame* allocFrame() {
+  CameraFrame* slot = NULL;
+  portENTER_CRITICAL(&hubMux);
+  for (int i = 0; i < FRAME_HUB_MAX_FRAMES && !slot; i++) {
+    if (frames[i].refs == 0) slot = &frames[i];
+  }
+  if (slot) slot->refs = -1;    // Reserved until published
+  portEXIT_CRITICAL(&hubMux);
+  return slot;
+}
+
+static void captureTask(void* param) {
+  Serial.printf("Frame hub capture task started on core %d\n", xPortGetCoreID());
+  while (true) {
+    portENTER_CRITICAL(&hubMux);
+    bool wanted = subscribers > 0;
+    CameraFrame* idle = wanted ? NULL : latest;
+    if (!wanted) latest = NULL;
+    portEXIT_CRITICAL(&hubMux);
+
+    if (!wanted) {
+      // Nobody watching: drop our reference so the driver gets its buffer back
+      frameHub_release(idle);
+      vTaskDelay(pdMS_TO_TICKS(50));
+      continue;
+    }
+
+    camera_fb_t* fb = esp_camera_fb_get();
+    if (!fb) {
+      captureFailures++;
+      Serial.println("Camera capture failed");
+      vTaskDelay(pdMS_TO_TICKS(10));
+      continue;
+    }
+
+    CameraFrame* frame = allocFrame();
+    if (!frame) {
+      // Consumers hold every record - skip this frame
+      esp_camera_fb_return(fb);
+      vTaskDelay(pdMS_TO_TICKS(5));
+      continue;
+    }
+
+    frame->timestamp_us = (int64_t)fb->timestamp.tv_sec * 1000000LL + fb->timestamp.tv_usec;
+    if (fb->format == PIXFORMAT_JPEG) {
+      frame->fb = fb;
+      frame->converted = NULL;
+      frame->jpg = fb->buf;
+      frame->len = fb->len;
+    } else {
+      uint8_t* jpg = NULL;
+      size_t len = 0;
+      bool ok = frame2jpg(fb, FRAME_HUB_JPEG_QUALITY, &jpg, &len);
+      esp_camera_fb_return(fb);
+      if (!ok) {
+        Serial.println("JPEG compression failed");
+        captureFailures++;
+        portENTER_CRITICAL(&hubMux);
+        frame->refs = 0;
+        portEXIT_CRITICAL(&hubMux);
+        continue;
+      }
+      frame->fb = NULL;
+      frame->converted = jpg;
+      frame->jpg = jpg;
+      frame->len = len;
+    }
+
+    portENTER_CRITICAL(&hubMux);
+    CameraFrame* previous = latest;
+    frame->seq = ++captureSeq;
+    frame->refs = 1;            // The hub's reference (dropped when replaced)
+    latest = frame;
+    portEXIT_CRITICAL(&hubMux);
+    frameHub_release(previous);
+
+    // Wake every waiting consumer (waiters are unblocked by the set)
+    xEventGroupSetBits(frameEvents, FRAME_READY_BIT);
+    xEventGroupClearBits(frameEvents, FRAME_READY_BIT);
+  }
+}
+
+bool frameHub_start() {
+  memset(frames, 0, sizeof(frames));
+  frameEvents = xEventGroupCreate();
+  if (frameEvents == NULL) {
+    Serial.println("Frame hub: event group allocation failed");
+    return false;
+  }
+  if (xTaskCreatePinnedToCore(captureTask, "FrameHub", 4096, NULL,
+                              FRAME_HUB_PRIORITY, NULL, FRAME_HUB_CORE) != pdPASS) {
+    Serial.println("Frame hub: capture task creation failed");
+    return false;
+  }
+  return true;
+}
+
+void frameHub_subscribe() {
+  portENTER_CRITICAL(&hubMux);
+  subscribers++;
+  portEXIT_CRITICAL(&hubMux);
+}
+
+void frameHub_unsubscribe() {
+  portENTER_CRITICAL(&hubMux);
+  if (subscribers > 0) subscribers--;
+  portEXIT_CRITICAL(&hubMux);
+}
+
+CameraFrame* frameHub_acquire(uint32_t after_seq, TickType_t timeout) {
+  TickType_t start = xTaskGetTickCount();
+  while (true) {
+    CameraFrame* frame = NULL;
+    portENTER_CRITICAL(&hubMux);
+    if (latest && latest->seq > after_seq) {
+      frame = latest;
+      frame->refs++;
+    }
+    portEXIT_CRITICAL(&hubMux);
+    if (frame) return frame;
+
+    TickType_t waited = xTaskGetTickCount() - start;
+    if (waited >= timeout) return NULL;
+    xEventGroupWaitBits(frameEvents, FRAME_READY_BIT, pdFALSE, pdFALSE, timeout - waited);
+  }
+}
+
+uint32_t frameHub_framesCaptured() {
+  return captureSeq;
+}
+
+uint32_t frameHub_captureFailures() {
+  return captureFailures;
+}
@@ -0,0 +1,47 @@
+// frame_hub.h
+// Single camera capture task shared by every consumer (MJPEG viewers, /still)
+// Each frame is grabbed once and handed out by reference: consumers acquire the
+// newest frame, send it, and release it. The driver framebuffer goes back to the
+// camera when the last reference is dropped. A consumer that is still sending
+// when newer frames arrive simply gets the newest one next (frames are skipped,
+// nobody waits for the slowest viewer).
+
+#ifndef FRAME_HUB_H
+#define FRAME_HUB_H
+
+#include <stdint.h>
+#include <cstddef>
+#include "esp_camera.h"
+
+#define FRAME_HUB_MAX_FRAMES    8       // Frame records (>= fb_count + frames held by consumers)
+#define FRAME_HUB_CORE          1       // Off the WiFi core
+#define FRAME_HUB_PRIORITY      5
+#define FRAME_HUB_JPEG_QUALITY  80      // Only used if the sensor delivers raw frames
+
+typedef struct {
+  const uint8_t* jpg;       // JPEG data (driver framebuffer or converted copy)
+  size_t len;
+  uint32_t seq;             // Capture sequence number (1, 2, ...)
+  int64_t timestamp_us;     // Driver capture time (fb->timestamp)
+  // Hub internals
+  camera_fb_t* fb;          // Held driver framebuffer (NULL if converted)
+  uint8_t* converted;       // frame2jpg output (freed on release)
+  int refs;
+} CameraFrame;
+
+// Start the capture task (after esp_camera_init)
+bool frameHub_start();
+
+// Capture only runs while someone is subscribed (no framebuffers held when idle)
+void frameHub_subscribe();
+void frameHub_unsubscribe();
+
+// Newest frame with seq > after_seq, waiting up to timeout. Returns NULL on timeout.
+// Every returned frame must be passed to frameHub_release()
+CameraFrame* frameHub_acquire(uint32_t after_seq, TickType_t timeout);
+void frameHub_release(CameraFrame* frame);
+
+uint32_t frameHub_framesCaptured();
+uint32_t frameHub_captureFailures();
+
+#endif // FRAME_HUB_H
@@ -0,0 +1,86 @@
+// discovery.cpp
+// mDNS service records + UDP discovery beacon responder
+
+#include "discovery.h"
+#include <Arduino.h>
+#include <WiFi.h>
+#include <ESPmDNS.h>
+#include "lwip/sockets.h"
+
+static const DiscoveryInfo* info = NULL;
+static volatile uint32_t probesAnswered = 0;
+
+static void registerMdns() {
+  // ArduinoOTA may have started mDNS with the same hostname already - begin() is then a no-op
+  if (!MDNS.begin(info->hostname)) {
+    Serial.println("✗ mDNS failed to start");
+    return;
+  }
+  char port[8];
+  snprintf(port, sizeof(port), "%u", info->stream_port);
+
+  MDNS.addService(DISCOVERY_SERVICE, "tcp", info->http_port);
+  MDNS.addServiceTxt(DISCOVERY_SERVICE, "tcp", "type", info->type);
+  MDNS.addServiceTxt(DISCOVERY_SERVICE, "tcp", "name", info->name);
+  MDNS.addServiceTxt(DISCOVERY_SERVICE, "tcp", "version", info->version);
+  MDNS.addServiceTxt(DISCOVERY_SERVICE, "tcp", "build", info->build);
+  if (info->stream_port) MDNS.addServiceTxt(DISCOVERY_SERVICE, "tcp", "stream_port", port);
+  MDNS.addService("http", "tcp", info->http_port);
+
+  Serial.printf("✓ mDNS: %s.local (_%s._tcp, type=%s)\n", info->hostname, DISCOVERY_SERVICE, info->type);
+}
+
+static void beaconTask(void* param) {
+  int sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+  if (sock < 0) {
+    Serial.println("✗ Discovery beacon: socket failed");
+    vTaskDelete(NULL);
+  }
+  struct sockaddr_in addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(DISCOVERY_UDP_PORT);
+  addr.sin_addr.s_addr = htonl(INADDR_ANY);
+  if (bind(sock, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
+    Serial.println("✗ Discovery beacon: bind failed");
+    close(sock);
+    vTaskDelete(NULL);
+  }
+
+  char probe[32];
+  char reply[320];
+  while (true) {
+    struct sockaddr_in from;
+    socklen_t fromLen = sizeof(from);
+    int n = recvfrom(sock, probe, sizeof(probe) - 1, 0, (struct sockaddr*)&from, &fromLen);
+    if (n <= 0) continue;
+    probe[n] = '\0';
+    if (strncmp(probe, DISCOVERY_PROBE, strlen(DISCOVERY_PROBE)) != 0) continue;  // Not for us
+
+    int len = snprintf(reply, sizeof(reply),
+      "{\"type\":\"%s\",\"name\":\"%s\",\"version\":\"%s\",\"build\":\"%s\",\"hostname\":\"%s\","
+      "\"ip\":\"%s\",\"port\":%u,\"stream_port\":%u}",
+      info->type, info->name, info->version, info->build, info->hostname,
+      WiFi.localIP().toString().c_str(), info->http_port, info->stream_port);
+    if (len > 0 && len < (int)sizeof(reply)) {
+      sendto(sock, reply, len, 0, (struct sockaddr*)&from, fromLen);
+      probesAnswered++;
+    }
+  }
+}
+
+bool discovery_start(const DiscoveryInfo* discoveryInfo) {
+  info = discoveryInfo;
+  registerMdns();
+  if (xTaskCreatePinnedToCore(beaconTask, "Discovery", 3072, NULL,
+                              DISCOVERY_TASK_PRIORITY, NULL, DISCOVERY_TASK_CORE) != pdPASS) {
+    Serial.println("✗ Discovery beacon task creation failed");
+    return false;
+  }
+  Serial.printf("Discovery beacon listening on UDP %d\n", DISCOVERY_UDP_PORT);
+  return true;
+}
+
+uint32_t discovery_probesAnswered() {
+  return probesAnswered;
+}
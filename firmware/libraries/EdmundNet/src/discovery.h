@@ -0,0 +1,40 @@
+// discovery.h
+// LAN discovery for the app: mDNS records plus a UDP beacon responder
+// mDNS: <hostname>.local, an _edmund._tcp service (TXT: type, name, version, build,
+// stream_port) and _http._tcp. Beacon: a datagram starting with DISCOVERY_PROBE sent
+// to DISCOVERY_UDP_PORT (broadcast or unicast) is answered to the sender with one
+// JSON line, e.g.
+//   {"type":"camera","name":"Edmund Fitzgerald Camera","version":"1.0.0","build":"...",
+//    "hostname":"edmund-camera","ip":"172.20.10.3","port":80,"stream_port":81}
+// The responder task blocks in recvfrom, so it costs nothing until someone asks.
+// Used by boat_telemetry and camera_stream (firmware/libraries/EdmundNet).
+
+#ifndef DISCOVERY_H
+#define DISCOVERY_H
+
+#include <stdint.h>
+
+#define DISCOVERY_UDP_PORT       4210
+#define DISCOVERY_PROBE          "EDMUND_DISCOVER"
+#define DISCOVERY_SERVICE        "edmund"     // _edmund._tcp
+#define DISCOVERY_TASK_CORE      0
+#define DISCOVERY_TASK_PRIORITY  1
+
+typedef struct {
+  const char* hostname;       // mDNS host (no ".local")
+  const char* type;           // "telemetry" / "camera" (same as the app's device types)
+  const char* name;
+  const char* version;
+  const char* build;
+  uint16_t http_port;
+  uint16_t stream_port;       // 0 = none
+} DiscoveryInfo;
+
+// Register the mDNS records and start the beacon task. info must stay valid.
+// Safe to call before WiFi has an IP (both come up with the interface)
+bool discovery_start(const DiscoveryInfo* info);
+
+// Beacon probes answered since boot
+uint32_t discovery_probesAnswered();
+
+#endif // DISCOVERY_H
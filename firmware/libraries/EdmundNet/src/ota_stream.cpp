@@ -0,0 +1,322 @@
+// ota_stream.cpp
+// Request body -> [gzip inflate] -> image / delta decode -> esp_ota_write
+
+#include "ota_stream.h"
+#include <Arduino.h>
+#include <string.h>
+#include "esp_ota_ops.h"
+#include "esp_app_desc.h"
+#include "esp_partition.h"
+#include "rom/miniz.h"            // tinfl in the ESP32 ROM
+
+#define OTA_DICT_SIZE       TINFL_LZ_DICT_SIZE  // 32 KB inflate window (doubles as the output ring)
+#define OTA_COPY_CHUNK      1024                // Running-partition read size for delta COPY
+#define OTA_DELTA_HEADER    44                  // Magic, version, reserved[3], ELF SHA-256, target size
+#define OTA_IMAGE_MAGIC     0xE9                // esp_image_header_t.magic
+#define OTA_RECV_RETRIES    5                   // Socket timeouts tolerated in a row
+
+// gzip member header flags (RFC 1952)
+#define GZIP_FHCRC          0x02
+#define GZIP_FEXTRA         0x04
+#define GZIP_FNAME          0x08
+#define GZIP_FCOMMENT       0x10
+
+typedef enum {
+  STAGE_DETECT = 0,         // Collecting the first 4 decoded bytes
+  STAGE_IMAGE,              // Plain image: everything goes to flash
+  STAGE_DELTA_HEADER,
+  STAGE_DELTA_OP,
+  STAGE_DELTA_ARGS,
+  STAGE_DELTA_INSERT,
+  STAGE_DELTA_DONE
+} OtaStage;
+
+typedef struct {
+  OtaStreamResult* result;
+  const char* error;
+
+  // Output
+  const esp_partition_t* source;    // Running app (delta COPY source)
+  esp_ota_handle_t handle;
+  bool begun;
+  uint8_t* copy_buf;
+
+  // gzip
+  tinfl_decompressor* inflator;
+  uint8_t* dict;
+  size_t dict_ofs;
+  bool inflate_done;
+
+  // Decoded stream
+  OtaStage stage;
+  uint8_t hold[OTA_DELTA_HEADER];   // Detect bytes, delta header or op arguments
+  size_t hold_len;
+  size_t hold_need;
+  uint8_t op;
+  uint32_t insert_left;
+  uint32_t target_size;
+} OtaStream;
+
+static bool fail(OtaStream* s, const char* error) {
+  if (s->error == NULL) s->error = error;
+  return false;
+}
+
+static uint32_t readLe32(const uint8_t* p) {
+  return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static bool writeImage(OtaStream* s, const uint8_t* data, size_t len) {
+  if (len == 0) return true;
+  if (esp_ota_write(s->handle, data, len) != ESP_OK) return fail(s, "Flash write failed (image too large?)");
+  s->result->image_size += len;
+  return true;
+}
+
+static bool copyFromRunning(OtaStream* s, uint32_t offset, uint32_t len) {
+  if (offset > s->source->size || len > s->source->size - offset) {
+    return fail(s, "Delta copy outside the running partition");
+  }
+  while (len > 0) {
+    uint32_t n = len < OTA_COPY_CHUNK ? len : OTA_COPY_CHUNK;
+    if (esp_partition_read(s->source, offset, s->copy_buf, n) != ESP_OK) {
+      return fail(s, "Running partition read failed");
+    }
+    if (!writeImage(s, s->copy_buf, n)) return false;
+    s->result->copied += n;
+    offset += n;
+    len -= n;
+  }
+  return true;
+}
+
+static bool checkDeltaHeader(OtaStream* s) {
+  if (s->hold[4] != OTA_DELTA_VERSION) return fail(s, "Unsupported delta version");
+  const esp_app_desc_t* running = esp_app_get_description();
+  if (memcmp(s->hold + 8, running->app_elf_sha256, sizeof(running->app_elf_sha256)) != 0) {
+    return fail(s, "Delta was made against a different running image");
+  }
+  s->target_size = readLe32(s->hold + 40);
+  return true;
+}
+
+// Op arguments are complete in hold
+static bool runDeltaOp(OtaStream* s) {
+  if (s->op == OTA_DELTA_OP_COPY) {
+    s->stage = STAGE_DELTA_OP;
+    return copyFromRunning(s, readLe32(s->hold), readLe32(s->hold + 4));
+  }
+  s->insert_left = readLe32(s->hold);
+  s->stage = s->insert_left ? STAGE_DELTA_INSERT : STAGE_DELTA_OP;
+  return true;
+}
+
+// Decoded bytes (after inflate, if the body is gzip)
+static bool consume(OtaStream* s, const uint8_t* data, size_t len) {
+  while (len > 0) {
+    switch (s->stage) {
+      case STAGE_DETECT: {
+        size_t n = 4 - s->hold_len < len ? 4 - s->hold_len : len;
+        memcpy(s->hold + s->hold_len, data, n);
+        s->hold_len += n;
+        data += n;
+        len -= n;
+        if (s->hold_len < 4) break;
+        if (memcmp(s->hold, OTA_DELTA_MAGIC, 4) == 0) {
+          s->result->format |= OTA_FORMAT_DELTA;
+          s->stage = STAGE_DELTA_HEADER;      // Keep collecting the header behind the magic
+          s->hold_need = OTA_DELTA_HEADER;
+        } else if (s->hold[0] == OTA_IMAGE_MAGIC) {
+          s->stage = STAGE_IMAGE;
+          if (!writeImage(s, s->hold, s->hold_len)) return false;
+          s->hold_len = 0;
+        } else {
+          return fail(s, "Not an app image, gzip or delta");
+        }
+        break;
+      }
+
+      case STAGE_IMAGE:
+        return writeImage(s, data, len);
+
+      case STAGE_DELTA_HEADER:
+      case STAGE_DELTA_ARGS: {
+        size_t n = s->hold_need - s->hold_len < len ? s->hold_need - s->hold_len : len;
+        memcpy(s->hold + s->hold_len, data, n);
+        s->hold_len += n;
+        data += n;
+        len -= n;
+        if (s->hold_len < s->hold_need) break;
+        s->hold_len = 0;
+        if (s->stage == STAGE_DELTA_HEADER) {
+          if (!checkDeltaHeader(s)) return false;
+          s->stage = STAGE_DELTA_OP;
+        } else if (!runDeltaOp(s)) {
+          return false;
+        }
+        break;
+      }
+
+      case STAGE_DELTA_OP:
+        s->op = *data++;
+        len--;
+        if (s->op == OTA_DELTA_OP_END) {
+          s->stage = STAGE_DELTA_DONE;
+        } else if (s->op == OTA_DELTA_OP_COPY || s->op == OTA_DELTA_OP_INSERT) {
+          s->stage = STAGE_DELTA_ARGS;
+          s->hold_need = s->op == OTA_DELTA_OP_COPY ? 8 : 4;
+        } else {
+          return fail(s, "Unknown delta op");
+        }
+        break;
+
+      case STAGE_DELTA_INSERT: {
+        size_t n = s->insert_left < len ? s->insert_left : len;
+        if (!writeImage(s, data, n)) return false;
+        s->insert_left -= n;
+        data += n;
+        len -= n;
+        if (s->insert_left == 0) s->stage = STAGE_DELTA_OP;
+        break;
+      }
+
+      case STAGE_DELTA_DONE:
+        return fail(s, "Data after the end of the delta");
+    }
+  }
+  return true;
+}
+
+// Length of the gzip member header at the start of buf (0 = not gzip/deflate or incomplete)
+static size_t gzipHeaderLength(const uint8_t* buf, size_t len) {
+  if (len < 10 || buf[0] != 0x1f || buf[1] != 0x8b || buf[2] != 8) return 0;
+  uint8_t flags = buf[3];
+  size_t pos = 10;
+  if (flags & GZIP_FEXTRA) {
+    if (pos + 2 > len) return 0;
+    pos += 2 + (buf[pos] | (buf[pos + 1] << 8));
+  }
+  if (flags & GZIP_FNAME) {
+    while (pos < len && buf[pos] != 0) pos++;
+    pos++;
+  }
+  if (flags & GZIP_FCOMMENT) {
+    while (pos < len && buf[pos] != 0) pos++;
+    pos++;
+  }
+  if (flags & GZIP_FHCRC) pos += 2;
+  return pos <= len ? pos : 0;
+}
+
+// Feed compressed bytes; output is passed on every time the 32 KB ring fills or input runs out.
+// The gzip trailer (CRC-32, size) is not checked: esp_ota_end() verifies the image itself
+static bool inflateInput(OtaStream* s, const uint8_t* data, size_t len, bool last) {
+  while (!s->inflate_done) {
+    size_t in_bytes = len;
+    size_t out_bytes = OTA_DICT_SIZE - s->dict_ofs;
+    tinfl_status status = tinfl_decompress(s->inflator, data, &in_bytes, s->dict, s->dict + s->dict_ofs,
+                                           &out_bytes, last ? 0 : TINFL_FLAG_HAS_MORE_INPUT);
+    data += in_bytes;
+    len -= in_bytes;
+    if (out_bytes > 0 && !consume(s, s->dict + s->dict_ofs, out_bytes)) return false;
+    s->dict_ofs = (s->dict_ofs + out_bytes) & (OTA_DICT_SIZE - 1);
+
+    if (status == TINFL_STATUS_DONE) {
+      s->inflate_done = true;
+    } else if (status < TINFL_STATUS_DONE) {
+      return fail(s, "gzip data is corrupt or truncated");
+    } else if (status == TINFL_STATUS_NEEDS_MORE_INPUT && len == 0) {
+      break;    // Next chunk
+    }
+  }
+  return true;
+}
+
+bool otaStream_receive(httpd_req_t* req, OtaProgressFn progress, OtaFinishingFn finishing,
+                       OtaStreamResult* out) {
+  memset(out, 0, sizeof(*out));
+  uint32_t startMs = millis();
+  OtaStream s = {};
+  s.result = out;
+
+  size_t total = req->content_len;
+  const esp_partition_t* target = esp_ota_get_next_update_partition(NULL);
+  s.source = esp_ota_get_running_partition();
+  uint8_t* chunk = (uint8_t*)malloc(OTA_RECV_CHUNK);
+  s.copy_buf = (uint8_t*)malloc(OTA_COPY_CHUNK);
+
+  if (total == 0) {
+    fail(&s, "Empty body (Content-Length required)");
+  } else if (target == NULL || s.source == NULL) {
+    fail(&s, "No OTA partition");
+  } else if (chunk == NULL || s.copy_buf == NULL) {
+    fail(&s, "Out of memory");
+  } else if (esp_ota_begin(target, OTA_WITH_SEQUENTIAL_WRITES, &s.handle) != ESP_OK) {
+    fail(&s, "OTA begin failed");
+  } else {
+    s.begun = true;
+  }
+
+  int timeouts = 0;
+  while (s.error == NULL && out->received < total) {
+    size_t want = total - out->received < OTA_RECV_CHUNK ? total - out->received : OTA_RECV_CHUNK;
+    int n = httpd_req_recv(req, (char*)chunk, want);
+    if (n == HTTPD_SOCK_ERR_TIMEOUT && ++timeouts < OTA_RECV_RETRIES) continue;
+    if (n <= 0) {
+      fail(&s, n == HTTPD_SOCK_ERR_TIMEOUT ? "Upload timed out" : "Upload interrupted");
+      break;
+    }
+    timeouts = 0;
+    const uint8_t* data = chunk;
+    size_t len = n;
+
+    if (out->received == 0 && len >= 2 && data[0] == 0x1f && data[1] == 0x8b) {
+      // gzip (the header is expected in the first chunk)
+      size_t header = gzipHeaderLength(data, len);
+      s.inflator = (tinfl_decompressor*)malloc(sizeof(tinfl_decompressor));
+      s.dict = (uint8_t*)malloc(OTA_DICT_SIZE);
+      if (header == 0) {
+        fail(&s, "Unsupported gzip header");
+        break;
+      }
+      if (s.inflator == NULL || s.dict == NULL) {
+        fail(&s, "Out of memory for inflate");
+        break;
+      }
+      tinfl_init(s.inflator);
+      out->format |= OTA_FORMAT_GZIP;
+      data += header;
+      len -= header;
+    }
+    out->received += n;
+
+    bool ok;
+    if (!(out->format & OTA_FORMAT_GZIP)) ok = consume(&s, data, len);
+    else if (s.inflate_done) ok = true;   // gzip trailer
+    else ok = inflateInput(&s, data, len, out->received >= total);
+    if (!ok) break;
+    if (progress) progress(out->image_size, out->received, total);
+  }
+
+  if (s.error == NULL) {
+    if ((out->format & OTA_FORMAT_GZIP) && !s.inflate_done) fail(&s, "gzip stream truncated");
+    else if (s.stage == STAGE_DETECT) fail(&s, "Image too short");
+    else if ((out->format & OTA_FORMAT_DELTA) && s.stage != STAGE_DELTA_DONE) fail(&s, "Delta truncated");
+    else if ((out->format & OTA_FORMAT_DELTA) && out->image_size != s.target_size) fail(&s, "Delta produced the wrong size");
+  }
+  if (s.begun) {
+    if (s.error == NULL && finishing) finishing();
+    if (s.error != NULL) esp_ota_abort(s.handle);
+    else if (esp_ota_end(s.handle) != ESP_OK) fail(&s, "Image verification failed");
+    else if (esp_ota_set_boot_partition(target) != ESP_OK) fail(&s, "Could not set the boot partition");
+  }
+
+  free(chunk);
+  free(s.copy_buf);
+  free(s.inflator);
+  free(s.dict);
+  out->ok = s.error == NULL;
+  out->error = s.error;
+  out->duration_ms = millis() - startMs;
+  return out->ok;
+}
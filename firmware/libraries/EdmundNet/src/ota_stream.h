@@ -0,0 +1,57 @@
+// ota_stream.h
+// Streamed firmware update over HTTP (POST /ota) with gzip and delta images
+// The request body is decoded on the fly and written straight into the next OTA
+// partition; nothing is buffered beyond a 32 KB inflate window. Accepted bodies:
+//   app.bin              plain image (what ArduinoOTA sends)
+//   app.bin.gz           gzip of the image, inflated with the ROM's tinfl (no code added)
+//   app.delta[.gz]       delta against the running image (scripts/ota_push.py --base)
+// Delta format (little-endian): header "EDLT", version, 3 reserved bytes, the running
+// app's ELF SHA-256 (esp_app_desc_t) and the target size, then ops until OTA_DELTA_OP_END:
+//   COPY   u32 source offset, u32 length  - bytes from the running partition
+//   INSERT u32 length, then that many bytes
+// The result must still pass esp_ota_end()'s image checks (checksum + SHA-256) before
+// it is made bootable, so a corrupt or mismatched delta never replaces the running app.
+// Used by boat_telemetry and camera_stream (firmware/libraries/EdmundNet).
+
+#ifndef OTA_STREAM_H
+#define OTA_STREAM_H
+
+#include <stdint.h>
+#include "esp_http_server.h"
+
+#define OTA_RECV_CHUNK          4096      // Request body read size (heap)
+#define OTA_DELTA_MAGIC         "EDLT"
+#define OTA_DELTA_VERSION       1
+#define OTA_DELTA_OP_END        0
+#define OTA_DELTA_OP_COPY       1
+#define OTA_DELTA_OP_INSERT     2
+#define OTA_PASSWORD_HEADER     "X-OTA-Password"
+
+// OtaStreamResult.format bits
+#define OTA_FORMAT_GZIP         0x01
+#define OTA_FORMAT_DELTA        0x02
+
+typedef struct {
+  bool ok;                  // Image verified and set as the boot partition
+  const char* error;        // Static message when !ok
+  uint8_t format;           // OTA_FORMAT_* bits
+  uint32_t received;        // Request body bytes
+  uint32_t image_size;      // Bytes written to the OTA partition
+  uint32_t copied;          // Of those, copied from the running partition (delta)
+  uint32_t duration_ms;
+} OtaStreamResult;
+
+// Called with image bytes written so far (from the receiving task)
+typedef void (*OtaProgressFn)(uint32_t image_bytes, uint32_t body_bytes, uint32_t body_total);
+
+// Called once the whole image is written, just before esp_ota_end() reads it all back to
+// verify it (the step that ties up flash); only on the way to a reboot
+typedef void (*OtaFinishingFn)();
+
+// Receive the request body into the next OTA partition. Does not send a response and
+// does not restart - on ok the caller answers, then reboots into the new image.
+// progress and finishing may be NULL
+bool otaStream_receive(httpd_req_t* req, OtaProgressFn progress, OtaFinishingFn finishing,
+                       OtaStreamResult* out);
+
+#endif // OTA_STREAM_H
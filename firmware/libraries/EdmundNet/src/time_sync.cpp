@@ -0,0 +1,68 @@
+// time_sync.cpp
+// SNTP client and monotonic -> Unix time conversion
+
+#include "time_sync.h"
+#include <Arduino.h>
+#include <WiFi.h>
+#include <sys/time.h>
+#include "esp_sntp.h"
+
+static bool started = false;
+static char gatewayServer[16];              // Dotted quad (SNTP keeps the pointer)
+static volatile bool synced = false;
+static volatile uint32_t syncCount = 0;
+static volatile int64_t lastSyncUs = 0;
+
+static void onTimeSync(struct timeval* tv) {
+  lastSyncUs = esp_timer_get_time();
+  syncCount++;
+  if (!synced) {
+    synced = true;
+    Serial.printf("✓ Clock synced (SNTP): %lld.%06ld\n", (long long)tv->tv_sec, (long)tv->tv_usec);
+  }
+}
+
+void timeSync_start() {
+  IPAddress gateway = WiFi.gatewayIP();
+  if (started) {
+    // New network: its gateway replaces the old one as the local server
+    if (gateway != IPAddress((uint32_t)0)) {
+      strlcpy(gatewayServer, gateway.toString().c_str(), sizeof(gatewayServer));
+      esp_sntp_setservername(2, gatewayServer);
+    }
+    return;
+  }
+  started = true;
+  esp_sntp_setoperatingmode(ESP_SNTP_OPMODE_POLL);
+  esp_sntp_setservername(0, TIME_SYNC_SERVER_1);
+  esp_sntp_setservername(1, TIME_SYNC_SERVER_2);
+  if (gateway != IPAddress((uint32_t)0)) {
+    strlcpy(gatewayServer, gateway.toString().c_str(), sizeof(gatewayServer));
+    esp_sntp_setservername(2, gatewayServer);
+  }
+  sntp_set_sync_interval(TIME_SYNC_INTERVAL_MS);
+  sntp_set_time_sync_notification_cb(onTimeSync);
+  esp_sntp_init();
+}
+
+bool timeSync_isSynced() {
+  return synced;
+}
+
+uint32_t timeSync_syncCount() {
+  return syncCount;
+}
+
+uint32_t timeSync_lastSyncAgeMs() {
+  if (!synced) return UINT32_MAX;
+  return (uint32_t)((esp_timer_get_time() - lastSyncUs) / 1000);
+}
+
+int64_t timeSync_epochUs(int64_t monotonic_us) {
+  if (monotonic_us >= TIME_SYNC_EPOCH_MIN_US) return monotonic_us;
+  if (!synced) return 0;
+  struct timeval now;
+  gettimeofday(&now, NULL);
+  int64_t offset = (int64_t)now.tv_sec * 1000000LL + now.tv_usec - esp_timer_get_time();
+  return monotonic_us + offset;
+}
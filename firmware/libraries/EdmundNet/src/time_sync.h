@@ -0,0 +1,30 @@
+// time_sync.h
+// Shared wall clock for the boat and the camera (SNTP)
+// Both boards poll the same servers - the public pool, then the WiFi gateway, which
+// answers NTP on most routers - so camera frame stamps and telemetry samples line up
+// to within a few ms once synced. Everything is stamped on the monotonic esp_timer
+// clock first and converted on output, so a clock step never reorders records.
+// Used by boat_telemetry and camera_stream (firmware/libraries/EdmundNet).
+
+#ifndef TIME_SYNC_H
+#define TIME_SYNC_H
+
+#include <stdint.h>
+
+#define TIME_SYNC_SERVER_1       "pool.ntp.org"
+#define TIME_SYNC_SERVER_2       "time.google.com"
+#define TIME_SYNC_INTERVAL_MS    (15 * 60 * 1000)   // Re-poll period once synced
+#define TIME_SYNC_EPOCH_MIN_US   1577836800000000LL // 2020-01-01: anything later is already Unix time
+
+// Start SNTP (call once the station has an IP; later calls only refresh the gateway server)
+void timeSync_start();
+
+bool timeSync_isSynced();
+uint32_t timeSync_syncCount();
+uint32_t timeSync_lastSyncAgeMs();      // UINT32_MAX until the first sync
+
+// esp_timer time (us since boot) -> Unix time in us, 0 until synced.
+// Values that already look like Unix time are returned unchanged
+int64_t timeSync_epochUs(int64_t monotonic_us);
+
+#endif // TIME_SYNC_H
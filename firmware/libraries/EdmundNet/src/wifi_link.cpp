@@ -0,0 +1,366 @@
+// wifi_link.cpp
+// WiFi station state machine: cached BSSID -> async scan -> backoff
+
+#include "wifi_link.h"
+#include <Arduino.h>
+#include <WiFi.h>
+#include <Preferences.h>
+
+#define WIFI_LINK_NVS_NAMESPACE "wifi_link"
+#define WIFI_LINK_CONNECTED_BIT BIT0
+
+typedef enum {
+  LINK_EV_GOT_IP = 0,
+  LINK_EV_DISCONNECTED,
+  LINK_EV_SCAN_DONE
+} LinkEventType;
+
+typedef struct {
+  uint8_t type;
+  uint8_t reason;           // wifi_err_reason_t (disconnects)
+} LinkEvent;
+
+// Last AP that gave us an IP (stored as one NVS blob, no padding)
+typedef struct {
+  char ssid[33];
+  uint8_t bssid[6];
+  uint8_t channel;
+} CachedAp;
+
+static const WifiCandidate* candidates = NULL;
+static size_t candidateCount = 0;
+static WifiLinkCallback connectedCallback = NULL;
+static QueueHandle_t eventQueue = NULL;
+static EventGroupHandle_t linkEvents = NULL;
+
+// Shared with callers, guarded by stateMux
+static WifiLinkState state = { WIFI_LINK_IDLE, false, false, 0, 0, 0, 0, 0 };
+static portMUX_TYPE stateMux = portMUX_INITIALIZER_UNLOCKED;
+
+// Task-only module state
+static CachedAp cache;
+static bool cacheValid = false;
+static bool deadlineArmed = false;
+static TickType_t deadline = 0;
+static uint32_t attemptStartMs = 0;
+static uint32_t backoffMs = WIFI_LINK_BACKOFF_MIN_MS;
+
+const char* wifiLink_phaseName(WifiLinkPhase phase) {
+  switch (phase) {
+    case WIFI_LINK_IDLE:              return "idle";
+    case WIFI_LINK_CONNECTING_CACHED: return "connecting_cached";
+    case WIFI_LINK_SCANNING:          return "scanning";
+    case WIFI_LINK_JOINING:           return "joining";
+    case WIFI_LINK_CONNECTED:         return "connected";
+    case WIFI_LINK_BACKOFF:           return "backoff";
+    default:                          return "unknown";
+  }
+}
+
+// ==================== NVS CACHE ====================
+static void loadCache() {
+  Preferences prefs;
+  if (!prefs.begin(WIFI_LINK_NVS_NAMESPACE, true)) return;  // Namespace not created yet (first boot)
+  size_t n = prefs.getBytes("ap", &cache, sizeof(cache));
+  prefs.end();
+  cache.ssid[sizeof(cache.ssid) - 1] = '\0';
+  cacheValid = n == sizeof(cache) && cache.ssid[0] != '\0' && cache.channel > 0;
+}
+
+static void saveCache() {
+  CachedAp ap;
+  memset(&ap, 0, sizeof(ap));
+  strlcpy(ap.ssid, WiFi.SSID().c_str(), sizeof(ap.ssid));
+  uint8_t* bssid = WiFi.BSSID();
+  if (bssid) memcpy(ap.bssid, bssid, sizeof(ap.bssid));
+  ap.channel = WiFi.channel();
+  if (!bssid || ap.channel == 0) return;
+
+  // Only write flash when the AP actually changed (reconnects to the same AP are free)
+  if (cacheValid && memcmp(&ap, &cache, sizeof(ap)) == 0) return;
+  Preferences prefs;
+  if (!prefs.begin(WIFI_LINK_NVS_NAMESPACE, false)) {
+    Serial.println("✗ WiFi: NVS cache not writable");
+    return;
+  }
+  prefs.putBytes("ap", &ap, sizeof(ap));
+  prefs.end();
+  cache = ap;
+  cacheValid = true;
+  Serial.printf("WiFi: cached %s (%02X:%02X:%02X:%02X:%02X:%02X, ch %u)\n", ap.ssid,
+                ap.bssid[0], ap.bssid[1], ap.bssid[2], ap.bssid[3], ap.bssid[4], ap.bssid[5], ap.channel);
+}
+
+// ==================== STATE MACHINE ====================
+static const WifiCandidate* matchCandidate(const char* ssid) {
+  for (size_t i = 0; i < candidateCount; i++) {
+    const WifiCandidate* c = &candidates[i];
+    if (c->substring ? strstr(ssid, c->ssid) != NULL : strcmp(ssid, c->ssid) == 0) return c;
+  }
+  return NULL;
+}
+
+static void setPhase(WifiLinkPhase phase) {
+  portENTER_CRITICAL(&stateMux);
+  state.phase = phase;
+  portEXIT_CRITICAL(&stateMux);
+}
+
+static void arm(uint32_t ms) {
+  deadline = xTaskGetTickCount() + pdMS_TO_TICKS(ms);
+  deadlineArmed = true;
+}
+
+static void backoff() {
+  Serial.printf("WiFi: retrying in %lu ms\n", (unsigned long)backoffMs);
+  setPhase(WIFI_LINK_BACKOFF);
+  arm(backoffMs);
+  backoffMs = min(backoffMs * 2, (uint32_t)WIFI_LINK_BACKOFF_MAX_MS);
+}
+
+// Straight to the cached AP on its channel (no scan). False if there is nothing usable cached
+static bool joinCached() {
+  if (!cacheValid) return false;
+  const WifiCandidate* c = matchCandidate(cache.ssid);
+  if (!c) return false;  // Cached network is no longer configured
+
+  Serial.printf("WiFi: direct connect to %s (ch %u, cached BSSID)\n", cache.ssid, cache.channel);
+  portENTER_CRITICAL(&stateMux);
+  state.via_cache = true;
+  portEXIT_CRITICAL(&stateMux);
+  WiFi.begin(cache.ssid, c->password, cache.channel, cache.bssid);
+  setPhase(WIFI_LINK_CONNECTING_CACHED);
+  arm(WIFI_LINK_CACHED_TIMEOUT_MS);
+  return true;
+}
+
+static void startScan() {
+  WiFi.disconnect();  // A scan is refused while a join is still in progress
+  if (WiFi.scanNetworks(true, false, false, WIFI_LINK_SCAN_MS_PER_CHAN) == WIFI_SCAN_FAILED) {
+    Serial.println("✗ WiFi: scan failed to start");
+    backoff();
+    return;
+  }
+  Serial.println("WiFi: scanning...");
+  portENTER_CRITICAL(&stateMux);
+  state.scans++;
+  portEXIT_CRITICAL(&stateMux);
+  setPhase(WIFI_LINK_SCANNING);
+  arm(WIFI_LINK_SCAN_TIMEOUT_MS);
+}
+
+// Pick the first candidate (priority order) the scan saw, strongest AP for it
+static void joinFromScan() {
+  int n = WiFi.scanComplete();
+  const WifiCandidate* chosen = NULL;
+  int best = -1;
+  for (size_t c = 0; c < candidateCount && best < 0; c++) {
+    for (int i = 0; i < n; i++) {
+      String ssid = WiFi.SSID(i);
+      bool match = candidates[c].substring ? ssid.indexOf(candidates[c].ssid) >= 0 : ssid == candidates[c].ssid;
+      if (match && (best < 0 || WiFi.RSSI(i) > WiFi.RSSI(best))) best = i;
+    }
+    if (best >= 0) chosen = &candidates[c];
+  }
+
+  if (chosen) {
+    String ssid = WiFi.SSID(best);
+    Serial.printf("WiFi: scan found %d networks, joining %s (ch %ld, %ld dBm)\n",
+                  n, ssid.c_str(), (long)WiFi.channel(best), (long)WiFi.RSSI(best));
+    WiFi.begin(ssid.c_str(), chosen->password, WiFi.channel(best), WiFi.BSSID(best));
+  } else {
+    for (size_t c = 0; c < candidateCount && !chosen; c++) {
+      if (candidates[c].blind) chosen = &candidates[c];
+    }
+    if (!chosen) {
+      Serial.printf("WiFi: scan found %d networks, none known\n", n);
+      WiFi.scanDelete();
+      backoff();
+      return;
+    }
+    Serial.printf("WiFi: no known networks in scan. Blind-connecting to %s\n", chosen->ssid);
+    WiFi.begin(chosen->ssid, chosen->password);
+  }
+  WiFi.scanDelete();
+
+  portENTER_CRITICAL(&stateMux);
+  state.via_cache = false;
+  portEXIT_CRITICAL(&stateMux);
+  setPhase(WIFI_LINK_JOINING);
+  arm(WIFI_LINK_JOIN_TIMEOUT_MS);
+}
+
+static void attempt() {
+  attemptStartMs = millis();
+  if (!joinCached()) startScan();
+}
+
+static void handleGotIp() {
+  deadlineArmed = false;
+  backoffMs = WIFI_LINK_BACKOFF_MIN_MS;
+  uint32_t elapsed = millis() - attemptStartMs;
+  saveCache();
+
+  portENTER_CRITICAL(&stateMux);
+  state.phase = WIFI_LINK_CONNECTED;
+  state.connected = true;
+  state.channel = WiFi.channel();
+  state.connects++;
+  state.last_connect_ms = elapsed;
+  bool viaCache = state.via_cache;
+  portEXIT_CRITICAL(&stateMux);
+  xEventGroupSetBits(linkEvents, WIFI_LINK_CONNECTED_BIT);
+
+  Serial.printf("✓ WiFi connected to %s in %lu ms%s - IP %s\n", WiFi.SSID().c_str(),
+                (unsigned long)elapsed, viaCache ? " (cached BSSID)" : "",
+                WiFi.localIP().toString().c_str());
+  if (connectedCallback) connectedCallback();
+}
+
+static void handleDisconnected(uint8_t reason) {
+  WifiLinkPhase phase = state.phase;  // Only this task writes phase
+  // Our own WiFi.disconnect() (before a scan) reports ASSOC_LEAVE - not a failure.
+  // While connected every drop counts (an AP shutting down can use the same reason)
+  if (phase != WIFI_LINK_CONNECTED && reason == WIFI_REASON_ASSOC_LEAVE) return;
+
+  switch (phase) {
+    case WIFI_LINK_CONNECTED:
+      xEventGroupClearBits(linkEvents, WIFI_LINK_CONNECTED_BIT);
+      portENTER_CRITICAL(&stateMux);
+      state.connected = false;
+      state.last_disconnect_reason = reason;
+      portEXIT_CRITICAL(&stateMux);
+      Serial.printf("✗ WiFi lost (reason %u) - reconnecting\n", reason);
+      attempt();
+      break;
+    case WIFI_LINK_CONNECTING_CACHED:
+      Serial.printf("WiFi: cached AP failed (reason %u)\n", reason);
+      startScan();
+      break;
+    case WIFI_LINK_JOINING:
+      Serial.printf("✗ WiFi: join failed (reason %u)\n", reason);
+      backoff();
+      break;
+    default:
+      break;  // Scanning / backoff: nothing in flight
+  }
+}
+
+static void handleTimeout() {
+  switch (state.phase) {
+    case WIFI_LINK_CONNECTING_CACHED:
+      Serial.println("WiFi: cached AP timed out");
+      startScan();
+      break;
+    case WIFI_LINK_SCANNING:
+      Serial.println("✗ WiFi: scan timed out");
+      WiFi.scanDelete();
+      backoff();
+      break;
+    case WIFI_LINK_JOINING:
+      Serial.println("✗ WiFi: join timed out");
+      WiFi.disconnect();
+      backoff();
+      break;
+    case WIFI_LINK_BACKOFF:
+      attempt();
+      break;
+    default:
+      break;
+  }
+}
+
+static void linkTask(void* param) {
+  attempt();
+
+  LinkEvent ev;
+  while (true) {
+    TickType_t wait = portMAX_DELAY;
+    if (deadlineArmed) {
+      int32_t remaining = (int32_t)(deadline - xTaskGetTickCount());
+      wait = remaining > 0 ? remaining : 0;
+    }
+
+    if (xQueueReceive(eventQueue, &ev, wait) == pdTRUE) {
+      switch (ev.type) {
+        case LINK_EV_GOT_IP:
+          if (state.phase != WIFI_LINK_CONNECTED) handleGotIp();
+          break;
+        case LINK_EV_DISCONNECTED:
+          handleDisconnected(ev.reason);
+          break;
+        case LINK_EV_SCAN_DONE:
+          if (state.phase == WIFI_LINK_SCANNING) joinFromScan();
+          break;
+      }
+    } else if (deadlineArmed) {
+      deadlineArmed = false;
+      handleTimeout();
+    }
+  }
+}
+
+// Runs in the Arduino event task - just hand the event to the link task
+static void onWiFiEvent(arduino_event_id_t event, arduino_event_info_t info) {
+  LinkEvent ev = { 0, 0 };
+  switch (event) {
+    case ARDUINO_EVENT_WIFI_STA_GOT_IP:
+      ev.type = LINK_EV_GOT_IP;
+      break;
+    case ARDUINO_EVENT_WIFI_STA_DISCONNECTED:
+      ev.type = LINK_EV_DISCONNECTED;
+      ev.reason = info.wifi_sta_disconnected.reason;
+      break;
+    case ARDUINO_EVENT_WIFI_SCAN_DONE:
+      ev.type = LINK_EV_SCAN_DONE;
+      break;
+    default:
+      return;
+  }
+  xQueueSend(eventQueue, &ev, 0);
+}
+
+// ==================== PUBLIC API ====================
+bool wifiLink_start(const WifiCandidate* list, size_t count, WifiLinkCallback onConnected) {
+  candidates = list;
+  candidateCount = count;
+  connectedCallback = onConnected;
+  eventQueue = xQueueCreate(8, sizeof(LinkEvent));
+  linkEvents = xEventGroupCreate();
+  if (eventQueue == NULL || linkEvents == NULL) {
+    Serial.println("✗ WiFi link allocation failed");
+    return false;
+  }
+
+  loadCache();
+  WiFi.persistent(false);         // Our NVS cache replaces the IDF's stored config
+  WiFi.setAutoReconnect(false);   // Reconnects go through the cached BSSID first
+  WiFi.mode(WIFI_STA);
+  WiFi.onEvent(onWiFiEvent);
+
+  if (xTaskCreatePinnedToCore(linkTask, "WiFiLink", 4096, NULL,
+                              WIFI_LINK_TASK_PRIORITY, NULL, WIFI_LINK_TASK_CORE) != pdPASS) {
+    Serial.println("✗ WiFi link task creation failed");
+    return false;
+  }
+  Serial.printf("WiFi link task created on Core %d (cached AP: %s)\n",
+                WIFI_LINK_TASK_CORE, cacheValid ? cache.ssid : "none");
+  return true;
+}
+
+bool wifiLink_waitConnected(uint32_t timeout_ms) {
+  if (linkEvents == NULL) return false;
+  EventBits_t bits = xEventGroupWaitBits(linkEvents, WIFI_LINK_CONNECTED_BIT, pdFALSE, pdTRUE,
+                                         pdMS_TO_TICKS(timeout_ms));
+  return (bits & WIFI_LINK_CONNECTED_BIT) != 0;
+}
+
+bool wifiLink_connected() {
+  return linkEvents != NULL && (xEventGroupGetBits(linkEvents) & WIFI_LINK_CONNECTED_BIT) != 0;
+}
+
+void wifiLink_getState(WifiLinkState* out) {
+  portENTER_CRITICAL(&stateMux);
+  *out = state;
+  portEXIT_CRITICAL(&stateMux);
+}
@@ -0,0 +1,67 @@
+// wifi_link.h
+// Event-driven WiFi station link with fast reconnect
+// The last network that gave us an IP (SSID, BSSID, channel) is kept in NVS.
+// Boot and every reconnect first go straight to that AP on its channel, with no
+// scan, which usually takes a few hundred ms. An async scan happens only when
+// that fails. A small task runs the state machine from WiFi events and timeouts,
+// so neither setup() nor loop() busy-waits on WiFi.status().
+// Used by boat_telemetry and camera_stream (firmware/libraries/EdmundNet).
+
+#ifndef WIFI_LINK_H
+#define WIFI_LINK_H
+
+#include <stdint.h>
+#include <cstddef>
+
+#define WIFI_LINK_TASK_CORE        0       // With the WiFi stack
+#define WIFI_LINK_TASK_PRIORITY    2
+#define WIFI_LINK_CACHED_TIMEOUT_MS 5000   // Direct connect to the cached AP
+#define WIFI_LINK_SCAN_TIMEOUT_MS  8000    // Async scan (normally ~2 s)
+#define WIFI_LINK_JOIN_TIMEOUT_MS  12000   // Connect to a network picked by scan
+#define WIFI_LINK_SCAN_MS_PER_CHAN 120     // Active scan dwell time
+#define WIFI_LINK_BACKOFF_MIN_MS   2000    // Retry delay after a failed scan + join
+#define WIFI_LINK_BACKOFF_MAX_MS   30000
+
+// Known network, in priority order. substring: ssid only has to appear in the
+// scanned SSID (e.g. "iPhone"). blind: join even when the scan did not see it
+typedef struct {
+  const char* ssid;
+  const char* password;
+  bool substring;
+  bool blind;
+} WifiCandidate;
+
+typedef enum {
+  WIFI_LINK_IDLE = 0,
+  WIFI_LINK_CONNECTING_CACHED,    // Direct join to the NVS BSSID/channel
+  WIFI_LINK_SCANNING,
+  WIFI_LINK_JOINING,              // Join to the network picked by scan
+  WIFI_LINK_CONNECTED,
+  WIFI_LINK_BACKOFF               // Waiting before the next attempt
+} WifiLinkPhase;
+
+typedef struct {
+  WifiLinkPhase phase;
+  bool connected;
+  bool via_cache;                 // Current/last connection used the cached BSSID
+  uint8_t channel;
+  uint32_t connects;              // Successful connections since boot
+  uint32_t scans;                 // Scans needed (cache misses)
+  uint32_t last_connect_ms;       // Attempt start -> got IP, for the last connection
+  uint8_t last_disconnect_reason; // wifi_err_reason_t of the last drop (0 = none)
+} WifiLinkState;
+
+typedef void (*WifiLinkCallback)();
+
+// Start the link task; candidates must stay valid (static table). onConnected
+// runs in the link task after each successful connection (may be NULL)
+bool wifiLink_start(const WifiCandidate* candidates, size_t count, WifiLinkCallback onConnected);
+
+// Block the caller (not the link) until connected or timeout. True if connected
+bool wifiLink_waitConnected(uint32_t timeout_ms);
+
+bool wifiLink_connected();
+void wifiLink_getState(WifiLinkState* out);
+const char* wifiLink_phaseName(WifiLinkPhase phase);
+
+#endif // WIFI_LINK_H
@@ -0,0 +1,346 @@
+// engine_golden_test.cpp
+// Host checks for the engine, for every bank x output rate:
+//   golden    a scripted 2 s throttle run (sweep 0 -> 1, then idle / rev / cruise) rendered
+//             through the audio task's path (processControl + renderSamples) on the simulated
+//             clock with the fixed kernel (what the boat runs), compared sample by sample
+//             with golden/<bank>_<rate>.wav. A mismatch writes the render to
+//             <out>/<bank>_<rate>_fixed.wav to listen to or diff.
+//   accuracy  the float reference kernel against the fixed one over short windows of the
+//             script, each from a fresh start (the float kernel's position loses resolution
+//             past 65536 samples, so over the whole run the two drift apart in phase)
+//   benchmark std::chrono timing of audioEngine_renderSamples at idle / half / full throttle
+//             and of audioEngine_updateThrottle (printed; host timings are not asserted)
+// After an intended change to the sound, regenerate the goldens:
+//   engine_golden_test --update <golden dir> <out dir> name=engine_bank.bin ...
+// The goldens are rendered on one toolchain (gcc 12 x86-64, -ffp-contract=off). Another libm
+// or FP contraction moves the output by a few LSB (FMA or -ffast-math: 6 at most, SNR above
+// 85 dB), so the check is an error budget rather than exact samples; an exact match is
+// reported when there is one.
+
+#include "audio_engine.h"
+#include "esp_partition.h"
+#include <Arduino.h>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+#include <string>
+#include <vector>
+
+static const uint32_t TEST_RATES[] = { AUDIO_RATE_FULL, AUDIO_RATE_HALF, AUDIO_RATE_LOW };
+
+#define SCRIPT_BLOCK            128     // Samples per rendered block (ENGINE_BENCH_BLOCK)
+#define SCRIPT_MS               2000
+
+// Golden comparison (same kernel, another toolchain): error RMS at least this far below
+// the golden's RMS, and no single sample further off than this
+#define GOLDEN_MIN_SNR_DB       75.0
+#define GOLDEN_MAX_ABS          32
+
+// Fixed kernel against the float reference: Q16 phase, integer lerp and the soft-clip
+// lookup table together stay this close
+#define KERNEL_MIN_SNR_DB       50.0
+#define KERNEL_MAX_ABS          256
+#define KERNEL_WINDOW_MS        250
+
+// Accuracy windows: the start of the sweep, and the snap from idle to 0.9 (rev, soft clip)
+static const uint32_t KERNEL_WINDOWS_MS[] = { 0, 1250 };
+
+#define BENCH_SETTLE_MS         1000    // Smoothing settles before a throttle point is timed
+#define BENCH_RENDER_MS         2000    // Audio rendered per timed point
+#define BENCH_UPDATES           200000
+
+// Throttle over the script: 1 s sweep, then idle, a snap to 0.9 (rev transient), cruise
+static float scriptThrottle(uint32_t us) {
+  if (us < 1000000) return us / 1000000.0f;
+  if (us < 1250000) return 0.1f;
+  if (us < 1500000) return 0.9f;
+  return 0.2f;
+}
+
+static bool startEngine(uint32_t rate, uint8_t kernel) {
+  hostClock_set(0);
+  audioEngine_init(rate);
+  audioEngine_setKernel(kernel);
+  audioEngine_processControl();
+  return audioEngine_getKernel() == kernel;
+}
+
+// One block the way the audio task does it: control, then render
+static void renderBlock(int16_t* out, uint32_t block_us) {
+  hostClock_advance(block_us);
+  audioEngine_processControl();
+  audioEngine_renderSamples(out, SCRIPT_BLOCK);
+}
+
+// Render length_ms of the script from start_ms on (the engine is started fresh by the caller)
+static std::vector<int16_t> renderScript(uint32_t rate, uint32_t start_ms, uint32_t length_ms) {
+  const uint32_t block_us = (uint32_t)(SCRIPT_BLOCK * 1000000ULL / rate);
+  const uint32_t blocks = (uint32_t)((uint64_t)rate * length_ms / 1000 / SCRIPT_BLOCK);
+  std::vector<int16_t> pcm(blocks * SCRIPT_BLOCK);
+  uint32_t t_us = start_ms * 1000;
+  for (uint32_t b = 0; b < blocks; b++, t_us += block_us) {
+    audioEngine_postThrottle(scriptThrottle(t_us));
+    renderBlock(&pcm[b * SCRIPT_BLOCK], block_us);
+  }
+  return pcm;
+}
+
+// ==================== WAV ====================
+static bool writeWav(const std::string& path, uint32_t rate, const std::vector<int16_t>& pcm) {
+  FILE* f = fopen(path.c_str(), "wb");
+  if (!f) return false;
+  uint32_t data_bytes = (uint32_t)(pcm.size() * sizeof(int16_t));
+  uint32_t riff_bytes = 36 + data_bytes;
+  uint32_t fmt_bytes = 16, byte_rate = rate * 2;
+  uint16_t pcm_format = 1, channels = 1, block_align = 2, bits = 16;
+  fwrite("RIFF", 1, 4, f);  fwrite(&riff_bytes, 4, 1, f);  fwrite("WAVE", 1, 4, f);
+  fwrite("fmt ", 1, 4, f);  fwrite(&fmt_bytes, 4, 1, f);
+  fwrite(&pcm_format, 2, 1, f);  fwrite(&channels, 2, 1, f);  fwrite(&rate, 4, 1, f);
+  fwrite(&byte_rate, 4, 1, f);  fwrite(&block_align, 2, 1, f);  fwrite(&bits, 2, 1, f);
+  fwrite("data", 1, 4, f);  fwrite(&data_bytes, 4, 1, f);
+  fwrite(pcm.data(), sizeof(int16_t), pcm.size(), f);
+  return fclose(f) == 0;
+}
+
+// Mono 16-bit PCM only (what writeWav produces); false if missing or another format
+static bool readWav(const std::string& path, uint32_t* rate, std::vector<int16_t>* pcm) {
+  FILE* f = fopen(path.c_str(), "rb");
+  if (!f) return false;
+  char id[4];
+  uint32_t size;
+  bool ok = fread(id, 1, 4, f) == 4 && memcmp(id, "RIFF", 4) == 0 && fread(&size, 4, 1, f) == 1 &&
+            fread(id, 1, 4, f) == 4 && memcmp(id, "WAVE", 4) == 0;
+  bool have_fmt = false;
+  while (ok && fread(id, 1, 4, f) == 4 && fread(&size, 4, 1, f) == 1) {
+    if (memcmp(id, "fmt ", 4) == 0 && size >= 16) {
+      uint16_t format, channels, block_align, bits;
+      uint32_t byte_rate;
+      ok = fread(&format, 2, 1, f) == 1 && fread(&channels, 2, 1, f) == 1 && fread(rate, 4, 1, f) == 1 &&
+           fread(&byte_rate, 4, 1, f) == 1 && fread(&block_align, 2, 1, f) == 1 && fread(&bits, 2, 1, f) == 1 &&
+           format == 1 && channels == 1 && bits == 16 && fseek(f, size - 16, SEEK_CUR) == 0;
+      have_fmt = ok;
+    } else if (memcmp(id, "data", 4) == 0 && have_fmt) {
+      pcm->resize(size / sizeof(int16_t));
+      ok = fread(pcm->data(), sizeof(int16_t), pcm->size(), f) == pcm->size();
+      fclose(f);
+      return ok;
+    } else {
+      ok = fseek(f, size + (size & 1), SEEK_CUR) == 0;
+    }
+  }
+  fclose(f);
+  return false;
+}
+
+// ==================== COMPARISON ====================
+typedef struct {
+  bool exact;
+  int max_abs;
+  double snr_db;            // Reference RMS over error RMS (INFINITY when exact)
+} PcmDiff;
+
+static PcmDiff comparePcm(const std::vector<int16_t>& ref, const std::vector<int16_t>& got) {
+  PcmDiff d = { true, 0, INFINITY };
+  double ref_sq = 0.0, err_sq = 0.0;
+  for (size_t i = 0; i < ref.size(); i++) {
+    int err = got[i] - ref[i];
+    if (err != 0) d.exact = false;
+    if (abs(err) > d.max_abs) d.max_abs = abs(err);
+    ref_sq += (double)ref[i] * ref[i];
+    err_sq += (double)err * err;
+  }
+  if (err_sq > 0.0) d.snr_db = 10.0 * log10(ref_sq / err_sq);
+  return d;
+}
+
+static bool withinBudget(const char* what, const std::string& name, const PcmDiff& d,
+                         double min_snr_db, int max_abs) {
+  bool ok = d.snr_db >= min_snr_db && d.max_abs <= max_abs;
+  if (d.exact) {
+    printf("✓ %s %s: exact\n", what, name.c_str());
+  } else {
+    printf("%s %s %s: SNR %.1f dB (min %.0f), max error %d (max %d)\n", ok ? "✓" : "✗",
+           what, name.c_str(), d.snr_db, min_snr_db, d.max_abs, max_abs);
+  }
+  return ok;
+}
+
+static bool silent(const std::vector<int16_t>& pcm) {
+  for (int16_t s : pcm) {
+    if (s != 0) return false;
+  }
+  return true;
+}
+
+// ==================== BENCHMARK ====================
+static double elapsedNs(std::chrono::steady_clock::time_point start) {
+  return (double)std::chrono::duration_cast<std::chrono::nanoseconds>(
+    std::chrono::steady_clock::now() - start).count();
+}
+
+static void benchmark(const std::string& name, uint32_t rate, uint8_t kernel) {
+  static const float POINTS[] = { 0.0f, 0.5f, 1.0f };
+  const uint32_t block_us = (uint32_t)(SCRIPT_BLOCK * 1000000ULL / rate);
+  int16_t block[SCRIPT_BLOCK];
+  double ns_per_sample[3];
+
+  startEngine(rate, kernel);
+  for (int p = 0; p < 3; p++) {
+    audioEngine_postThrottle(POINTS[p]);
+    for (uint32_t us = 0; us < BENCH_SETTLE_MS * 1000; us += block_us) renderBlock(block, block_us);
+    uint32_t blocks = (uint32_t)((uint64_t)rate * BENCH_RENDER_MS / 1000 / SCRIPT_BLOCK);
+    double ns = 0.0;
+    for (uint32_t b = 0; b < blocks; b++) {
+      hostClock_advance(block_us);
+      audioEngine_processControl();
+      auto start = std::chrono::steady_clock::now();
+      audioEngine_renderSamples(block, SCRIPT_BLOCK);
+      ns += elapsedNs(start);
+    }
+    ns_per_sample[p] = ns / ((double)blocks * SCRIPT_BLOCK);
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  for (uint32_t i = 0; i < BENCH_UPDATES; i++) {
+    hostClock_advance(block_us);
+    audioEngine_updateThrottle((i % 100) / 100.0f);
+  }
+  double ns_per_update = elapsedNs(start) / BENCH_UPDATES;
+
+  // Headroom at full throttle: how many times faster than the output consumes it
+  double realtime = 1e9 / (ns_per_sample[2] * rate);
+  printf("  bench %s %s: render %.1f / %.1f / %.1f ns/sample (idle / half / full), "
+         "update %.1f ns, %.0fx real time\n",
+         name.c_str(), audioEngine_getKernelName(), ns_per_sample[0], ns_per_sample[1],
+         ns_per_sample[2], ns_per_update, realtime);
+}
+
+// ==================== MAIN ====================
+static bool readFile(const char* path, std::vector<uint8_t>* out) {
+  FILE* f = fopen(path, "rb");
+  if (!f) return false;
+  uint8_t chunk[4096];
+  size_t n;
+  while ((n = fread(chunk, 1, sizeof(chunk), f)) > 0) out->insert(out->end(), chunk, chunk + n);
+  fclose(f);
+  return true;
+}
+
+int main(int argc, char** argv) {
+  bool update = argc > 1 && strcmp(argv[1], "--update") == 0;
+  int first = update ? 2 : 1;
+  if (argc - first < 3) {
+    fprintf(stderr, "Usage: %s [--update] <golden dir> <out dir> name=engine_bank.bin ...\n", argv[0]);
+    return 2;
+  }
+  std::string golden_dir = argv[first];
+  std::string out_dir = argv[first + 1];
+
+  int failed = 0;
+  std::vector<std::string> bench_lines;
+  for (int a = first + 2; a < argc; a++) {
+    const char* eq = strchr(argv[a], '=');
+    if (!eq) {
+      fprintf(stderr, "Expected name=engine_bank.bin, got '%s'\n", argv[a]);
+      return 2;
+    }
+    std::string bank(argv[a], eq - argv[a]);
+    std::vector<uint8_t> image;
+    if (!readFile(eq + 1, &image)) {
+      fprintf(stderr, "Cannot read bank %s\n", eq + 1);
+      return 2;
+    }
+    hostPartition_load(image.data(), image.size());
+
+    for (uint32_t rate : TEST_RATES) {
+      std::string name = bank + "_" + std::to_string(rate);
+      if (!startEngine(rate, AUDIO_KERNEL_FIXED)) {
+        printf("✗ %s: fixed kernel not selected\n", name.c_str());
+        failed++;
+        continue;
+      }
+      std::vector<int16_t> fixed = renderScript(rate, 0, SCRIPT_MS);
+      if (silent(fixed)) {
+        printf("✗ %s: engine rendered silence\n", name.c_str());
+        failed++;
+        continue;
+      }
+
+      std::string golden_path = golden_dir + "/" + name + ".wav";
+      if (update) {
+        if (!writeWav(golden_path, rate, fixed)) {
+          printf("✗ Cannot write %s\n", golden_path.c_str());
+          return 1;
+        }
+        printf("✓ Wrote %s\n", golden_path.c_str());
+        continue;
+      }
+
+      uint32_t golden_rate = 0;
+      std::vector<int16_t> golden;
+      if (!readWav(golden_path, &golden_rate, &golden)) {
+        printf("✗ golden %s: cannot read %s (run with --update)\n", name.c_str(), golden_path.c_str());
+        failed++;
+      } else if (golden_rate != rate || golden.size() != fixed.size()) {
+        printf("✗ golden %s: %s is %lu samples @ %lu Hz, render is %lu @ %lu Hz\n", name.c_str(),
+               golden_path.c_str(), (unsigned long)golden.size(), (unsigned long)golden_rate,
+               (unsigned long)fixed.size(), (unsigned long)rate);
+        failed++;
+      } else if (!withinBudget("golden", name, comparePcm(golden, fixed), GOLDEN_MIN_SNR_DB, GOLDEN_MAX_ABS)) {
+        std::string path = out_dir + "/" + name + "_fixed.wav";
+        if (writeWav(path, rate, fixed)) printf("  render written to %s\n", path.c_str());
+        failed++;
+      }
+
+      for (uint32_t start_ms : KERNEL_WINDOWS_MS) {
+        std::string window = name + "@" + std::to_string(start_ms) + "ms";
+        std::vector<int16_t> kernels[2];
+        for (uint8_t k = AUDIO_KERNEL_FLOAT; k <= AUDIO_KERNEL_FIXED; k++) {
+          startEngine(rate, k);
+          kernels[k] = renderScript(rate, start_ms, KERNEL_WINDOW_MS);
+        }
+        const std::vector<int16_t>& ref = kernels[AUDIO_KERNEL_FLOAT];
+        const std::vector<int16_t>& got = kernels[AUDIO_KERNEL_FIXED];
+        if (!withinBudget("fixed vs float", window, comparePcm(ref, got), KERNEL_MIN_SNR_DB, KERNEL_MAX_ABS)) {
+          std::string stem = out_dir + "/" + name + "_" + std::to_string(start_ms) + "ms";
+          if (writeWav(stem + "_float.wav", rate, ref) && writeWav(stem + "_fixed.wav", rate, got)) {
+            printf("  both kernels written to %s_{float,fixed}.wav\n", stem.c_str());
+          }
+          failed++;
+        }
+      }
+
+      // The on-target benchmark's own scripts must run too (its hashes are per toolchain)
+      audioEngine_runBenchmark();
+      EngineBenchResult r;
+      if (!audioEngine_getBenchmark(&r) || r.sweep_peak == 0) {
+        printf("✗ %s: audioEngine_runBenchmark produced no output\n", name.c_str());
+        failed++;
+      }
+    }
+  }
+  if (update) return 0;
+
+  // Timing last, after the engine's own log lines
+  printf("Host benchmark (%u-sample blocks):\n", SCRIPT_BLOCK);
+  for (int a = first + 2; a < argc; a++) {
+    const char* eq = strchr(argv[a], '=');
+    std::string bank(argv[a], eq - argv[a]);
+    std::vector<uint8_t> image;
+    readFile(eq + 1, &image);
+    hostPartition_load(image.data(), image.size());
+    for (uint32_t rate : TEST_RATES) {
+      std::string name = bank + "_" + std::to_string(rate);
+      benchmark(name, rate, AUDIO_KERNEL_FIXED);
+      benchmark(name, rate, AUDIO_KERNEL_FLOAT);
+    }
+  }
+
+  if (failed) {
+    printf("✗ %d check(s) failed (run with --update only if the change to the sound is intended)\n", failed);
+    return 1;
+  }
+  printf("✓ All checks passed\n");
+  return 0;
+}
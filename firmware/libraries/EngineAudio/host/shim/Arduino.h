@@ -0,0 +1,44 @@
+// Arduino.h (host shim)
+// Just enough of the ESP32 Arduino core for audio_engine.cpp and engine_bank.cpp to
+// build on the host: Serial goes to stdout, micros() / millis() run on a simulated clock
+// the test steps (hostClock_*), ESP.getCycleCount() on steady_clock
+
+#ifndef ARDUINO_H_HOST_SHIM
+#define ARDUINO_H_HOST_SHIM
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#define IRAM_ATTR
+
+#define HOST_CPU_MHZ  240   // What getCpuFrequencyMhz() reports (ESP32 default)
+
+class HostSerial {
+public:
+  int printf(const char* format, ...) __attribute__((format(printf, 2, 3)));
+  size_t print(const char* s);
+  size_t println(const char* s = "");
+};
+
+class HostEsp {
+public:
+  uint32_t getCycleCount();   // HOST_CPU_MHZ cycles per microsecond of host time
+};
+
+extern HostSerial Serial;
+extern HostEsp ESP;
+
+uint32_t micros();
+uint32_t millis();
+uint32_t getCpuFrequencyMhz();
+
+// Host only: the micros() / millis() clock. Scripts step it by exactly one block, so the
+// engine's throttle smoothing sees the same intervals on every run
+void hostClock_set(uint32_t us);
+void hostClock_advance(uint32_t us);
+
+#endif // ARDUINO_H_HOST_SHIM
@@ -0,0 +1,49 @@
+// esp_partition.h (host shim)
+// The "engine" data partition, backed by a bank image the test loads into memory
+// (hostPartition_load) instead of flash
+
+#ifndef ESP_PARTITION_H_HOST_SHIM
+#define ESP_PARTITION_H_HOST_SHIM
+
+#include <stdint.h>
+#include <stddef.h>
+
+typedef int esp_err_t;
+#define ESP_OK                 0
+#define ESP_ERR_NOT_FOUND      0x105
+#define ESP_ERR_INVALID_SIZE   0x104
+
+typedef enum {
+  ESP_PARTITION_TYPE_APP = 0x00,
+  ESP_PARTITION_TYPE_DATA = 0x01,
+} esp_partition_type_t;
+
+typedef int esp_partition_subtype_t;
+
+typedef enum {
+  ESP_PARTITION_MMAP_DATA,
+  ESP_PARTITION_MMAP_INST,
+} esp_partition_mmap_memory_t;
+
+typedef uint32_t esp_partition_mmap_handle_t;
+
+typedef struct {
+  esp_partition_type_t type;
+  esp_partition_subtype_t subtype;
+  uint32_t address;
+  uint32_t size;
+  char label[17];
+} esp_partition_t;
+
+const esp_partition_t* esp_partition_find_first(esp_partition_type_t type,
+                                                esp_partition_subtype_t subtype, const char* label);
+esp_err_t esp_partition_mmap(const esp_partition_t* partition, size_t offset, size_t size,
+                             esp_partition_mmap_memory_t memory, const void** out_ptr,
+                             esp_partition_mmap_handle_t* out_handle);
+void esp_partition_munmap(esp_partition_mmap_handle_t handle);
+
+// Host only: back the "engine" data partition with this image (NULL = no partition).
+// The caller keeps the data alive.
+void hostPartition_load(const uint8_t* data, size_t size);
+
+#endif // ESP_PARTITION_H_HOST_SHIM
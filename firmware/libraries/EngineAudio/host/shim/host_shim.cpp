@@ -0,0 +1,89 @@
+// host_shim.cpp
+// Host implementations behind Arduino.h and esp_partition.h
+
+#include "Arduino.h"
+#include "esp_partition.h"
+#include <stdarg.h>
+#include <chrono>
+
+HostSerial Serial;
+HostEsp ESP;
+
+// ==================== ARDUINO ====================
+int HostSerial::printf(const char* format, ...) {
+  va_list args;
+  va_start(args, format);
+  int n = vprintf(format, args);
+  va_end(args);
+  return n;
+}
+
+size_t HostSerial::print(const char* s) {
+  return fputs(s, stdout) < 0 ? 0 : strlen(s);
+}
+
+size_t HostSerial::println(const char* s) {
+  size_t n = print(s);
+  fputc('\n', stdout);
+  return n + 1;
+}
+
+static uint32_t clockUs = 0;
+
+void hostClock_set(uint32_t us) {
+  clockUs = us;
+}
+
+void hostClock_advance(uint32_t us) {
+  clockUs += us;
+}
+
+uint32_t HostEsp::getCycleCount() {
+  static const auto start = std::chrono::steady_clock::now();
+  uint64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+    std::chrono::steady_clock::now() - start).count();
+  return (uint32_t)(ns * HOST_CPU_MHZ / 1000);
+}
+
+uint32_t micros() {
+  return clockUs;
+}
+
+uint32_t millis() {
+  return clockUs / 1000;
+}
+
+uint32_t getCpuFrequencyMhz() {
+  return HOST_CPU_MHZ;
+}
+
+// ==================== ESP_PARTITION ====================
+static esp_partition_t enginePartition = { ESP_PARTITION_TYPE_DATA, 0x40, 0, 0, "engine" };
+static const uint8_t* partitionData = NULL;
+
+void hostPartition_load(const uint8_t* data, size_t size) {
+  partitionData = data;
+  enginePartition.size = (uint32_t)size;
+}
+
+const esp_partition_t* esp_partition_find_first(esp_partition_type_t type,
+                                                esp_partition_subtype_t subtype, const char* label) {
+  if (!partitionData || type != enginePartition.type || subtype != enginePartition.subtype) return NULL;
+  if (label && strcmp(label, enginePartition.label) != 0) return NULL;
+  return &enginePartition;
+}
+
+esp_err_t esp_partition_mmap(const esp_partition_t* partition, size_t offset, size_t size,
+                             esp_partition_mmap_memory_t memory, const void** out_ptr,
+                             esp_partition_mmap_handle_t* out_handle) {
+  (void)memory;
+  if (partition != &enginePartition || !partitionData) return ESP_ERR_NOT_FOUND;
+  if (offset + size > partition->size) return ESP_ERR_INVALID_SIZE;
+  *out_ptr = partitionData + offset;
+  *out_handle = 1;
+  return ESP_OK;
+}
+
+void esp_partition_munmap(esp_partition_mmap_handle_t handle) {
+  (void)handle;
+}
@@ -0,0 +1,946 @@
+// audio_engine.cpp
+// Implementation of real-time engine audio sampler
+// Uses FFT-filtered PCM data (offline processing) for click-free looping
+// Samples come from the flash engine bank (see engine_bank.h)
+
+#include "audio_engine.h"
+#include <Arduino.h>
+
+// Global engine state
+EngineAudioState engineState;
+
+// Bounded lock-free command queue (Vyukov): each slot's sequence number says whether
+// it is free for the producer at that position or filled for the consumer
+typedef struct {
+  std::atomic<uint32_t> sequence;
+  EngineCommand cmd;
+} EngineCommandSlot;
+
+static EngineCommandSlot cmdSlots[ENGINE_CMD_QUEUE_SIZE];
+static std::atomic<uint32_t> cmdEnqueuePos(0);
+static uint32_t cmdDequeuePos = 0;            // Audio task only
+static std::atomic<uint32_t> cmdDropped(0);
+
+static void publishTelemetry(bool block_rendered);
+
+// Latest posted throttle, Q16 (65536 = full) so an ISR can post it without the FPU
+static std::atomic<uint32_t> throttleInputQ16(0);
+
+// Telemetry snapshot under a sequence lock (odd sequence = write in progress)
+static std::atomic<uint32_t> telemetrySeq(0);
+static EngineTelemetry telemetrySnapshot;
+
+// Active render kernel: switched by the audio task between blocks, read by anyone
+static std::atomic<uint8_t> activeKernel(AUDIO_RENDER_KERNEL);
+static uint8_t renderKernel = AUDIO_RENDER_KERNEL;   // Audio task copy
+
+// Benchmark: simulated clock while a script runs, result under its own sequence lock
+static std::atomic<bool> benchRequested(false);
+static bool benchRunning = false;             // Audio task only
+static uint32_t benchNowUs = 0;
+static std::atomic<uint32_t> benchSeq(0);
+static EngineBenchResult benchResult;
+
+// Linear interpolation helper (audioLerp to avoid std::lerp conflict)
+static inline float audioLerp(float a, float b, float t) {
+  return a + (b - a) * t;
+}
+
+// Soft clip using tanh - prevents harsh clipping artifacts
+static inline float softClip(float x) {
+  const float max_val = 32767.0f;
+  const float k = 2.0f;
+  float normalized = x / max_val;
+  return (tanh(k * normalized) / tanh(k)) * max_val;
+}
+
+// Fixed kernel soft clip: same tanh curve sampled into a table over |x| = 0..65536
+// (2x full scale covers the worst rev-boosted gain). Output is clamped to int16.
+#define SOFT_CLIP_LUT_SIZE   (1 << SOFT_CLIP_LUT_BITS)
+#define SOFT_CLIP_LUT_SHIFT  (16 - SOFT_CLIP_LUT_BITS)
+static int16_t softClipLut[SOFT_CLIP_LUT_SIZE + 1];
+
+static void buildSoftClipLut() {
+  for (int i = 0; i <= SOFT_CLIP_LUT_SIZE; i++) {
+    float y = softClip((float)(i << SOFT_CLIP_LUT_SHIFT));
+    softClipLut[i] = (int16_t)(y > 32767.0f ? 32767.0f : y);
+  }
+}
+
+static inline int16_t softClipFixed(int32_t x) {
+  int32_t a = x < 0 ? -x : x;
+  int32_t y;
+  if (a >= 65536) {
+    y = softClipLut[SOFT_CLIP_LUT_SIZE];
+  } else {
+    int32_t i = a >> SOFT_CLIP_LUT_SHIFT;
+    int32_t f = a & ((1 << SOFT_CLIP_LUT_SHIFT) - 1);
+    int32_t y0 = softClipLut[i];
+    y = y0 + (((softClipLut[i + 1] - y0) * f) >> SOFT_CLIP_LUT_SHIFT);
+  }
+  return (int16_t)(x < 0 ? -y : y);
+}
+
+// Sample readers: render kernels are instantiated once per bank encoding
+struct Pcm16Reader {
+  const int16_t* data;
+  inline int32_t operator()(uint32_t i) const { return data[i]; }
+};
+
+struct UlawReader {
+  const uint8_t* data;
+  inline int32_t operator()(uint32_t i) const { return ENGINE_ULAW_TABLE[data[i]]; }
+};
+
+static inline uint32_t startupFadeLength() {
+  return engineState.sample_rate * START_FADE_MS / 1000;
+}
+
+// Reset a layer's playback position and point it at a bank sample
+static bool loadLayer(EngineLayer* layer, int index) {
+  EngineSample sample;
+  if (!engineBank_get(index, &sample)) {
+    return false;
+  }
+  layer->pcm_data = sample.data;
+  layer->pcm_length = sample.length;
+  layer->pcm_format = sample.format;
+  layer->sample_index = index;
+  layer->throttle_point = sample.throttle;
+  layer->nominal_rate = 1.0f;
+  layer->rate_scale = (float)sample.sample_rate / engineState.sample_rate;
+  layer->weight = 0.0f;
+  layer->render_weight = 0.0f;
+  layer->position = 0.0f;
+  layer->phase_index = 0;
+  layer->phase_frac = 0;
+  return true;
+}
+
+// Equal-power crossfade between the two layers around the smoothed throttle
+// (layers are separate recordings/phases, so a linear fade would dip in the middle)
+static void updateLayerWeights(float throttle) {
+  const int count = engineState.layer_count;
+  if (count < 2) {
+    return;
+  }
+  EngineLayer* layers = engineState.layers;
+  for (int i = 0; i < count; i++) {
+    layers[i].weight = 0.0f;
+  }
+  if (throttle <= layers[0].throttle_point) {
+    layers[0].weight = 1.0f;
+    return;
+  }
+  for (int i = 0; i < count - 1; i++) {
+    float lo = layers[i].throttle_point;
+    float hi = layers[i + 1].throttle_point;
+    if (throttle < hi) {
+      float x = (hi > lo) ? (throttle - lo) / (hi - lo) : 1.0f;
+      layers[i].weight = cosf(x * (float)M_PI_2);
+      layers[i + 1].weight = sinf(x * (float)M_PI_2);
+      return;
+    }
+  }
+  layers[count - 1].weight = 1.0f;
+}
+
+// Initialize audio engine
+void audioEngine_init(uint32_t sample_rate) {
+  if (sample_rate < AUDIO_RATE_MIN || sample_rate > AUDIO_RATE_MAX) {
+    Serial.printf("ERROR: Unsupported audio rate %lu Hz - using %d Hz\n", (unsigned long)sample_rate, AUDIO_RATE_FULL);
+    sample_rate = AUDIO_RATE_FULL;
+  }
+  engineState.sample_rate = sample_rate;
+  engineState.rate = RATE_MIN;
+  engineState.gain = GAIN_MIN;
+  engineState.render_rate = RATE_MIN;
+  engineState.render_gain = GAIN_MIN;
+  engineState.smoothed_throttle = 0.0f;
+  engineState.prev_throttle = 0.0f;
+  engineState.rev_timer_ms = 0.0f;
+  engineState.last_update_us = micros();
+  engineState.startup_fade_remaining = startupFadeLength();
+  engineState.layer_count = 0;
+  engineState.cycles_per_sample = 0;
+  engineState.cycles_per_sample_peak = 0;
+  engineState.muted = false;
+  for (int i = 0; i < ENGINE_MAX_VOICES; i++) {
+    engineState.voices[i].sample_index = -1;
+  }
+  buildSoftClipLut();
+  
+  for (uint32_t i = 0; i < ENGINE_CMD_QUEUE_SIZE; i++) {
+    cmdSlots[i].sequence.store(i, std::memory_order_relaxed);
+  }
+  cmdEnqueuePos.store(0, std::memory_order_relaxed);
+  cmdDequeuePos = 0;
+  audioEngine_postThrottle(0.0f);
+  
+  // Prefer RPM layers; fall back to the "engine" loop (else the first loop in the bank)
+  bool loaded = false;
+  if (engineBank_init()) {
+    loaded = audioEngine_loadLayers();
+    if (!loaded) {
+      int index = engineBank_find("engine");
+      for (int i = 0; index < 0 && i < engineBank_count(); i++) {
+        EngineSample sample;
+        if (engineBank_get(i, &sample) && sample.kind == ENGINE_KIND_LOOP) index = i;
+      }
+      loaded = index >= 0 && audioEngine_setSample(index);
+    }
+  }
+  if (!loaded) {
+    Serial.println("ERROR: No engine sample available - engine audio will be silent");
+  }
+  
+  Serial.println("Audio engine initialized (FFT-filtered loop)");
+  for (int i = 0; i < engineState.layer_count; i++) {
+    EngineSample sample;
+    if (engineBank_get(engineState.layers[i].sample_index, &sample)) {
+      Serial.printf("  %s: %lu samples (%.2fs @ %lu Hz, %s)\n",
+        engineState.layer_count > 1 ? "Layer" : "Loop",
+        (unsigned long)sample.length,
+        (float)sample.length / sample.sample_rate,
+        (unsigned long)sample.sample_rate,
+        engineBank_source());
+      if (sample.sample_rate != engineState.sample_rate) {
+        Serial.printf("    Resampled to %lu Hz (rebuild the bank at that rate to save CPU and flash)\n",
+          (unsigned long)engineState.sample_rate);
+      }
+    }
+  }
+  Serial.printf("  Output rate: %lu Hz\n", (unsigned long)engineState.sample_rate);
+  Serial.printf("  Rate range: %.2f - %.2f\n", RATE_MIN, RATE_MAX);
+  Serial.printf("  Gain range: %.2f - %.2f\n", GAIN_MIN, GAIN_MAX);
+  Serial.printf("  Render kernel: %s\n", audioEngine_getKernelName());
+  publishTelemetry(false);
+}
+
+// Play a single bank sample as the engine loop (restarts with a fade-in)
+// Call from the audio task or before it starts
+bool audioEngine_setSample(int index) {
+  if (!loadLayer(&engineState.layers[0], index)) {
+    return false;
+  }
+  engineState.layers[0].weight = 1.0f;
+  engineState.layers[0].render_weight = 1.0f;
+  engineState.layer_count = 1;
+  engineState.startup_fade_remaining = startupFadeLength();
+  return true;
+}
+
+// Load RPM layers from the bank, sorted by throttle point
+// Each layer's nominal rate is where its throttle point sits on the RATE_MIN..RATE_MAX map,
+// so a layer recorded (or derived) at that pitch plays at ~1.0 around its point
+bool audioEngine_loadLayers() {
+  uint8_t count = 0;
+  for (int i = 0; i < engineBank_count() && count < ENGINE_MAX_LAYERS; i++) {
+    EngineSample sample;
+    if (!engineBank_get(i, &sample) || sample.kind != ENGINE_KIND_LAYER) continue;
+    if (!loadLayer(&engineState.layers[count], i)) continue;
+    
+    // Insertion sort by throttle point
+    EngineLayer added = engineState.layers[count];
+    int j = count;
+    while (j > 0 && engineState.layers[j - 1].throttle_point > added.throttle_point) {
+      engineState.layers[j] = engineState.layers[j - 1];
+      j--;
+    }
+    engineState.layers[j] = added;
+    count++;
+  }
+  if (count < 2) {
+    return false;
+  }
+  
+  for (int i = 0; i < count; i++) {
+    EngineLayer* layer = &engineState.layers[i];
+    layer->nominal_rate = RATE_MIN + layer->throttle_point * (RATE_MAX - RATE_MIN);
+  }
+  engineState.layer_count = count;
+  engineState.startup_fade_remaining = startupFadeLength();
+  updateLayerWeights(engineState.smoothed_throttle);
+  for (int i = 0; i < count; i++) {
+    engineState.layers[i].render_weight = engineState.layers[i].weight;
+  }
+  return true;
+}
+
+// Mute control functions
+bool audioEngine_setMuted(bool muted) {
+  EngineCommand cmd = { ENGINE_CMD_MUTE, 0, muted ? 1 : 0 };
+  bool queued = audioEngine_postCommand(cmd);
+  Serial.printf("Engine audio %s%s\n", muted ? "MUTED" : "UNMUTED", queued ? "" : " (queue full, dropped)");
+  return queued;
+}
+
+bool audioEngine_getMuted() {
+  EngineTelemetry t;
+  audioEngine_getTelemetry(&t);
+  return t.muted;
+}
+
+// ==================== ONE-SHOT EFFECTS ====================
+int audioEngine_findVoice(const char* name) {
+  int index = engineBank_find(name);
+  EngineSample sample;
+  if (index < 0 || !engineBank_get(index, &sample) || sample.kind != ENGINE_KIND_ONESHOT) {
+    return -1;
+  }
+  // One-shots play 1:1, so one recorded at another rate would play off-pitch
+  if (sample.sample_rate != engineState.sample_rate) {
+    Serial.printf("✗ One-shot '%s' is %lu Hz, output is %lu Hz - not used\n",
+      name, (unsigned long)sample.sample_rate, (unsigned long)engineState.sample_rate);
+    return -1;
+  }
+  return index;
+}
+
+bool audioEngine_playVoice(int index, uint8_t level_percent) {
+  if (index < 0) return false;
+  EngineCommand cmd = { ENGINE_CMD_PLAY_VOICE, level_percent, index };
+  return audioEngine_postCommand(cmd);
+}
+
+bool audioEngine_stopVoices() {
+  EngineCommand cmd = { ENGINE_CMD_STOP_VOICES, 0, 0 };
+  return audioEngine_postCommand(cmd);
+}
+
+// Audio task: a repeated effect restarts its voice (a held horn button doesn't stack
+// copies), otherwise take a free voice or replace the one closest to its end
+static void startVoice(int index, uint8_t level_percent) {
+  EngineSample sample;
+  if (!engineBank_get(index, &sample) || sample.kind != ENGINE_KIND_ONESHOT) return;
+
+  EngineVoice* voice = NULL;
+  for (int i = 0; i < ENGINE_MAX_VOICES && !voice; i++) {
+    if (engineState.voices[i].sample_index == index) voice = &engineState.voices[i];
+  }
+  for (int i = 0; i < ENGINE_MAX_VOICES && !voice; i++) {
+    if (engineState.voices[i].sample_index < 0) voice = &engineState.voices[i];
+  }
+  if (!voice) {
+    voice = &engineState.voices[0];
+    for (int i = 1; i < ENGINE_MAX_VOICES; i++) {
+      EngineVoice* v = &engineState.voices[i];
+      if (v->pcm_length - v->position < voice->pcm_length - voice->position) voice = v;
+    }
+  }
+
+  voice->pcm_data = sample.data;
+  voice->pcm_length = sample.length;
+  voice->pcm_format = sample.format;
+  voice->sample_index = index;
+  voice->position = 0;
+  voice->gain = (level_percent > 100 ? 100 : level_percent) / 100.0f;
+}
+
+static uint8_t activeVoiceCount() {
+  uint8_t n = 0;
+  for (int i = 0; i < ENGINE_MAX_VOICES; i++) {
+    if (engineState.voices[i].sample_index >= 0) n++;
+  }
+  return n;
+}
+
+// ==================== CONTROL / TELEMETRY HANDOFF ====================
+void audioEngine_postThrottle(float throttle_normalized) {
+  float clamped = throttle_normalized < 0.0f ? 0.0f : (throttle_normalized > 1.0f ? 1.0f : throttle_normalized);
+  audioEngine_postThrottleQ16((uint32_t)(clamped * 65536.0f + 0.5f));
+}
+
+void IRAM_ATTR audioEngine_postThrottleQ16(uint32_t throttle_q16) {
+  if (throttle_q16 > 65536) throttle_q16 = 65536;
+  throttleInputQ16.store(throttle_q16, std::memory_order_relaxed);
+}
+
+static float loadThrottleInput() {
+  return throttleInputQ16.load(std::memory_order_relaxed) * (1.0f / 65536.0f);
+}
+
+bool audioEngine_postCommand(const EngineCommand& cmd) {
+  uint32_t pos = cmdEnqueuePos.load(std::memory_order_relaxed);
+  for (;;) {
+    EngineCommandSlot* slot = &cmdSlots[pos & (ENGINE_CMD_QUEUE_SIZE - 1)];
+    uint32_t seq = slot->sequence.load(std::memory_order_acquire);
+    int32_t diff = (int32_t)(seq - pos);
+    if (diff == 0) {
+      // Slot is free at this position: claim it
+      if (cmdEnqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+        slot->cmd = cmd;
+        slot->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+      }
+    } else if (diff < 0) {
+      // Consumer hasn't freed this slot yet: queue full
+      cmdDropped.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    } else {
+      pos = cmdEnqueuePos.load(std::memory_order_relaxed);
+    }
+  }
+}
+
+// Carry each layer's playback position over to the other kernel's phase format,
+// so an A/B switch continues the loop where it was instead of restarting it
+static void switchKernel(uint8_t kernel) {
+  if (kernel > AUDIO_KERNEL_FIXED || kernel == renderKernel) return;
+  for (int l = 0; l < engineState.layer_count; l++) {
+    EngineLayer* layer = &engineState.layers[l];
+    if (kernel == AUDIO_KERNEL_FIXED) {
+      uint32_t idx = (uint32_t)layer->position;
+      uint32_t frac = (uint32_t)((layer->position - (float)idx) * 65536.0f);
+      while (idx >= layer->pcm_length) idx -= layer->pcm_length;  // Float kernel wraps lazily
+      layer->phase_index = idx;
+      layer->phase_frac = frac & 0xFFFF;
+    } else {
+      layer->position = (float)layer->phase_index + layer->phase_frac / 65536.0f;
+    }
+  }
+  renderKernel = kernel;
+  activeKernel.store(kernel, std::memory_order_relaxed);
+  engineState.cycles_per_sample_peak = 0;  // The peak belongs to one kernel
+  Serial.printf("Render kernel: %s\n", audioEngine_getKernelName());
+}
+
+bool audioEngine_setKernel(uint8_t kernel) {
+  EngineCommand cmd = { ENGINE_CMD_SET_KERNEL, 0, kernel };
+  return audioEngine_postCommand(cmd);
+}
+
+uint8_t audioEngine_getKernel() {
+  return activeKernel.load(std::memory_order_relaxed);
+}
+
+const char* audioEngine_getKernelName() {
+  return audioEngine_getKernel() == AUDIO_KERNEL_FIXED ? "fixed" : "float";
+}
+
+static void applyCommand(const EngineCommand& cmd) {
+  switch (cmd.type) {
+    case ENGINE_CMD_MUTE:
+      engineState.muted = cmd.arg != 0;
+      break;
+    case ENGINE_CMD_PLAY_VOICE:
+      startVoice(cmd.arg, cmd.level);
+      break;
+    case ENGINE_CMD_STOP_VOICES:
+      for (int i = 0; i < ENGINE_MAX_VOICES; i++) {
+        engineState.voices[i].sample_index = -1;
+      }
+      break;
+    case ENGINE_CMD_SET_KERNEL:
+      switchKernel((uint8_t)cmd.arg);
+      break;
+    default:
+      break;
+  }
+}
+
+void audioEngine_processControl() {
+  for (;;) {
+    EngineCommandSlot* slot = &cmdSlots[cmdDequeuePos & (ENGINE_CMD_QUEUE_SIZE - 1)];
+    uint32_t seq = slot->sequence.load(std::memory_order_acquire);
+    if (seq != cmdDequeuePos + 1) break;  // Nothing filled at this position
+    EngineCommand cmd = slot->cmd;
+    slot->sequence.store(cmdDequeuePos + ENGINE_CMD_QUEUE_SIZE, std::memory_order_release);
+    cmdDequeuePos++;
+    applyCommand(cmd);
+  }
+  audioEngine_updateThrottle(loadThrottleInput());
+}
+
+// Audio task: publish the snapshot (writer side of the sequence lock)
+static void publishTelemetry(bool block_rendered) {
+  if (benchRunning) return;  // Readers keep seeing the real engine
+  uint32_t seq = telemetrySeq.load(std::memory_order_relaxed);
+  telemetrySeq.store(seq + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  
+  EngineTelemetry* t = &telemetrySnapshot;
+  t->throttle_input = loadThrottleInput();
+  t->smoothed_throttle = engineState.smoothed_throttle;
+  t->rate = engineState.rate;
+  t->gain = engineState.gain;
+  t->rev_active = engineState.rev_timer_ms > 0.0f;
+  t->muted = engineState.muted;
+  t->layer_count = engineState.layer_count;
+  t->voices_active = activeVoiceCount();
+  t->sample_index = engineState.layer_count ? engineState.layers[0].sample_index : -1;
+  t->cycles_per_sample = engineState.cycles_per_sample;
+  t->cycles_per_sample_peak = engineState.cycles_per_sample_peak;
+  if (block_rendered) t->blocks_rendered++;
+  t->commands_dropped = cmdDropped.load(std::memory_order_relaxed);
+  t->sample_rate = engineState.sample_rate;
+  
+  telemetrySeq.store(seq + 2, std::memory_order_release);
+}
+
+void audioEngine_getTelemetry(EngineTelemetry* out) {
+  for (;;) {
+    uint32_t before = telemetrySeq.load(std::memory_order_acquire);
+    if (before & 1) continue;  // Writer mid-update
+    *out = telemetrySnapshot;
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (telemetrySeq.load(std::memory_order_relaxed) == before) return;
+  }
+}
+
+// Update throttle and recalculate rate/gain
+void audioEngine_updateThrottle(float throttle_normalized) {
+  // Clamp input
+  if (throttle_normalized < 0.0f) throttle_normalized = 0.0f;
+  if (throttle_normalized > 1.0f) throttle_normalized = 1.0f;
+  
+  // Calculate time delta for decay and smoothing (microsecond clock: updates are ~3 ms apart)
+  uint32_t current_us = benchRunning ? benchNowUs : micros();
+  float delta_ms = (current_us - engineState.last_update_us) / 1000.0f;
+  engineState.last_update_us = current_us;
+  
+  // Detect rev transient (rapid throttle increase)
+  float throttle_delta = throttle_normalized - engineState.prev_throttle;
+  if (throttle_delta > REV_THRESHOLD) {
+    engineState.rev_timer_ms = REV_DECAY_MS + REV_RAMP_MS;
+  }
+  engineState.prev_throttle = throttle_normalized;
+  
+  // Decay rev timer
+  if (engineState.rev_timer_ms > 0.0f) {
+    if (delta_ms >= engineState.rev_timer_ms) {
+      engineState.rev_timer_ms = 0.0f;
+    } else {
+      engineState.rev_timer_ms -= delta_ms;
+    }
+  }
+  
+  // Apply faster smoothing during rev transient for more responsive feel
+  float smooth_tau_ms = THROTTLE_SMOOTH_TAU_MS;
+  if (engineState.rev_timer_ms > 0.0f) {
+    smooth_tau_ms = REV_SMOOTH_TAU_MS;  // Much faster response during rev
+  }
+  
+  // Exponential smoothing against real time, so feel doesn't depend on block size
+  // (boat-like inertia, faster during rev)
+  float smooth_alpha = 1.0f - expf(-delta_ms / smooth_tau_ms);
+  engineState.smoothed_throttle = 
+    engineState.smoothed_throttle * (1.0f - smooth_alpha) +
+    throttle_normalized * smooth_alpha;
+  
+  // Calculate base rate and gain from smoothed throttle
+  float base_rate = RATE_MIN + engineState.smoothed_throttle * (RATE_MAX - RATE_MIN);
+  float base_gain = GAIN_MIN + engineState.smoothed_throttle * (GAIN_MAX - GAIN_MIN);
+  
+  // Apply rev boost if active (ramp-in then decay for realistic effect)
+  if (engineState.rev_timer_ms > 0.0f) {
+    float total_time = REV_DECAY_MS + REV_RAMP_MS;
+    float rev_elapsed = total_time - engineState.rev_timer_ms;
+    
+    float rev_amount = 0.0f;
+    if (rev_elapsed < REV_RAMP_MS) {
+      // Ramp-in phase: smoothly increase rev effect
+      rev_amount = rev_elapsed / REV_RAMP_MS;
+    } else {
+      // Decay phase: gradually fade rev effect
+      float decay_elapsed = rev_elapsed - REV_RAMP_MS;
+      rev_amount = 1.0f - (decay_elapsed / REV_DECAY_MS);
+    }
+    
+    base_rate *= 1.0f + (REV_BOOST_RATE - 1.0f) * rev_amount;
+    base_gain *= 1.0f + (REV_BOOST_GAIN - 1.0f) * rev_amount;
+  }
+  
+  // Update state
+  engineState.rate = base_rate;
+  engineState.gain = base_gain;
+  updateLayerWeights(engineState.smoothed_throttle);
+}
+
+// Layers are accumulated into a mix buffer, then faded in and soft clipped in one pass.
+// Each layer ramps its own rate (engine rate / nominal rate) and gain (engine gain x
+// crossfade weight) from the previous block's values. Only the active kernel uses
+// the mix buffer, so both share it.
+static union {
+  float f[AUDIO_MAX_BLOCK_SAMPLES];
+  int32_t i[AUDIO_MAX_BLOCK_SAMPLES];
+} mixBuffer;
+
+// Reference kernel: float position, float lerp, tanh soft clip
+template <typename Reader>
+static void accumulateFloat(size_t count, Reader pcm, EngineLayer* layer,
+                            float rate, float rate_end, float gain, float gain_end) {
+  const uint32_t length = layer->pcm_length;
+  const float rate_step = (rate_end - rate) / count;
+  const float gain_step = (gain_end - gain) / count;
+  float position = layer->position;
+
+  for (size_t i = 0; i < count; i++) {
+    // Get integer and fractional parts of position
+    uint32_t idx = (uint32_t)position;
+    float frac = position - (float)idx;
+    
+    // Simple wrap (FFT filtering ensures periodic continuity)
+    if (idx >= length) {
+      position = frac;
+      idx = 0;
+    }
+    
+    // Get current and next samples for interpolation
+    int32_t sample0 = pcm(idx);
+    int32_t sample1 = pcm((idx + 1) % length);
+    
+    // Linear interpolation for smooth pitch shifting, then gain
+    mixBuffer.f[i] += audioLerp((float)sample0, (float)sample1, frac) * gain;
+    
+    // Advance position by playback rate
+    position += rate;
+    rate += rate_step;
+    gain += gain_step;
+  }
+
+  layer->position = position;
+}
+
+// One-shot voice: 1:1 rate, fixed gain, stops at the end of the sample
+template <typename Reader>
+static void accumulateVoiceFloat(size_t count, Reader pcm, EngineVoice* voice) {
+  uint32_t remaining = voice->pcm_length - voice->position;
+  size_t n = count < remaining ? count : remaining;
+  const float gain = voice->gain;
+  for (size_t i = 0; i < n; i++) {
+    mixBuffer.f[i] += (float)pcm(voice->position + i) * gain;
+  }
+  voice->position += n;
+}
+
+static void outputFloat(int16_t* buffer, size_t count) {
+  for (size_t i = 0; i < count; i++) {
+    float sample = mixBuffer.f[i];
+    
+    // Startup fade-in to prevent initial pop
+    if (engineState.startup_fade_remaining > 0) {
+      float progress = 1.0f - ((float)engineState.startup_fade_remaining / startupFadeLength());
+      sample *= progress;
+      engineState.startup_fade_remaining--;
+    }
+    
+    // Soft clip to prevent harsh distortion (the curve passes full scale past |x| = 32767)
+    float y = softClip(sample);
+    buffer[i] = (int16_t)(y > 32767.0f ? 32767.0f : (y < -32767.0f ? -32767.0f : y));
+  }
+}
+
+// Fixed-point kernel: Q16.16 phase increment, integer lerp and gain, table soft clip.
+// Loops are longer than 65535 samples, so the accumulator keeps a full 32-bit
+// integer index and carries the Q16 fraction into it. Rate and gain ramps are
+// held with 8 extra bits (Q24 increment, Q22 gain) so small per-sample steps
+// don't truncate to zero.
+template <typename Reader>
+static void accumulateFixed(size_t count, Reader pcm, EngineLayer* layer,
+                            float rate, float rate_end, float gain, float gain_end) {
+  const uint32_t length = layer->pcm_length;
+  int32_t increment_q24 = (int32_t)(rate * 16777216.0f);
+  int32_t gain_q22 = (int32_t)(gain * 4194304.0f);
+  const int32_t increment_step = ((int32_t)(rate_end * 16777216.0f) - increment_q24) / (int32_t)count;
+  const int32_t gain_step = ((int32_t)(gain_end * 4194304.0f) - gain_q22) / (int32_t)count;
+  uint32_t idx = layer->phase_index;
+  uint32_t frac = layer->phase_frac;
+
+  for (size_t i = 0; i < count; i++) {
+    uint32_t next = idx + 1;
+    if (next >= length) next = 0;
+
+    // Lerp with 15-bit fraction so (s1 - s0) * frac fits in int32
+    int32_t s0 = pcm(idx);
+    int32_t s1 = pcm(next);
+    int32_t sample = s0 + (((s1 - s0) * (int32_t)(frac >> 1)) >> 15);
+    mixBuffer.i[i] += (sample * (gain_q22 >> 8)) >> 14;
+
+    // Advance phase and wrap (subtract instead of modulo)
+    frac += (uint32_t)increment_q24 >> 8;
+    increment_q24 += increment_step;
+    gain_q22 += gain_step;
+    idx += frac >> 16;
+    frac &= 0xFFFF;
+    while (idx >= length) idx -= length;
+  }
+
+  layer->phase_index = idx;
+  layer->phase_frac = frac;
+}
+
+// One-shot voice: 1:1 rate, Q15 gain, stops at the end of the sample
+template <typename Reader>
+static void accumulateVoiceFixed(size_t count, Reader pcm, EngineVoice* voice) {
+  uint32_t remaining = voice->pcm_length - voice->position;
+  size_t n = count < remaining ? count : remaining;
+  const int32_t gain_q15 = (int32_t)(voice->gain * 32768.0f);
+  for (size_t i = 0; i < n; i++) {
+    mixBuffer.i[i] += (pcm(voice->position + i) * gain_q15) >> 15;
+  }
+  voice->position += n;
+}
+
+static void outputFixed(int16_t* buffer, size_t count) {
+  for (size_t i = 0; i < count; i++) {
+    int32_t sample = mixBuffer.i[i];
+
+    // Startup fade-in (reciprocal multiply, no per-sample divide)
+    if (engineState.startup_fade_remaining > 0) {
+      const uint32_t fade_len = startupFadeLength();
+      const uint32_t step_q24 = (1u << 24) / fade_len;
+      uint32_t progress_q24 = (fade_len - engineState.startup_fade_remaining) * step_q24;
+      sample = (int32_t)(((int64_t)sample * progress_q24) >> 24);
+      engineState.startup_fade_remaining--;
+    }
+
+    buffer[i] = softClipFixed(sample);
+  }
+}
+
+// Sum the playing one-shots into the mix buffer (before fade-in and soft clip)
+static void mixVoices(size_t count, uint8_t kernel) {
+  for (int v = 0; v < ENGINE_MAX_VOICES; v++) {
+    EngineVoice* voice = &engineState.voices[v];
+    if (voice->sample_index < 0) continue;
+    bool ulaw = voice->pcm_format == ENGINE_FORMAT_ULAW;
+    if (kernel == AUDIO_KERNEL_FLOAT) {
+      if (ulaw) accumulateVoiceFloat(count, UlawReader{(const uint8_t*)voice->pcm_data}, voice);
+      else accumulateVoiceFloat(count, Pcm16Reader{(const int16_t*)voice->pcm_data}, voice);
+    } else {
+      if (ulaw) accumulateVoiceFixed(count, UlawReader{(const uint8_t*)voice->pcm_data}, voice);
+      else accumulateVoiceFixed(count, Pcm16Reader{(const int16_t*)voice->pcm_data}, voice);
+    }
+    if (voice->position >= voice->pcm_length) voice->sample_index = -1;
+  }
+}
+
+// Render one block of at most AUDIO_MAX_BLOCK_SAMPLES
+// engine_on = false renders the effects alone (engine muted or no loop loaded)
+static void renderBlock(int16_t* buffer, size_t count, bool engine_on) {
+  const uint8_t kernel = renderKernel;
+  for (size_t i = 0; i < count; i++) {
+    if (kernel == AUDIO_KERNEL_FLOAT) mixBuffer.f[i] = 0.0f;
+    else mixBuffer.i[i] = 0;
+  }
+
+  for (int l = 0; engine_on && l < engineState.layer_count; l++) {
+    EngineLayer* layer = &engineState.layers[l];
+    // Skip layers that are silent for the whole block (their phase holds)
+    if (layer->render_weight <= 0.0f && layer->weight <= 0.0f) continue;
+
+    const float scale = layer->rate_scale / layer->nominal_rate;
+    float rate = engineState.render_rate * scale;
+    float rate_end = engineState.rate * scale;
+    float gain = engineState.render_gain * layer->render_weight;
+    float gain_end = engineState.gain * layer->weight;
+    bool ulaw = layer->pcm_format == ENGINE_FORMAT_ULAW;
+    if (kernel == AUDIO_KERNEL_FLOAT) {
+      if (ulaw) accumulateFloat(count, UlawReader{(const uint8_t*)layer->pcm_data}, layer, rate, rate_end, gain, gain_end);
+      else accumulateFloat(count, Pcm16Reader{(const int16_t*)layer->pcm_data}, layer, rate, rate_end, gain, gain_end);
+    } else {
+      if (ulaw) accumulateFixed(count, UlawReader{(const uint8_t*)layer->pcm_data}, layer, rate, rate_end, gain, gain_end);
+      else accumulateFixed(count, Pcm16Reader{(const int16_t*)layer->pcm_data}, layer, rate, rate_end, gain, gain_end);
+    }
+    layer->render_weight = layer->weight;
+  }
+
+  mixVoices(count, kernel);
+
+  if (kernel == AUDIO_KERNEL_FLOAT) outputFloat(buffer, count);
+  else outputFixed(buffer, count);
+
+  // Next block ramps from exactly where this one ended
+  engineState.render_rate = engineState.rate;
+  engineState.render_gain = engineState.gain;
+}
+
+// Render PCM samples into buffer
+void audioEngine_renderSamples(int16_t* buffer, size_t count) {
+  uint32_t start_cycles = ESP.getCycleCount();
+
+  // If muted (or no sample loaded), the engine loop is silent; its ramps hold at the targets
+  bool engine_on = !engineState.muted && engineState.layer_count > 0;
+  if (!engine_on) {
+    engineState.render_rate = engineState.rate;
+    engineState.render_gain = engineState.gain;
+    for (int l = 0; l < engineState.layer_count; l++) {
+      engineState.layers[l].render_weight = engineState.layers[l].weight;
+    }
+    // Nothing else playing either: output silence
+    if (activeVoiceCount() == 0) {
+      for (size_t i = 0; i < count; i++) {
+        buffer[i] = 0;
+      }
+      publishTelemetry(true);
+      return;
+    }
+  }
+  
+  for (size_t done = 0; done < count; ) {
+    size_t n = count - done;
+    if (n > AUDIO_MAX_BLOCK_SAMPLES) n = AUDIO_MAX_BLOCK_SAMPLES;
+    renderBlock(buffer + done, n, engine_on);
+    done += n;
+  }
+
+  // Cycle accounting for /engine-debug headroom reporting
+  if (count > 0 && !benchRunning) {
+    uint32_t cps = (ESP.getCycleCount() - start_cycles) / count;
+    engineState.cycles_per_sample = cps;
+    if (cps > engineState.cycles_per_sample_peak) {
+      engineState.cycles_per_sample_peak = cps;
+    }
+  }
+  publishTelemetry(true);
+}
+
+// ==================== BENCHMARK ====================
+static uint32_t fnv1a(uint32_t hash, const int16_t* data, size_t count) {
+  const uint8_t* bytes = (const uint8_t*)data;
+  for (size_t i = 0; i < count * sizeof(int16_t); i++) {
+    hash ^= bytes[i];
+    hash *= 16777619u;
+  }
+  return hash;
+}
+
+static inline void benchAdvanceClock() {
+  benchNowUs += (uint32_t)(ENGINE_BENCH_BLOCK * 1000000ULL / engineState.sample_rate);
+}
+
+// Same starting point for every script: idle, loops at their start, fade-in pending
+static void benchReset() {
+  benchNowUs = 0;
+  engineState.last_update_us = 0;
+  engineState.smoothed_throttle = 0.0f;
+  engineState.prev_throttle = 0.0f;
+  engineState.rev_timer_ms = 0.0f;
+  engineState.muted = false;
+  engineState.startup_fade_remaining = startupFadeLength();
+  for (int l = 0; l < engineState.layer_count; l++) {
+    engineState.layers[l].position = 0.0f;
+    engineState.layers[l].phase_index = 0;
+    engineState.layers[l].phase_frac = 0;
+  }
+  for (int i = 0; i < ENGINE_MAX_VOICES; i++) {
+    engineState.voices[i].sample_index = -1;
+  }
+  audioEngine_updateThrottle(0.0f);
+  engineState.render_rate = engineState.rate;
+  engineState.render_gain = engineState.gain;
+  for (int l = 0; l < engineState.layer_count; l++) {
+    engineState.layers[l].render_weight = engineState.layers[l].weight;
+  }
+}
+
+// One scripted block: clock, throttle, render, fold into the hash
+static void benchBlock(float throttle, int16_t* buffer, uint32_t* hash, uint16_t* peak) {
+  benchAdvanceClock();
+  audioEngine_updateThrottle(throttle);
+  audioEngine_renderSamples(buffer, ENGINE_BENCH_BLOCK);
+  *hash = fnv1a(*hash, buffer, ENGINE_BENCH_BLOCK);
+  for (int i = 0; peak && i < ENGINE_BENCH_BLOCK; i++) {
+    uint16_t a = buffer[i] < 0 ? -(int32_t)buffer[i] : buffer[i];
+    if (a > *peak) *peak = a;
+  }
+}
+
+void audioEngine_requestBenchmark() {
+  benchRequested.store(true, std::memory_order_relaxed);
+}
+
+bool audioEngine_benchmarkPending() {
+  return benchRequested.load(std::memory_order_relaxed);
+}
+
+void audioEngine_runBenchmark() {
+  benchRequested.store(false, std::memory_order_relaxed);
+  uint32_t wall_start = millis();
+  static EngineAudioState saved;   // Off the audio task stack
+  saved = engineState;
+  benchRunning = true;
+
+  int16_t buffer[ENGINE_BENCH_BLOCK];
+  EngineBenchResult r = {};
+  r.run = benchResult.run + 1;
+  r.cpu_mhz = getCpuFrequencyMhz();
+  r.layer_count = engineState.layer_count;
+  r.sample_rate = engineState.sample_rate;
+  const uint32_t blocks_per_second = engineState.sample_rate / ENGINE_BENCH_BLOCK;
+  const uint32_t timed_blocks = blocks_per_second * ENGINE_BENCH_RENDER_MS / 1000;
+
+  // Render cost at steady throttle (settled for 1 s first, so the rate is the plateau)
+  for (int p = 0; p < ENGINE_BENCH_POINTS; p++) {
+    float throttle = (float)p / (ENGINE_BENCH_POINTS - 1);
+    benchReset();
+    for (uint32_t b = 0; b < blocks_per_second; b++) {
+      benchAdvanceClock();
+      audioEngine_updateThrottle(throttle);
+    }
+    engineState.render_rate = engineState.rate;
+    engineState.render_gain = engineState.gain;
+    uint64_t cycles = 0;
+    for (uint32_t b = 0; b < timed_blocks; b++) {
+      benchAdvanceClock();
+      audioEngine_updateThrottle(throttle);
+      uint32_t start = ESP.getCycleCount();
+      audioEngine_renderSamples(buffer, ENGINE_BENCH_BLOCK);
+      cycles += ESP.getCycleCount() - start;
+    }
+    r.throttle[p] = throttle;
+    r.rate[p] = engineState.rate;
+    r.ns_per_sample[p] = (uint32_t)(cycles * 1000 / ((uint64_t)r.cpu_mhz * timed_blocks * ENGINE_BENCH_BLOCK));
+  }
+
+  // Control path cost (smoothing, rev detection, layer weights)
+  benchReset();
+  uint32_t start = ESP.getCycleCount();
+  for (int i = 0; i < ENGINE_BENCH_UPDATES; i++) {
+    benchAdvanceClock();
+    audioEngine_updateThrottle((i % 100) / 100.0f);
+  }
+  r.ns_per_update = (uint32_t)((uint64_t)(ESP.getCycleCount() - start) * 1000 / ((uint64_t)r.cpu_mhz * ENGINE_BENCH_UPDATES));
+
+  // Golden-output scripts
+  benchReset();
+  r.sweep_hash = 2166136261u;
+  for (uint32_t b = 0; b < 2 * blocks_per_second; b++) {
+    benchBlock((float)b / (2 * blocks_per_second - 1), buffer, &r.sweep_hash, &r.sweep_peak);
+  }
+  benchReset();
+  r.rev_hash = 2166136261u;
+  for (uint32_t b = 0; b < 2 * blocks_per_second; b++) {
+    float throttle = b < blocks_per_second / 2 ? 0.1f : (b < blocks_per_second ? 0.9f : 0.2f);
+    benchBlock(throttle, buffer, &r.rev_hash, NULL);
+  }
+
+  engineState = saved;
+  engineState.last_update_us = micros();  // The pause is not one giant smoothing step
+  benchRunning = false;
+  r.duration_ms = millis() - wall_start;
+
+  uint32_t seq = benchSeq.load(std::memory_order_relaxed);
+  benchSeq.store(seq + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  benchResult = r;
+  benchSeq.store(seq + 2, std::memory_order_release);
+
+  Serial.printf("Engine benchmark #%lu (%s kernel, %u layers): %lu/%lu/%lu ns/sample, %lu ns/update, "
+                "sweep 0x%08lx, rev 0x%08lx, %lu ms\n",
+                (unsigned long)r.run, audioEngine_getKernelName(), r.layer_count,
+                (unsigned long)r.ns_per_sample[0], (unsigned long)r.ns_per_sample[1],
+                (unsigned long)r.ns_per_sample[2], (unsigned long)r.ns_per_update,
+                (unsigned long)r.sweep_hash, (unsigned long)r.rev_hash, (unsigned long)r.duration_ms);
+}
+
+bool audioEngine_getBenchmark(EngineBenchResult* out) {
+  for (;;) {
+    uint32_t before = benchSeq.load(std::memory_order_acquire);
+    if (before & 1) continue;  // Writer mid-update
+    *out = benchResult;
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (benchSeq.load(std::memory_order_relaxed) == before) return out->run > 0;
+  }
+}
@@ -0,0 +1,240 @@
+// audio_engine.h
+// Real-time engine audio sampler with throttle-driven pitch and volume control
+// Uses FFT-filtered PCM (offline processing) for click-free looping
+// Loop samples are read in place from the flash engine bank (engine_bank.h)
+// With RPM layers in the bank, the two nearest layers are crossfaded by throttle,
+// each played close to its recorded pitch; otherwise a single loop is resampled
+// One-shot effects (horn, bell) from the same bank are mixed over the engine
+// before the soft clip, so they share the I2S amplifier
+
+#ifndef AUDIO_ENGINE_H
+#define AUDIO_ENGINE_H
+
+#include <stdint.h>
+#include <cstddef>
+#include <atomic>
+#include "engine_bank.h"
+
+// Tuning parameters
+#define THROTTLE_SMOOTH_TAU_MS  71.0f   // Smoothing time constant (same feel as the old 0.15 alpha at 11.6 ms updates)
+#define REV_SMOOTH_TAU_MS       27.0f   // Faster time constant during rev (old 0.35 alpha at 11.6 ms updates)
+#define RATE_MIN                0.8f    // Minimum playback rate (pitch at idle)
+#define RATE_MAX                1.5f    // Maximum playback rate (pitch at full throttle)
+#define GAIN_MIN                0.55f   // Minimum gain (volume at idle) - adequate presence without over-stressing speaker
+#define GAIN_MAX                0.8f    // Maximum gain (volume at full throttle) - slightly reduced to prevent speaker rattle
+#define REV_BOOST_RATE          1.25f   // Rate multiplier during rev (25% boost)
+#define REV_BOOST_GAIN          1.4f    // Gain multiplier during rev (40% boost)
+#define REV_RAMP_MS             150     // Rev ramp-in time (milliseconds)
+#define REV_DECAY_MS            400     // Rev transient decay time (milliseconds)
+#define REV_THRESHOLD           0.15f   // Throttle delta to trigger rev transient
+#define START_FADE_MS           10      // Startup fade-in to prevent initial pop
+
+// Output rates (the I2S rate, passed to audioEngine_init). Render cost and asset size
+// scale with the rate; the filtered rumble through the MAX98357A speaker has little
+// content above a few kHz, so 22.05 kHz halves both without an audible loss.
+// Bank samples recorded at another rate still play at the right pitch (the ratio is
+// folded into the playback rate), but build the bank at the output rate to get the savings
+#define AUDIO_RATE_FULL         44100
+#define AUDIO_RATE_HALF         22050
+#define AUDIO_RATE_LOW          16000
+#define AUDIO_RATE_MIN          8000    // audioEngine_init rejects rates outside MIN..MAX
+#define AUDIO_RATE_MAX          48000
+
+// Render kernels (both built in; AUDIO_RENDER_KERNEL is the one used at boot,
+// audioEngine_setKernel switches between blocks for A/B listening and profiling)
+//   AUDIO_KERNEL_FLOAT: reference path (float lerp + tanh soft clip per sample)
+//   AUDIO_KERNEL_FIXED: Q16.16 phase accumulator, integer lerp/gain, soft-clip lookup table
+#define AUDIO_KERNEL_FLOAT      0
+#define AUDIO_KERNEL_FIXED      1
+#ifndef AUDIO_RENDER_KERNEL
+#define AUDIO_RENDER_KERNEL     AUDIO_KERNEL_FIXED
+#endif
+
+#define SOFT_CLIP_LUT_BITS      9       // 512 table segments over 0..2x full scale (linear between entries)
+
+#define ENGINE_MAX_LAYERS       4       // RPM layers crossfaded by throttle
+#define ENGINE_MAX_VOICES       4       // One-shot effects playing at once (oldest is replaced)
+#define AUDIO_MAX_BLOCK_SAMPLES 256     // Longest block rendered in one pass (longer requests are split)
+#define ENGINE_CMD_QUEUE_SIZE   16      // Control command slots (power of two)
+
+// One playing loop: the single engine loop, or one RPM layer
+typedef struct {
+  const void* pcm_data;     // Sample data (mapped flash)
+  uint32_t pcm_length;      // Length in samples
+  uint8_t pcm_format;       // ENGINE_FORMAT_*
+  int sample_index;         // Bank index
+  float throttle_point;     // Throttle where this layer is fully on (layers only)
+  float nominal_rate;       // Engine rate the layer was recorded at (layer plays at rate / nominal_rate)
+  float rate_scale;         // Sample rate / output rate (1.0 when the bank matches the I2S rate)
+  float weight;             // Target crossfade weight, set by updateThrottle
+  float render_weight;      // Weight reached at the end of the last rendered block
+  float position;           // Float kernel: fractional sample position
+  uint32_t phase_index;     // Fixed kernel: integer sample index
+  uint32_t phase_frac;      // Fixed kernel: Q16 fractional position (0..65535)
+} EngineLayer;
+
+// One-shot effect voice: plays an ENGINE_KIND_ONESHOT sample once at its recorded pitch
+typedef struct {
+  const void* pcm_data;     // Sample data (mapped flash)
+  uint32_t pcm_length;      // Length in samples
+  uint8_t pcm_format;       // ENGINE_FORMAT_*
+  int sample_index;         // Bank index (-1 = voice idle)
+  uint32_t position;        // Next sample to mix
+  float gain;               // Fixed for the whole effect
+} EngineVoice;
+
+// Audio engine state
+typedef struct {
+  float rate;               // Target playback rate (1.0 = normal pitch), set by updateThrottle
+  float gain;               // Target volume multiplier, set by updateThrottle
+  float render_rate;        // Rate reached at the end of the last rendered block (ramp start)
+  float render_gain;        // Gain reached at the end of the last rendered block (ramp start)
+  float smoothed_throttle;  // Low-pass filtered throttle value
+  float prev_throttle;      // Previous throttle for derivative calculation
+  float rev_timer_ms;       // Milliseconds remaining in rev transient
+  uint32_t last_update_us;  // Timestamp of last update (for decay and smoothing)
+  uint32_t sample_rate;     // Output rate in Hz (set by audioEngine_init)
+  uint32_t startup_fade_remaining; // Samples remaining in startup fade
+  EngineLayer layers[ENGINE_MAX_LAYERS]; // Sorted by throttle_point
+  uint8_t layer_count;      // 0 = nothing loaded, 1 = single loop, 2+ = RPM crossfade
+  EngineVoice voices[ENGINE_MAX_VOICES];
+  uint32_t cycles_per_sample;      // CPU cycles per sample for the last rendered block
+  uint32_t cycles_per_sample_peak; // Worst block since boot
+  bool muted;               // Mute flag (true = engine loop silent, effects still play)
+} EngineAudioState;
+
+// Global engine state - owned by the audio task once it is running.
+// Other tasks post control changes and read EngineTelemetry snapshots instead.
+extern EngineAudioState engineState;
+
+// ==================== CONTROL / TELEMETRY HANDOFF ====================
+// Control changes go into a lock-free bounded queue (any number of producers, the
+// audio task is the only consumer) and are applied at the start of each block.
+// Throttle is a latest-value atomic. Once per block the audio task publishes an
+// EngineTelemetry snapshot under a sequence lock; readers retry on a torn copy and
+// never block the audio task.
+
+typedef enum {
+  ENGINE_CMD_MUTE = 1,      // arg: 1 = mute, 0 = unmute
+  ENGINE_CMD_PLAY_VOICE,    // arg: bank index of a one-shot, level: gain in percent
+  ENGINE_CMD_STOP_VOICES,   // Silence every playing effect
+  ENGINE_CMD_SET_KERNEL,    // arg: AUDIO_KERNEL_* (playback continues from the same position)
+} EngineCommandType;
+
+typedef struct {
+  uint8_t type;             // EngineCommandType
+  uint8_t level;            // PLAY_VOICE: 0-100 %
+  int32_t arg;
+} EngineCommand;
+
+// Consistent view of the engine, published by the audio task once per block
+typedef struct {
+  float throttle_input;     // Last posted throttle (0.0-1.0)
+  float smoothed_throttle;
+  float rate;
+  float gain;
+  bool rev_active;
+  bool muted;
+  uint8_t layer_count;
+  uint8_t voices_active;    // One-shot effects currently playing
+  int sample_index;
+  uint32_t cycles_per_sample;
+  uint32_t cycles_per_sample_peak;
+  uint32_t blocks_rendered;
+  uint32_t sample_rate;     // Output rate in Hz
+  uint32_t commands_dropped; // Posts rejected because the queue was full
+} EngineTelemetry;
+
+// Initialize audio engine (maps the engine bank, loads RPM layers or the "engine" loop)
+// sample_rate: output (I2S) rate in Hz, AUDIO_RATE_FULL if out of range
+void audioEngine_init(uint32_t sample_rate);
+
+// Play a single bank sample as the engine loop (index from engineBank_find)
+bool audioEngine_setSample(int index);
+
+// Load every ENGINE_KIND_LAYER sample from the bank (returns false if fewer than 2)
+bool audioEngine_loadLayers();
+
+// Post the latest throttle (any task; picked up by the next block)
+// throttle_normalized: 0.0 = idle, 1.0 = full throttle
+void audioEngine_postThrottle(float throttle_normalized);
+
+// Same, from an ISR: integer only (no FPU in interrupt context), 65536 = full throttle
+void audioEngine_postThrottleQ16(uint32_t throttle_q16);
+
+// Post a control command (any task). Returns false if the queue is full.
+bool audioEngine_postCommand(const EngineCommand& cmd);
+
+// Audio task: apply queued commands and the posted throttle (once per block, before rendering)
+void audioEngine_processControl();
+
+// Update throttle and recalculate rate/gain (audio task, or directly when no task is running)
+// throttle_normalized: 0.0 = idle, 1.0 = full throttle
+void audioEngine_updateThrottle(float throttle_normalized);
+
+// Render PCM samples into buffer (audio task) and publish the telemetry snapshot
+// Rate and gain ramp linearly from the previous block's values to the current targets
+// buffer: output buffer (16-bit signed mono)
+// count: number of samples to render
+void audioEngine_renderSamples(int16_t* buffer, size_t count);
+
+// One-shot effects (any task; queued, starts on the next block)
+// Bank index of the ENGINE_KIND_ONESHOT sample with this name, -1 if the bank has none
+int audioEngine_findVoice(const char* name);
+// Start (or restart, if it is already playing) a one-shot at level percent
+bool audioEngine_playVoice(int index, uint8_t level_percent);
+bool audioEngine_stopVoices();
+
+// Mute control (any task; queued, takes effect on the next block)
+bool audioEngine_setMuted(bool muted);
+bool audioEngine_getMuted();  // From the last published snapshot
+
+// Copy the last published snapshot (any task, never blocks the audio task)
+void audioEngine_getTelemetry(EngineTelemetry* out);
+
+// ==================== BENCHMARK ====================
+// On-target render benchmark and golden-output check, run by the audio task between two
+// blocks (output pauses for ~1-2 s). Engine state is saved and restored around it. The
+// scripts run on a simulated clock (one block = ENGINE_BENCH_BLOCK samples at the output
+// rate), so the output hashes depend only on the bank, the output rate, the kernel and
+// the engine code. Compare them across builds with the same bank and rate: a kernel
+// optimization that changes the sound changes the hash.
+// host/ renders a similar throttle script in a ctest against golden WAVs with an error
+// budget (host floats differ from the ESP32's, so on-target hashes are compared with each
+// other, never with the host).
+#define ENGINE_BENCH_BLOCK        128     // Samples per scripted block
+#define ENGINE_BENCH_POINTS       3       // Render timing at idle, half and full throttle
+#define ENGINE_BENCH_RENDER_MS    500     // Audio rendered per timing point
+#define ENGINE_BENCH_UPDATES      1000    // audioEngine_updateThrottle calls timed
+
+typedef struct {
+  uint32_t run;                             // Completed runs since boot (0 = none yet)
+  uint32_t duration_ms;                     // Wall time the output was paused
+  uint32_t cpu_mhz;
+  uint8_t layer_count;                      // What was loaded (hashes only compare like with like)
+  uint32_t sample_rate;                     // Output rate the scripts ran at
+  float throttle[ENGINE_BENCH_POINTS];
+  float rate[ENGINE_BENCH_POINTS];          // Settled playback rate at that throttle
+  uint32_t ns_per_sample[ENGINE_BENCH_POINTS];
+  uint32_t ns_per_update;
+  uint32_t sweep_hash;                      // FNV-1a of the 0 -> 1 throttle sweep output (2 s)
+  uint32_t rev_hash;                        // ... of idle / snap to 0.9 (rev) / back to 0.2 (2 s)
+  uint16_t sweep_peak;                      // Largest |sample| in the sweep (silent = 0)
+} EngineBenchResult;
+
+// Any task: ask the audio task to run the benchmark before its next block
+void audioEngine_requestBenchmark();
+bool audioEngine_benchmarkPending();
+
+// Audio task: run it now (call between blocks, with the I2S output suspended)
+void audioEngine_runBenchmark();
+
+// Last completed run (false until the first one)
+bool audioEngine_getBenchmark(EngineBenchResult* out);
+
+// Render kernel (any task; queued, takes effect on the next block, resets the cycle peak)
+bool audioEngine_setKernel(uint8_t kernel);
+uint8_t audioEngine_getKernel();
+const char* audioEngine_getKernelName();
+
+#endif // AUDIO_ENGINE_H
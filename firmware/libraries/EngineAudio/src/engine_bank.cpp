@@ -0,0 +1,171 @@
+// engine_bank.cpp
+// Engine sample bank: maps the "engine" flash partition and resolves named samples
+// Reads go through the flash cache, so samples are used in place with no RAM copy
+
+#include "engine_bank.h"
+#include <Arduino.h>
+#include <string.h>
+
+#if ENGINE_PCM_EMBEDDED
+#include "engine_pcm.h"  // FFT-filtered PCM data compiled into the image
+#ifndef ENGINE_PCM_FORMAT
+#define ENGINE_PCM_FORMAT ENGINE_FORMAT_PCM16  // Headers from before generate_pcm_header.py --ulaw
+#endif
+#else
+#include "esp_partition.h"
+#endif
+
+// G.711 mu-law decode table (index = encoded byte)
+const int16_t ENGINE_ULAW_TABLE[256] = {
+  -32124, -31100, -30076, -29052, -28028, -27004, -25980, -24956, -23932, -22908, -21884, -20860,
+  -19836, -18812, -17788, -16764, -15996, -15484, -14972, -14460, -13948, -13436, -12924, -12412,
+  -11900, -11388, -10876, -10364,  -9852,  -9340,  -8828,  -8316,  -7932,  -7676,  -7420,  -7164,
+   -6908,  -6652,  -6396,  -6140,  -5884,  -5628,  -5372,  -5116,  -4860,  -4604,  -4348,  -4092,
+   -3900,  -3772,  -3644,  -3516,  -3388,  -3260,  -3132,  -3004,  -2876,  -2748,  -2620,  -2492,
+   -2364,  -2236,  -2108,  -1980,  -1884,  -1820,  -1756,  -1692,  -1628,  -1564,  -1500,  -1436,
+   -1372,  -1308,  -1244,  -1180,  -1116,  -1052,   -988,   -924,   -876,   -844,   -812,   -780,
+    -748,   -716,   -684,   -652,   -620,   -588,   -556,   -524,   -492,   -460,   -428,   -396,
+    -372,   -356,   -340,   -324,   -308,   -292,   -276,   -260,   -244,   -228,   -212,   -196,
+    -180,   -164,   -148,   -132,   -120,   -112,   -104,    -96,    -88,    -80,    -72,    -64,
+     -56,    -48,    -40,    -32,    -24,    -16,     -8,      0,  32124,  31100,  30076,  29052,
+   28028,  27004,  25980,  24956,  23932,  22908,  21884,  20860,  19836,  18812,  17788,  16764,
+   15996,  15484,  14972,  14460,  13948,  13436,  12924,  12412,  11900,  11388,  10876,  10364,
+    9852,   9340,   8828,   8316,   7932,   7676,   7420,   7164,   6908,   6652,   6396,   6140,
+    5884,   5628,   5372,   5116,   4860,   4604,   4348,   4092,   3900,   3772,   3644,   3516,
+    3388,   3260,   3132,   3004,   2876,   2748,   2620,   2492,   2364,   2236,   2108,   1980,
+    1884,   1820,   1756,   1692,   1628,   1564,   1500,   1436,   1372,   1308,   1244,   1180,
+    1116,   1052,    988,    924,    876,    844,    812,    780,    748,    716,    684,    652,
+     620,    588,    556,    524,    492,    460,    428,    396,    372,    356,    340,    324,
+     308,    292,    276,    260,    244,    228,    212,    196,    180,    164,    148,    132,
+     120,    112,    104,     96,     88,     80,     72,     64,     56,     48,     40,     32,
+      24,     16,      8,      0
+};
+
+static const char* bankSource = "none";
+
+#if ENGINE_PCM_EMBEDDED
+static EngineSample embeddedSample = {
+  "engine", ENGINE_PCM_DATA, ENGINE_PCM_LENGTH, ENGINE_PCM_SAMPLE_RATE, ENGINE_PCM_FORMAT,
+  ENGINE_KIND_LOOP, 0.0f
+};
+#else
+static const EngineBankHeader* bankHeader = NULL;
+static const EngineBankEntry* bankEntries = NULL;
+static esp_partition_mmap_handle_t bankMapHandle;
+#endif
+
+bool engineBank_init() {
+#if ENGINE_PCM_EMBEDDED
+  bankSource = "embedded";
+  Serial.println("Engine bank: using embedded engine_pcm.h");
+  return true;
+#else
+  const esp_partition_t* part = esp_partition_find_first(
+    ESP_PARTITION_TYPE_DATA, (esp_partition_subtype_t)ENGINE_BANK_SUBTYPE, ENGINE_BANK_PARTITION);
+  if (!part) {
+    Serial.println("ERROR: Engine bank partition not found (flash with partitions.csv)");
+    return false;
+  }
+
+  // Map the header first to learn the bank size
+  const void* ptr = NULL;
+  esp_err_t err = esp_partition_mmap(part, 0, sizeof(EngineBankHeader),
+                                     ESP_PARTITION_MMAP_DATA, &ptr, &bankMapHandle);
+  if (err != ESP_OK) {
+    Serial.printf("ERROR: Engine bank mmap failed: %d\n", err);
+    return false;
+  }
+  EngineBankHeader header = *(const EngineBankHeader*)ptr;
+  esp_partition_munmap(bankMapHandle);
+
+  if (header.magic != ENGINE_BANK_MAGIC || header.version != ENGINE_BANK_VERSION) {
+    Serial.printf("ERROR: Engine bank invalid (magic 0x%08lx, version %u) - flash engine_bank.bin\n",
+      (unsigned long)header.magic, header.version);
+    return false;
+  }
+  if (header.entry_count == 0 || header.entry_count > ENGINE_BANK_MAX_ENTRIES ||
+      header.total_size > part->size) {
+    Serial.printf("ERROR: Engine bank header out of range (%u entries, %lu bytes)\n",
+      header.entry_count, (unsigned long)header.total_size);
+    return false;
+  }
+
+  err = esp_partition_mmap(part, 0, header.total_size,
+                           ESP_PARTITION_MMAP_DATA, &ptr, &bankMapHandle);
+  if (err != ESP_OK) {
+    Serial.printf("ERROR: Engine bank mmap (%lu bytes) failed: %d\n",
+      (unsigned long)header.total_size, err);
+    return false;
+  }
+
+  bankHeader = (const EngineBankHeader*)ptr;
+  bankEntries = (const EngineBankEntry*)(bankHeader + 1);
+  bankSource = "partition";
+
+  Serial.printf("Engine bank mapped: %u samples, %lu bytes\n",
+    bankHeader->entry_count, (unsigned long)bankHeader->total_size);
+  for (int i = 0; i < bankHeader->entry_count; i++) {
+    const EngineBankEntry* e = &bankEntries[i];
+    Serial.printf("  [%d] %-.16s %lu samples @ %lu Hz (%s", i, e->name,
+      (unsigned long)e->length, (unsigned long)e->sample_rate,
+      e->format == ENGINE_FORMAT_ULAW ? "mu-law" : "pcm16");
+    if (e->kind == ENGINE_KIND_LAYER) {
+      Serial.printf(", layer @ %.2f throttle", e->throttle_pm / 1000.0f);
+    } else if (e->kind == ENGINE_KIND_ONESHOT) {
+      Serial.print(", one-shot");
+    }
+    Serial.println(")");
+  }
+  return true;
+#endif
+}
+
+int engineBank_count() {
+#if ENGINE_PCM_EMBEDDED
+  return 1;
+#else
+  return bankHeader ? bankHeader->entry_count : 0;
+#endif
+}
+
+bool engineBank_get(int index, EngineSample* out) {
+  if (index < 0 || index >= engineBank_count()) return false;
+#if ENGINE_PCM_EMBEDDED
+  *out = embeddedSample;
+  return true;
+#else
+  const EngineBankEntry* e = &bankEntries[index];
+  uint32_t total = bankHeader->total_size;
+  uint32_t sample_bytes = e->format == ENGINE_FORMAT_ULAW ? 1 : 2;
+  if (e->format > ENGINE_FORMAT_ULAW || e->kind > ENGINE_KIND_ONESHOT || e->length < 2) {
+    return false;
+  }
+  // Bounds checked without 32-bit sums, so a corrupt entry can't wrap past them
+  if (e->length > total / sample_bytes || e->offset > total ||
+      e->length * sample_bytes > total - e->offset) {
+    return false;
+  }
+  out->name = e->name;
+  out->data = (const uint8_t*)bankHeader + e->offset;
+  out->length = e->length;
+  out->sample_rate = e->sample_rate;
+  out->format = e->format;
+  out->kind = e->kind;
+  out->throttle = e->throttle_pm / 1000.0f;
+  return true;
+#endif
+}
+
+int engineBank_find(const char* name) {
+  for (int i = 0; i < engineBank_count(); i++) {
+    EngineSample s;
+    if (engineBank_get(i, &s) && strncmp(s.name, name, ENGINE_BANK_NAME_LEN) == 0) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+const char* engineBank_source() {
+  return bankSource;
+}
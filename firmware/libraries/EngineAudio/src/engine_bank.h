@@ -0,0 +1,79 @@
+// engine_bank.h
+// Flash-resident engine sample bank (dedicated "engine" data partition, memory-mapped)
+// Bank image is built by audio-assets/engine/make_engine_bank.py and flashed separately
+// from the sketch, so OTA uploads no longer carry the PCM data
+
+#ifndef ENGINE_BANK_H
+#define ENGINE_BANK_H
+
+#include <stdint.h>
+#include <cstddef>
+
+// Set to 1 to compile engine_pcm.h into the image instead of reading the partition
+#ifndef ENGINE_PCM_EMBEDDED
+#define ENGINE_PCM_EMBEDDED     0
+#endif
+
+#define ENGINE_BANK_PARTITION   "engine"   // Label in partitions.csv
+#define ENGINE_BANK_SUBTYPE     0x40       // Custom data subtype
+#define ENGINE_BANK_MAGIC       0x4B4E4245 // "EBNK" little-endian
+#define ENGINE_BANK_VERSION     1
+#define ENGINE_BANK_MAX_ENTRIES 16
+#define ENGINE_BANK_NAME_LEN    16
+
+// Sample encodings
+#define ENGINE_FORMAT_PCM16     0          // 16-bit signed little-endian
+#define ENGINE_FORMAT_ULAW      1          // 8-bit G.711 mu-law (decoded through a 256-entry table)
+
+// Sample kinds
+#define ENGINE_KIND_LOOP        0          // Plain loop (resampled across the full rate range)
+#define ENGINE_KIND_LAYER       1          // RPM layer, crossfaded by throttle around throttle_pm
+#define ENGINE_KIND_ONESHOT     2          // Effect (horn, bell) played once over the engine at 1:1 rate
+
+// On-flash layout (little-endian, packed to 4-byte fields)
+typedef struct {
+  uint32_t magic;           // ENGINE_BANK_MAGIC
+  uint16_t version;         // ENGINE_BANK_VERSION
+  uint16_t entry_count;     // Number of EngineBankEntry records following the header
+  uint32_t total_size;      // Bytes from start of header to end of last sample
+  uint32_t reserved;
+} EngineBankHeader;
+
+typedef struct {
+  char name[ENGINE_BANK_NAME_LEN]; // NUL-padded sample name ("engine", ...)
+  uint32_t offset;          // Byte offset of sample data from start of header
+  uint32_t length;          // Number of samples
+  uint32_t sample_rate;     // Hz
+  uint8_t format;           // ENGINE_FORMAT_*
+  uint8_t kind;             // ENGINE_KIND_*
+  uint16_t throttle_pm;     // Layers: throttle point in per-mille (0-1000)
+} EngineBankEntry;
+
+// Resolved sample (data points into mapped flash)
+typedef struct {
+  const char* name;
+  const void* data;         // int16_t* for PCM16, uint8_t* for ULAW
+  uint32_t length;          // Number of samples
+  uint32_t sample_rate;     // Hz
+  uint8_t format;           // ENGINE_FORMAT_*
+  uint8_t kind;             // ENGINE_KIND_*
+  float throttle;           // Layers: throttle point (0.0-1.0)
+} EngineSample;
+
+// Map the bank partition and validate the header (returns false if missing/invalid)
+bool engineBank_init();
+
+// Number of samples in the bank (0 if not initialized)
+int engineBank_count();
+
+// Look up a sample by index or name
+bool engineBank_get(int index, EngineSample* out);
+int engineBank_find(const char* name);  // -1 if not found
+
+// Where the samples came from ("partition", "embedded" or "none")
+const char* engineBank_source();
+
+// mu-law decode table (shared with the render kernels)
+extern const int16_t ENGINE_ULAW_TABLE[256];
+
+#endif // ENGINE_BANK_H
@@ -0,0 +1,41 @@
+#!/usr/bin/env python3
+"""Find the boat telemetry and camera boards with the UDP discovery beacon.
+
+Broadcasts EDMUND_DISCOVER to UDP 4210 and prints each board's JSON reply
+(see firmware/libraries/EdmundNet/src/discovery.h).
+Usage: python3 scripts/discover_boat.py [timeout_s]
+"""
+import json
+import socket
+import sys
+
+PORT = 4210
+PROBE = b"EDMUND_DISCOVER"
+
+
+def discover(timeout=1.0):
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    sock.setsockopt(socket.SOL_SOCKET, socket.SO_BROADCAST, 1)
+    sock.settimeout(timeout)
+    sock.sendto(PROBE, ("255.255.255.255", PORT))
+    found = {}
+    try:
+        while True:
+            data, (addr, _) = sock.recvfrom(512)
+            try:
+                found[addr] = json.loads(data)
+            except ValueError:
+                pass
+    except socket.timeout:
+        pass
+    return found
+
+
+if __name__ == "__main__":
+    timeout = float(sys.argv[1]) if len(sys.argv) > 1 else 1.0
+    boards = discover(timeout)
+    if not boards:
+        print("No boards answered")
+    for addr, info in sorted(boards.items()):
+        print(f"{addr:15}  {info.get('type', '?'):9}  {info.get('name', '')}  v{info.get('version', '?')}"
+              f"  http://{info.get('hostname', addr)}.local:{info.get('port', 80)}")
@@ -0,0 +1,125 @@
+#!/usr/bin/env python3
+"""Push a firmware image to POST /ota on the boat or camera, gzip- or delta-compressed.
+
+Usage:
+  python3 scripts/ota_push.py <host> <new.bin> [--base <running.bin>] [--password P]
+
+The body is the gzip of the image, or with --base the gzip of a delta against the image
+the board is running now (keep the .bin of every release you flash). The smaller of the
+two is sent. The board checks that the delta's base matches its running app (ELF SHA-256)
+and verifies the rebuilt image before booting it.
+Format: firmware/libraries/EdmundNet/src/ota_stream.h.
+"""
+import argparse
+import gzip
+import json
+import struct
+import sys
+import time
+import urllib.error
+import urllib.request
+
+DELTA_MAGIC = b"EDLT"
+DELTA_VERSION = 1
+OP_END, OP_COPY, OP_INSERT = 0, 1, 2
+BLOCK = 32                   # Match granularity: blocks of the base indexed by content
+MIN_COPY = 24                # Shorter matches cost more as a COPY op than as literals
+APP_DESC_SHA_OFFSET = 32 + 144   # esp_image_header + segment header, then esp_app_desc_t.app_elf_sha256
+
+
+def elf_sha256(image):
+    if len(image) < APP_DESC_SHA_OFFSET + 32 or image[0] != 0xE9:
+        sys.exit("ERROR: not an ESP32 app image")
+    return image[APP_DESC_SHA_OFFSET:APP_DESC_SHA_OFFSET + 32]
+
+
+def make_delta(base, target):
+    """Greedy COPY/INSERT delta: base blocks indexed by content, matches extended both ways."""
+    index = {}
+    for offset in range(0, len(base) - BLOCK + 1, BLOCK):
+        index.setdefault(base[offset:offset + BLOCK], offset)
+
+    ops = []
+    literal_start = 0
+    pos = 0
+    while pos + BLOCK <= len(target):
+        src = index.get(target[pos:pos + BLOCK])
+        if src is None:
+            pos += 1
+            continue
+        # Extend backwards into the pending literal, then forwards
+        start, src_start = pos, src
+        while start > literal_start and src_start > 0 and target[start - 1] == base[src_start - 1]:
+            start -= 1
+            src_start -= 1
+        end, src_end = pos + BLOCK, src + BLOCK
+        while end < len(target) and src_end < len(base) and target[end] == base[src_end]:
+            end += 1
+            src_end += 1
+        if end - start < MIN_COPY:
+            pos += 1
+            continue
+        if start > literal_start:
+            ops.append((OP_INSERT, target[literal_start:start]))
+        ops.append((OP_COPY, src_start, end - start))
+        literal_start = pos = end
+    if literal_start < len(target):
+        ops.append((OP_INSERT, target[literal_start:]))
+
+    out = bytearray(DELTA_MAGIC + bytes([DELTA_VERSION, 0, 0, 0]) + elf_sha256(base) + struct.pack("<I", len(target)))
+    copied = 0
+    for op in ops:
+        if op[0] == OP_COPY:
+            out += struct.pack("<BII", OP_COPY, op[1], op[2])
+            copied += op[2]
+        else:
+            out += struct.pack("<BI", OP_INSERT, len(op[1])) + op[1]
+    out.append(OP_END)
+    return bytes(out), copied
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("host", help="Board IP or hostname (edmund-fitzgerald.local, edmund-camera.local)")
+    parser.add_argument("image", help="New app image (.bin from Sketch > Export Compiled Binary)")
+    parser.add_argument("--base", help="Image the board is running now (enables a delta)")
+    parser.add_argument("--password", default="boat2026")
+    parser.add_argument("--port", type=int, default=80)
+    parser.add_argument("--dry-run", action="store_true", help="Build the payload and print its size only")
+    args = parser.parse_args()
+
+    with open(args.image, "rb") as f:
+        image = f.read()
+    elf_sha256(image)
+    body = gzip.compress(image, 9)
+    kind = "gzip"
+    print(f"Image {len(image)} bytes, gzip {len(body)} bytes")
+
+    if args.base:
+        with open(args.base, "rb") as f:
+            base = f.read()
+        delta, copied = make_delta(base, image)
+        delta_gz = gzip.compress(delta, 9)
+        print(f"Delta {len(delta)} bytes ({copied} copied from base), gzip {len(delta_gz)} bytes")
+        if len(delta_gz) < len(body):
+            body, kind = delta_gz, "delta+gzip"
+
+    print(f"Sending {kind}: {len(body)} bytes ({100 * len(body) / len(image):.0f}% of the image)")
+    if args.dry_run:
+        return
+
+    request = urllib.request.Request(
+        f"http://{args.host}:{args.port}/ota", data=body, method="POST",
+        headers={"Content-Type": "application/octet-stream", "X-OTA-Password": args.password})
+    start = time.time()
+    try:
+        with urllib.request.urlopen(request, timeout=300) as response:
+            result = json.loads(response.read())
+    except urllib.error.HTTPError as e:
+        result = json.loads(e.read() or b"{}")
+    print(f"{time.time() - start:.1f} s: {json.dumps(result)}")
+    sys.exit(0 if result.get("ok") else 1)
+
+
+if __name__ == "__main__":
+    main()